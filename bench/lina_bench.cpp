@@ -0,0 +1,965 @@
+/*
+
+###################
+    lina_bench
+###################
+Times every operation in lina and optionally compares the results against a
+stored baseline, so you can tell if a new version of the headers made your
+workload faster or slower.
+
+    lina_bench [--filter <text>] [--min-time <ms>] [--json <file>]
+               [--baseline <file>] [--threshold <percent>] [--list]
+
+    --filter:    only run the benchmarks whose name contains <text>.
+    --min-time:  how long each benchmark runs for, 50ms by default.
+    --json:      writes the results to <file>, this is also the baseline format.
+    --baseline:  compares the results against an earlier --json file and
+                 prints every benchmark that got slower by more than
+                 --threshold percent (10 by default). The exit code is 1 if
+                 there were any regressions.
+    --list:      prints the benchmark names without running them.
+
+Every benchmark works on an array of 1024 inputs and reports the time per
+element in nanoseconds. Most operations come in two forms:
+    single: one element at a time with a compiler barrier after each one, so
+            the compiler can't vectorize the loop. This is what calling the
+            operation on its own costs.
+    batch:  a plain loop over the whole array that the compiler is free to
+            vectorize, or the bulk function from lina_stream.hpp /
+            lina_batch.hpp / lina_cull.hpp / lina_pack.hpp / lina_view.hpp /
+            lina_solve.hpp / lina_bounds.hpp where there is one.
+
+The 'alloc' benchmarks fill a temporary array of mat4s the size of the inputs
+every run, to compare the heap with the allocators in lina_alloc.hpp.
+
+The 'file' benchmarks write a table file (see lina_file.hpp) to the working
+directory and delete it at the end.
+
+The 'scaling' benchmarks run a few bulk functions on 1M elements with 1, 2, 4,
+... threads (see lina_task.hpp) and print the speedup and the efficiency of
+every thread count at the end:
+    lina_bench --filter scaling/
+
+The 'chain' benchmarks time a long expression, build lina_bench_expr (the same
+benchmarks with LINA_EXPR defined) and compare the two to see what the
+expression templates buy you:
+    lina_bench --filter chain --json plain.json
+    lina_bench_expr --filter chain --baseline plain.json
+
+Each benchmark is run 5 times and the fastest run is reported (and used for
+the baseline comparison), since that's the one with the least noise in it.
+
+*/
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_batch.hpp"
+#include "lina_cull.hpp"
+#include "lina_hierarchy.hpp"
+#include "lina_pack.hpp"
+#include "lina_alloc.hpp"
+#include "lina_skin.hpp"
+#include "lina_view.hpp"
+#include "lina_file.hpp"
+#include "lina_snapshot.hpp"
+#include "lina_solve.hpp"
+#include "lina_bounds.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define LINA_BENCH_CLOBBER() _ReadWriteBarrier()
+#else
+    #define LINA_BENCH_CLOBBER() asm volatile("" ::: "memory")
+#endif
+
+using namespace lina;
+
+namespace {
+    enum { items = 1024, samples = 5 };
+
+    struct Bench {
+        std::string name;
+        std::function<void()> run;
+    };
+
+    std::vector<Bench>& registry() {
+        static std::vector<Bench> r;
+        return r;
+    }
+
+    void bench(const std::string& name, std::function<void()> run) {
+        registry().push_back({name, run});
+    }
+
+    // Random inputs, kept away from 0 so divisions and normalizations are fine for every type.
+    unsigned rng_state = 12345;
+    unsigned rng() {
+        rng_state = rng_state * 1664525u + 1013904223u;
+        return rng_state >> 8;
+    }
+    template <typename T> T value() { return (T)(1 + rng() % 100); }
+    template <> float value<float>() { return 0.5f + (float)(rng() % 10000) / 1000.f; }
+
+    template <typename T> Vector2<T> make(Vector2<T>*) { return Vector2<T>(value<T>(), value<T>()); }
+    template <typename T> Vector3<T> make(Vector3<T>*) { return Vector3<T>(value<T>(), value<T>(), value<T>()); }
+    template <typename T> Vector4<T> make(Vector4<T>*) { return Vector4<T>(value<T>(), value<T>(), value<T>(), value<T>()); }
+    float make(float*) { return value<float>(); }
+    quat make(quat*) { return quat::fromEuler(vec3(value<float>(), value<float>(), value<float>())); }
+    mat2 make(mat2*) { return mat2(value<float>(), value<float>(), value<float>(), value<float>() + 20.f); }
+    mat3 make(mat3*) {
+        return mat3::rotation(make((vec3*)nullptr)) * mat3::scalation(make((vec3*)nullptr));
+    }
+    mat4 make(mat4*) {
+        return CreateRMModelMatrix(make((vec3*)nullptr), make((quat*)nullptr), vec4(value<float>(), value<float>(), value<float>(), 1.f));
+    }
+    affine3 make(affine3*) { return affine3::fromMat4(make((mat4*)nullptr)); }
+    cmat4 make(cmat4*) { return cmat4(make((mat4*)nullptr)); }
+    Transform make(Transform*) {
+        float s = value<float>();
+        return Transform(make((vec3*)nullptr), make((quat*)nullptr), vec3(s, s, s));
+    }
+
+    // One array of random inputs per type, shared by every benchmark.
+    template <typename V>
+    const std::vector<V>& inputs(int which) {
+        static std::vector<V> a, b;
+        std::vector<V>& r = which ? b : a;
+        if (r.empty())
+            for (int i = 0; i < items; i++) r.push_back(make((V*)nullptr));
+        return r;
+    }
+
+    template <typename V>
+    std::vector<V>& outputs() {
+        static std::vector<V> r(items);
+        return r;
+    }
+
+    // Registers the single and batch forms of out[i] = f(a[i]).
+    template <typename A, typename R, typename F>
+    void unary(const std::string& name, F f) {
+        const A* a = inputs<A>(0).data();
+        R* out = outputs<R>().data();
+        bench(name + "/single", [=]() {
+            for (int i = 0; i < items; i++) {
+                out[i] = f(a[i]);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench(name + "/batch", [=]() {
+            for (int i = 0; i < items; i++) out[i] = f(a[i]);
+            LINA_BENCH_CLOBBER();
+        });
+    }
+
+    // Registers the single and batch forms of out[i] = f(a[i], b[i]).
+    template <typename A, typename B, typename R, typename F>
+    void binary(const std::string& name, F f) {
+        const A* a = inputs<A>(0).data();
+        const B* b = inputs<B>(1).data();
+        R* out = outputs<R>().data();
+        bench(name + "/single", [=]() {
+            for (int i = 0; i < items; i++) {
+                out[i] = f(a[i], b[i]);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench(name + "/batch", [=]() {
+            for (int i = 0; i < items; i++) out[i] = f(a[i], b[i]);
+            LINA_BENCH_CLOBBER();
+        });
+    }
+
+    template <typename V>
+    void vectorCommon(const std::string& n) {
+        typedef decltype(V().x) T;
+        binary<V, V, V>(n + "/add", [](V a, V b) -> V { return a + b; });
+        binary<V, V, V>(n + "/sub", [](V a, V b) -> V { return a - b; });
+        binary<V, V, V>(n + "/mul", [](V a, V b) -> V { return a * b; });
+        binary<V, V, V>(n + "/div", [](V a, V b) -> V { return a / b; });
+        unary<V, V>(n + "/add_scalar", [](V a) -> V { return a + (T)3; });
+        unary<V, V>(n + "/mul_scalar", [](V a) -> V { return a * (T)3; });
+        unary<V, V>(n + "/div_scalar", [](V a) -> V { return a / (T)3; });
+        unary<V, V>(n + "/neg", [](V a) { return -a; });
+        binary<V, V, V>(n + "/add_assign", [](V a, V b) { a += b; return a; });
+        binary<V, V, V>(n + "/mul_assign", [](V a, V b) { a *= b; return a; });
+        binary<V, V, float>(n + "/eq", [](V a, V b) { return a == b ? 1.f : 0.f; });
+        binary<V, V, float>(n + "/dot", [](V a, V b) { return a.dot(b); });
+        unary<V, float>(n + "/length", [](V a) { return a.length(); });
+        unary<V, V>(n + "/normalized", [](V a) { return a.normalized(); });
+    }
+
+    template <typename T>
+    void vectors(const std::string& t) {
+        vectorCommon<Vector2<T>>("Vector2<" + t + ">");
+        vectorCommon<Vector3<T>>("Vector3<" + t + ">");
+        vectorCommon<Vector4<T>>("Vector4<" + t + ">");
+        binary<Vector3<T>, Vector3<T>, Vector3<T>>("Vector3<" + t + ">/cross", [](Vector3<T> a, Vector3<T> b) { return a.cross(b); });
+    }
+
+    // The fast precision policy next to the precise versions above.
+    template <typename V>
+    void vectorFast(const std::string& n) {
+        unary<V, float>(n + "/length<fast>", [](V a) { return a.template length<fast>(); });
+        unary<V, V>(n + "/normalized<fast>", [](V a) { return a.template normalized<fast>(); });
+    }
+
+    void matrices() {
+        binary<mat4, mat4, mat4>("mat4/mul", [](const mat4& a, const mat4& b) { return a * b; });
+        binary<mat4, mat4, mat4>("mat4/mul_assign", [](mat4 a, const mat4& b) { a *= b; return a; });
+        binary<mat4, vec4, vec4>("mat4/mul_vec4", [](const mat4& a, vec4 v) { return a * v; });
+        binary<mat4, mat4, mat4>("mat4/add", [](const mat4& a, const mat4& b) { return a + b; });
+        binary<mat4, mat4, mat4>("mat4/sub", [](const mat4& a, const mat4& b) { return a - b; });
+        binary<mat4, vec4, mat4>("mat4/add_vec4", [](const mat4& a, vec4 v) { return a + v; });
+        binary<mat4, mat4, float>("mat4/eq", [](const mat4& a, const mat4& b) { return a == b ? 1.f : 0.f; });
+        unary<mat4, mat4>("mat4/transposed", [](const mat4& a) { return a.transposed(); });
+        unary<mat4, float>("mat4/determinant", [](const mat4& a) { return a.determinant(); });
+        unary<mat4, mat4>("mat4/inverse", [](const mat4& a) { return a.inverse(); });
+        unary<mat4, mat4>("mat4/inverse_scalar", [](const mat4& a) { mat4 r; detail::mat4_inverse_scalar(a.data(), r.data()); return r; });
+        unary<mat4, mat4>("mat4/inverseAffine", [](const mat4& a) { return a.inverseAffine(); });
+        unary<mat4, mat4>("mat4/inverseRigid", [](const mat4& a) { return a.inverseRigid(); });
+        unary<mat4, mat3>("mat4/inverseTranspose3x3", [](const mat4& a) { return a.inverseTranspose3x3(); });
+        binary<mat4, vec3, mat4>("mat4/translate", [](mat4 a, vec3 v) { a.translate(v); return a; });
+        binary<mat4, vec4, mat4>("mat4/scale", [](mat4 a, vec4 v) { a.scale(v); return a; });
+        binary<mat4, vec3, mat4>("mat4/rotate", [](mat4 a, vec3 v) { a.rotate(v); return a; });
+        binary<mat4, vec3, mat4>("mat4/rotateX", [](mat4 a, vec3 v) { a.rotateX(v.x); return a; });
+        // the products the mutators used to do, for comparison
+        binary<mat4, vec3, mat4>("mat4/*=translation", [](mat4 a, vec3 v) { a *= mat4::translation(v); return a; });
+        binary<mat4, vec4, mat4>("mat4/*=scalation", [](mat4 a, vec4 v) { a *= mat4::scalation(v); return a; });
+        binary<mat4, vec3, mat4>("mat4/*=rotationX*rotationY*rotationZ", [](mat4 a, vec3 v) {
+            a *= mat4::rotationX(v.x) * mat4::rotationY(v.y) * mat4::rotationZ(v.z);
+            return a;
+        });
+        binary<mat4, vec3, mat4>("mat4/*=rotationX", [](mat4 a, vec3 v) { a *= mat4::rotationX(v.x); return a; });
+
+        binary<cmat4, cmat4, cmat4>("cmat4/mul", [](const cmat4& a, const cmat4& b) { return a * b; });
+        binary<cmat4, vec4, vec4>("cmat4/mul_vec4", [](const cmat4& a, vec4 v) { return a * v; });
+        unary<cmat4, cmat4>("cmat4/inverse", [](const cmat4& a) { return a.inverse(); });
+        unary<mat4, cmat4>("cmat4/fromMat4", [](const mat4& a) { return cmat4(a); });
+
+        binary<mat3, mat3, mat3>("mat3/mul", [](const mat3& a, const mat3& b) { return a * b; });
+        binary<mat3, vec3, vec3>("mat3/mul_vec3", [](const mat3& a, vec3 v) { return a * v; });
+        binary<mat3, mat3, mat3>("mat3/add", [](const mat3& a, const mat3& b) { return a + b; });
+        binary<mat3, mat3, mat3>("mat3/sub", [](const mat3& a, const mat3& b) { return a - b; });
+        binary<mat3, mat3, float>("mat3/eq", [](const mat3& a, const mat3& b) { return a == b ? 1.f : 0.f; });
+        unary<mat3, mat3>("mat3/transposed", [](const mat3& a) { return a.transposed(); });
+        unary<mat3, float>("mat3/determinant", [](const mat3& a) { return a.determinant(); });
+        unary<mat3, mat3>("mat3/inverse", [](const mat3& a) { return a.inverse(); });
+        unary<mat3, mat3>("mat3/inverseTransposed", [](const mat3& a) { return a.inverseTransposed(); });
+
+        unary<mat2, float>("mat2/determinant", [](const mat2& a) { return a.determinant(); });
+        unary<mat2, mat2>("mat2/inverse", [](const mat2& a) { return a.inverse(); });
+
+        binary<affine3, affine3, affine3>("affine3/mul", [](const affine3& a, const affine3& b) { return a * b; });
+        binary<affine3, vec3, vec3>("affine3/transformPoint", [](const affine3& a, vec3 v) { return a.transformPoint(v); });
+        unary<affine3, affine3>("affine3/inverse", [](const affine3& a) { return a.inverse(); });
+
+        binary<quat, quat, quat>("quat/mul", [](quat a, quat b) { return a * b; });
+        binary<quat, vec3, vec3>("quat/rotate", [](quat a, vec3 v) { return a * v; });
+        binary<quat, quat, quat>("quat/slerp", [](quat a, quat b) { return quat::slerp(a, b, 0.3f); });
+        binary<quat, quat, quat>("quat/nlerp", [](quat a, quat b) { return quat::nlerp(a, b, 0.3f); });
+        unary<quat, mat4>("quat/toMat4", [](quat a) { return a.toMat4(); });
+    }
+
+    void builders() {
+        unary<float, mat4>("builders/mat4::rotationX", [](float a) { return mat4::rotationX(a); });
+        unary<float, mat4>("builders/mat4::rotationY", [](float a) { return mat4::rotationY(a); });
+        unary<float, mat4>("builders/mat4::rotationZ", [](float a) { return mat4::rotationZ(a); });
+        unary<vec3, mat4>("builders/mat4::rotation", [](vec3 a) { return mat4::rotation(a); });
+        unary<vec3, mat4>("builders/mat4::fromEuler(ZYX)", [](vec3 a) { return mat4::fromEuler(a, EulerOrder::ZYX); });
+        unary<vec3, mat4>("builders/mat4::rotation<fast>", [](vec3 a) { return mat4::rotation<fast>(a); });
+        // what mat4::rotation used to do
+        unary<vec3, mat4>("builders/mat4::rotationX*rotationY*rotationZ", [](vec3 a) {
+            return mat4::rotationX(a.x) * mat4::rotationY(a.y) * mat4::rotationZ(a.z);
+        });
+        unary<vec3, mat4>("builders/mat4::translation", [](vec3 a) { return mat4::translation(a); });
+        unary<vec4, mat4>("builders/mat4::scalation", [](vec4 a) { return mat4::scalation(a); });
+        unary<float, mat4>("builders/mat4::rotationX<fast>", [](float a) { return mat4::rotationX<fast>(a); });
+        unary<float, mat3>("builders/mat3::rotationX", [](float a) { return mat3::rotationX(a); });
+        unary<vec3, mat3>("builders/mat3::rotation", [](vec3 a) { return mat3::rotation(a); });
+        unary<vec3, mat3>("builders/mat3::rotationX*rotationY*rotationZ", [](vec3 a) {
+            return mat3::rotationX(a.x) * mat3::rotationY(a.y) * mat3::rotationZ(a.z);
+        });
+        unary<vec3, quat>("builders/quat::fromEuler", [](vec3 a) { return quat::fromEuler(a); });
+        binary<vec3, vec3, mat4>("builders/CreateRMCameraViewMatrix", [](vec3 p, vec3 f) {
+            return CreateRMCameraViewMatrix(p, vec3(1, 0, 0), vec3(0, 1, 0), f);
+        });
+        binary<vec3, vec3, mat4>("builders/CreateCMCameraViewMatrix", [](vec3 p, vec3 f) {
+            return CreateCMCameraViewMatrix(p, vec3(1, 0, 0), vec3(0, 1, 0), f);
+        });
+        unary<float, mat4>("builders/CreateRMCameraPerspectiveMatrix", [](float fov) {
+            return CreateRMCameraPerspectiveMatrix(ivec2(1920, 1080), fov * 10.f, 0.1f, 100.f);
+        });
+        unary<float, mat4>("builders/CreateCMCameraPerspectiveMatrix", [](float fov) {
+            return CreateCMCameraPerspectiveMatrix(ivec2(1920, 1080), fov * 10.f, 0.1f, 100.f);
+        });
+        binary<vec3, vec3, mat4>("builders/CreateRMModelMatrix(euler)", [](vec3 p, vec3 r) { return CreateRMModelMatrix(p, r); });
+        binary<vec3, vec3, mat4>("builders/CreateCMModelMatrix(euler)", [](vec3 p, vec3 r) { return CreateCMModelMatrix(p, r); });
+        binary<vec3, vec3, mat4>("builders/translation*rotationX*rotationY*rotationZ*scalation", [](vec3 p, vec3 r) {
+            return mat4::translation(p) * mat4::rotationX(r.x) * mat4::rotationY(r.y) * mat4::rotationZ(r.z) * mat4::scalation(vec4(1, 1, 1, 1));
+        });
+        binary<vec3, quat, mat4>("builders/CreateRMModelMatrix(quat)", [](vec3 p, quat r) { return CreateRMModelMatrix(p, r); });
+        binary<vec3, quat, mat4>("builders/CreateCMModelMatrix(quat)", [](vec3 p, quat r) { return CreateCMModelMatrix(p, r); });
+        // what a column major upload costs: building a row major matrix and transposing it, or building
+        // it column major straight into the buffer.
+        binary<vec3, quat, mat4>("builders/CreateRMModelMatrix(quat).transposed()", [](vec3 p, quat r) {
+            return CreateRMModelMatrix(p, r).transposed();
+        });
+        binary<vec3, quat, cmat4>("builders/CreateModelMatrix<ColumnMajor>(quat)", [](vec3 p, quat r) {
+            return CreateModelMatrix<StorageOrder::ColumnMajor>(p, r);
+        });
+        unary<float, vec3>("builders/CalculateCameraForwardVector", [](float a) { return CalculateCameraForwardVector(a, a * 0.5f); });
+        unary<float, vec3>("builders/CalculateCameraForwardVector<fast>", [](float a) { return CalculateCameraForwardVector<fast>(a, a * 0.5f); });
+    }
+
+    void transforms() {
+        // clean: nothing changed since the last matrix() call, dirty: every call rebuilds it.
+        unary<Transform, mat4>("transform/matrix(clean)", [](const Transform& t) { return t.matrix(); });
+        unary<Transform, mat4>("transform/matrix(dirty)", [](Transform t) { t.setScale(t.scale()); return t.matrix(); });
+        unary<Transform, affine3>("transform/affine", [](const Transform& t) { return t.affine(); });
+        binary<Transform, Transform, Transform>("transform/compose", [](const Transform& a, const Transform& b) { return a * b; });
+        unary<Transform, Transform>("transform/inverse", [](const Transform& t) { return t.inverse(); });
+        binary<Transform, Transform, Transform>("transform/interpolate", [](const Transform& a, const Transform& b) {
+            return Transform::interpolate(a, b, 0.3f);
+        });
+        binary<Transform, vec3, vec3>("transform/transformPoint", [](const Transform& t, vec3 p) { return t.transformPoint(p); });
+    }
+
+    // The bulk functions, these only have a batch form.
+    void bulk() {
+        static Vec3Stream s3a, s3b, s3out;
+        static Vec4Stream s4;
+        static FloatStream sf;
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        const std::vector<vec3>& w3 = inputs<vec3>(1);
+        for (int i = 0; i < items; i++) {
+            s3a.push_back(v3[i]);
+            s3b.push_back(w3[i]);
+            s4.push_back(vec4(v3[i].x, v3[i].y, v3[i].z, w3[i].x));
+        }
+        const mat4 m = inputs<mat4>(0)[0];
+        const affine3 af = affine3::fromMat4(m);
+        vec3* out3 = outputs<vec3>().data();
+        vec4* out4 = outputs<vec4>().data();
+
+        bench("bulk/Vec3Stream/add/batch", []() { add(s3a, s3b, s3out); });
+        bench("bulk/Vec3Stream/mul_scalar/batch", []() { mul(s3a, 3.f, s3out); });
+        bench("bulk/Vec3Stream/dot/batch", []() { dot(s3a, s3b, sf); });
+        bench("bulk/Vec3Stream/cross/batch", []() { cross(s3a, s3b, s3out); });
+        bench("bulk/Vec3Stream/length/batch", []() { length(s3a, sf); });
+        bench("bulk/Vec3Stream/normalize/batch", []() { normalize(s3a, s3out); });
+        bench("bulk/Vec3Stream/length<fast>/batch", []() { length<fast>(s3a, sf); });
+        bench("bulk/Vec3Stream/normalize<fast>/batch", []() { normalize<fast>(s3a, s3out); });
+        bench("bulk/Vec3Stream/div/batch", []() { div(s3a, s3b, s3out); });
+        bench("bulk/Vec3Stream/div<fast>/batch", []() { div<fast>(s3a, s3b, s3out); });
+        bench("bulk/Vec3Stream/lerp/batch", []() { lerp(s3a, s3b, 0.3f, s3out); });
+        bench("bulk/transformPoints(mat4,vec3)/batch", [=, &v3]() { transformPoints(m, v3, span<vec3>(out3, items)); });
+        bench("bulk/transformPoints(mat4,vec4)/batch", [=]() {
+            transformPoints(m, span<const vec4>(inputs<vec4>(0)), span<vec4>(out4, items));
+        });
+        bench("bulk/transformDirections(mat4,vec3)/batch", [=, &v3]() { transformDirections(m, v3, span<vec3>(out3, items)); });
+        bench("bulk/transformPoints(affine3,vec3)/batch", [=, &v3]() { transformPoints(af, v3, span<vec3>(out3, items)); });
+        bench("bulk/transformPoints(mat4,Vec3Stream)/batch", [=]() { transformPoints(m, s3a, s3out); });
+        bench("bulk/transformPoints(mat4,Vec4Stream)/batch", [=]() {
+            static Vec4Stream out;
+            transformPoints(m, s4, out);
+        });
+
+        // The positions of an interleaved vertex buffer (position, normal, uv), transformed in place
+        // through a view and by copying them out and back in.
+        static std::vector<float> vertices(items * 8);
+        for (int i = 0; i < items; i++) memcpy(&vertices[i * 8], &v3[i], sizeof(vec3));
+        bench("bulk/transformPoints(mat4,vec3_view)/batch", [=]() {
+            transformPoints(m, vec3_view(vertices.data(), items, 8 * sizeof(float)));
+        });
+        bench("bulk/copy+transformPoints(mat4,vec3)+copy/batch", [=]() {
+            std::vector<vec3> tmp(items);
+            for (int i = 0; i < items; i++) tmp[i] = vec3(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+            transformPoints(m, tmp, span<vec3>(tmp));
+            for (int i = 0; i < items; i++) memcpy(&vertices[i * 8], &tmp[i], sizeof(vec3));
+        });
+        bench("bulk/normalize(vec3_view)/batch", [=]() {
+            const_vec3_view in(vertices.data(), items, 8 * sizeof(float));
+            normalize(in, vec3_view(out3, items));
+        });
+
+        static std::vector<uint32_t> mask(cullMaskSize(items));
+        static Vec3Stream centers, extents_min, extents_max;
+        static FloatStream radii;
+        for (int i = 0; i < items; i++) {
+            vec3 c = (v3[i] - 5.f) * 4.f;
+            centers.push_back(c);
+            radii.push_back(w3[i].x * 0.2f);
+            extents_min.push_back(c - w3[i] * 0.2f);
+            extents_max.push_back(c + w3[i] * 0.2f);
+        }
+        const Frustum f = Frustum::fromRM(CreateRMCameraPerspectiveMatrix(ivec2(1920, 1080), 90.f, 0.1f, 100.f),
+                                          CreateRMCameraViewMatrix(vec3(0, 0, 30), vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, -1)));
+        bench("bulk/cullSpheres/single", [=]() {
+            uint32_t* mk = mask.data();
+            for (int i = 0; i < items; i++) {
+                if (f.intersectsSphere(centers.get(i), radii.x()[i])) mk[i / 32] |= 1u << (i % 32);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench("bulk/cullSpheres/batch", [=]() { cullSpheres(f, centers, radii, mask); });
+        bench("bulk/cullAABBs/single", [=]() {
+            uint32_t* mk = mask.data();
+            for (int i = 0; i < items; i++) {
+                if (f.intersectsAABB(extents_min.get(i), extents_max.get(i))) mk[i / 32] |= 1u << (i % 32);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench("bulk/cullAABBs/batch", [=]() { cullAABBs(f, extents_min, extents_max, mask); });
+
+        // A wide, shallow tree where 1 in 16 nodes moves every frame.
+        static TransformHierarchy h;
+        const std::vector<mat4>& locals = inputs<mat4>(1);
+        for (int i = 0; i < items; i++) h.add(locals[i], i < 8 ? (uint32_t)TransformHierarchy::NoParent : (uint32_t)(rng() % i));
+        h.update();
+        bench("bulk/TransformHierarchy::update(1/16 moved)/batch", [&locals]() {
+            for (int i = 0; i < items; i += 16) h.setLocal((uint32_t)i, locals[i]);
+            h.update();
+        });
+    }
+
+    // Converting to and from one of the packed types in lina_pack.hpp, `in` are the vectors to pack.
+    template <typename V, typename P, typename E, typename D>
+    void packed(const std::string& name, const std::vector<V>& in, E encode, D decode) {
+        static std::vector<P> p(items);
+        const V* a = in.data();
+        P* po = p.data();
+        V* out = outputs<V>().data();
+        bench("pack/" + name + "/pack/single", [=]() {
+            for (int i = 0; i < items; i++) {
+                po[i] = encode(a[i]);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench("pack/" + name + "/pack/batch", [=]() { pack(span<const V>(a, items), span<P>(po, items)); });
+        bench("pack/" + name + "/unpack/single", [=]() {
+            for (int i = 0; i < items; i++) {
+                out[i] = decode(po[i]);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench("pack/" + name + "/unpack/batch", [=]() { unpack(span<const P>(po, items), span<V>(out, items)); });
+    }
+
+    void packing() {
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        const std::vector<vec4>& v4 = inputs<vec4>(0);
+        static std::vector<vec3> normals, unit3;
+        static std::vector<vec4> unit4;
+        for (int i = 0; i < items; i++) {
+            normals.push_back(v3[i].normalized());
+            unit3.push_back(v3[i] * 0.1f);
+            unit4.push_back(v4[i] * 0.1f);
+        }
+        packed<vec3, half3>("half3", v3, [](vec3 v) { return half3::fromVec3(v); }, [](half3 h) { return h.toVec3(); });
+        packed<vec4, half4>("half4", v4, [](vec4 v) { return half4::fromVec4(v); }, [](half4 h) { return h.toVec4(); });
+        packed<vec3, snorm16x3>("snorm16x3", unit3, [](vec3 v) { return snorm16x3::fromVec3(v); }, [](snorm16x3 s) { return s.toVec3(); });
+        packed<vec4, snorm16x4>("snorm16x4", unit4, [](vec4 v) { return snorm16x4::fromVec4(v); }, [](snorm16x4 s) { return s.toVec4(); });
+        packed<vec4, unorm8x4>("unorm8x4", unit4, [](vec4 v) { return unorm8x4::fromVec4(v); }, [](unorm8x4 u) { return u.toVec4(); });
+        packed<vec3, octnormal>("octnormal", normals, [](vec3 v) { return octnormal::fromVec3(v); }, [](octnormal o) { return o.toVec3(); });
+    }
+
+    // A per frame array of world matrices, from the heap and from the allocators in lina_alloc.hpp.
+    void allocators() {
+        const mat4* a = inputs<mat4>(0).data();
+        bench("alloc/std::vector<mat4>/batch", [=]() {
+            std::vector<mat4> v(a, a + items);
+            LINA_BENCH_CLOBBER();
+        });
+        bench("alloc/aligned_vector<mat4>/batch", [=]() {
+            aligned_vector<mat4> v(a, a + items);
+            LINA_BENCH_CLOBBER();
+        });
+        bench("alloc/FrameArena/batch", [=]() {
+            static FrameArena arena;
+            arena.reset();
+            mat4* v = arena.allocate<mat4>(items);
+            for (int i = 0; i < items; i++) v[i] = a[i];
+            LINA_BENCH_CLOBBER();
+        });
+    }
+
+    // 64 bones, every vertex uses 4 (or 8) of them. The times are per vertex.
+    template <int K>
+    void skinning(const std::string& n) {
+        static SkinPalette palette;
+        static SkinWeights<K> weights(items);
+        static Vec3Stream positions, normals, out_positions, out_normals;
+        const std::vector<mat4>& worlds = inputs<mat4>(0);
+        const std::vector<mat4>& binds = inputs<mat4>(1);
+        buildSkinPalette(span<const mat4>(worlds.data(), 64), span<const mat4>(binds.data(), 64), palette);
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        const std::vector<vec3>& w3 = inputs<vec3>(1);
+        for (int i = 0; i < items; i++) {
+            uint16_t b[K];
+            float w[K];
+            for (int k = 0; k < K; k++) {
+                b[k] = (uint16_t)(rng() % 64);
+                w[k] = 1.f / K;
+            }
+            weights.set(i, b, w);
+            positions.push_back(v3[i]);
+            normals.push_back(w3[i].normalized());
+        }
+        vec3* op = outputs<vec3>().data();
+        static std::vector<vec3> on(items);
+        // The same thing with plain mat4 * vec4 products, one vertex at a time.
+        static std::vector<mat4> mats(64);
+        for (int b = 0; b < 64; b++) mats[b] = palette.get(b);
+        bench("skin/" + n + "/positions/single", [=]() {
+            for (int i = 0; i < items; i++) {
+                vec4 p(positions.get(i), 1.f), r(0.f, 0.f, 0.f, 0.f);
+                for (int k = 0; k < K; k++) r += mats[weights.bones(k)[i]] * p * weights.weights(k)[i];
+                op[i] = vec3(r.x, r.y, r.z);
+                LINA_BENCH_CLOBBER();
+            }
+        });
+        bench("skin/" + n + "/positions/batch", [=]() { skinVertices(palette, weights, positions, span<vec3>(op, items)); });
+        bench("skin/" + n + "/positions+normals/batch", [=]() {
+            skinVertices(palette, weights, positions, normals, span<vec3>(op, items), span<vec3>(on));
+        });
+        bench("skin/" + n + "/positions+normals(Vec3Stream)/batch", [=]() {
+            skinVertices(palette, weights, positions, normals, out_positions, out_normals);
+        });
+    }
+
+    void skinning() {
+        skinning<4>("skinVertices<4>");
+        skinning<8>("skinVertices<8>");
+        const std::vector<mat4>& worlds = inputs<mat4>(0);
+        const std::vector<mat4>& binds = inputs<mat4>(1);
+        bench("skin/buildSkinPalette/batch", [&]() {
+            static SkinPalette palette;
+            buildSkinPalette(worlds, binds, palette);
+        });
+    }
+
+    // Loading a table of mat4s from a text file (already in memory) and from a table file, the
+    // table file is written to the working directory and removed when the benchmark exits.
+    void files() {
+        static const char* path = "lina_bench_tables.tmp";
+        static struct cleanup {
+            ~cleanup() { remove(path); }
+        } remove_at_exit;
+        const std::vector<mat4>& m = inputs<mat4>(0);
+        TableWriter w;
+        w.add("matrices", m);
+        w.add("halves", m, TableEncoding::Half);
+        if (w.write(path) != TableError::None) {
+            fprintf(stderr, "lina_bench: can't write '%s', skipping the file benchmarks\n", path);
+            return;
+        }
+        static std::string text;
+        char buf[64];
+        for (const mat4& a : m)
+            for (int k = 0; k < 16; k++) {
+                snprintf(buf, sizeof(buf), "%.9g ", a.data()[k]);
+                text += buf;
+            }
+        mat4* out = outputs<mat4>().data();
+        bench("file/text(mat4)/batch", [=]() {
+            const char* p = text.c_str();
+            char* end;
+            for (int i = 0; i < items; i++)
+                for (int k = 0; k < 16; k++, p = end) out[i].data()[k] = strtof(p, &end);
+        });
+        bench("file/open+table<mat4>/batch", [=]() {
+            TableFile f;
+            f.open(path);
+            float sum = 0.f;
+            for (const mat4& a : f.table<mat4>("matrices")) sum += a._03;
+            out[0]._00 = sum;
+        });
+        bench("file/open+read<mat4>(half)/batch", [=]() {
+            TableFile f;
+            f.open(path);
+            f.read("halves", span<mat4>(out, items));
+        });
+    }
+
+    // One frame of handing the world matrices to the render thread, on one thread: a mutex and a
+    // copy of the whole array, and a TransformStore where 1 in 64 (one block) or all of them moved.
+    void snapshots() {
+        const mat4* a = inputs<mat4>(0).data();
+        bench("sync/mutex+copy/batch", [=]() {
+            static std::mutex lock;
+            static std::vector<mat4> shared(items), render(items);
+            {
+                std::lock_guard<std::mutex> l(lock);
+                for (int i = 0; i < items; i += 64) shared[i] = a[i];
+            }
+            std::lock_guard<std::mutex> l(lock);
+            render = shared;
+            LINA_BENCH_CLOBBER();
+        });
+        bench("sync/TransformStore(1 block dirty)/batch", [=]() {
+            static TransformStore store(items);
+            store.set(rng() % items, a[0]);
+            store.publish();
+            store.acquire();
+            LINA_BENCH_CLOBBER();
+        });
+        bench("sync/TransformStore(all dirty)/batch", [=]() {
+            static TransformStore store(items);
+            span<mat4> w = store.write(0, items);
+            for (int i = 0; i < items; i += 64) w[i] = a[i];
+            store.publish();
+            store.acquire();
+            LINA_BENCH_CLOBBER();
+        });
+    }
+
+    // One linear system per element, a matrix at a time and with the batched solvers.
+    void solvers() {
+        binary<mat3, vec3, vec3>("solve/mat3.inverse()*vec3", [](const mat3& m, vec3 b) { return m.inverse() * b; });
+        binary<mat4, vec4, vec4>("solve/mat4.inverse()*vec4", [](const mat4& m, vec4 b) { return m.inverse() * b; });
+        static Mat3Stream a3, i3, sym, vectors, rotation, stretch;
+        static Mat4Stream a4, i4;
+        static Vec3Stream b3, x3;
+        static Vec4Stream b4, x4;
+        static Vec3Stream values;
+        static FloatStream d;
+        static std::vector<uint32_t> singular(solveMaskSize(items));
+        for (int i = 0; i < items; i++) {
+            a3.push_back(inputs<mat3>(0)[i]);
+            sym.push_back(inputs<mat3>(0)[i] * inputs<mat3>(0)[i].transposed());
+            a4.push_back(inputs<mat4>(0)[i]);
+            b3.push_back(inputs<vec3>(0)[i]);
+            b4.push_back(inputs<vec4>(0)[i]);
+        }
+        bench("solve/determinant(Mat3Stream)/batch", []() { determinant(a3, d); });
+        bench("solve/determinant(Mat4Stream)/batch", []() { determinant(a4, d); });
+        bench("solve/inverse(Mat3Stream)/batch", []() { inverse(a3, i3, span<uint32_t>(singular)); });
+        bench("solve/inverse(Mat4Stream)/batch", []() { inverse(a4, i4, span<uint32_t>(singular)); });
+        bench("solve/solve(Mat3Stream,Vec3Stream)/batch", []() { solve(a3, b3, x3, span<uint32_t>(singular)); });
+        bench("solve/solve(Mat4Stream,Vec4Stream)/batch", []() { solve(a4, b4, x4, span<uint32_t>(singular)); });
+        bench("solve/eigenSymmetric(Mat3Stream)/batch", []() { eigenSymmetric(sym, values, vectors); });
+        bench("solve/polarDecompose(Mat3Stream)/batch", []() { polarDecompose(a3, rotation, stretch, span<uint32_t>(singular)); });
+    }
+
+    // The results go to outputs<>(), so the compiler can't drop the reductions.
+    void bounds() {
+        static Vec3Stream points;
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        for (int i = 0; i < items; i++) points.push_back(v3[i]);
+        vec3* out = outputs<vec3>().data();
+        mat3* cov = outputs<mat3>().data();
+        bench("bounds/boundingBox(vec3)/single", [=, &v3]() {
+            AABB b;
+            for (int i = 0; i < items; i++) {
+                vec3 p = v3[i];
+                b.min = vec3(p.x < b.min.x ? p.x : b.min.x, p.y < b.min.y ? p.y : b.min.y, p.z < b.min.z ? p.z : b.min.z);
+                b.max = vec3(p.x > b.max.x ? p.x : b.max.x, p.y > b.max.y ? p.y : b.max.y, p.z > b.max.z ? p.z : b.max.z);
+                LINA_BENCH_CLOBBER();
+            }
+            out[0] = b.min;
+            out[1] = b.max;
+        });
+        bench("bounds/boundingBox(vec3)/batch", [=, &v3]() {
+            AABB b = boundingBox(v3);
+            out[0] = b.min;
+            out[1] = b.max;
+        });
+        bench("bounds/boundingBox(Vec3Stream)/batch", [=]() {
+            AABB b = boundingBox(points);
+            out[0] = b.min;
+            out[1] = b.max;
+        });
+        bench("bounds/centroid(vec3)/batch", [=, &v3]() { out[0] = centroid(v3); });
+        bench("bounds/centroid(Vec3Stream)/batch", [=]() { out[0] = centroid(points); });
+        bench("bounds/covariance(vec3)/batch", [=, &v3]() { cov[0] = covariance(v3); });
+        bench("bounds/covariance(Vec3Stream)/batch", [=]() { cov[0] = covariance(points); });
+        bench("bounds/boundingSphere(vec3)/batch", [=, &v3]() {
+            BoundingSphere s = boundingSphere(v3);
+            out[0] = s.center;
+            out[1].x = s.radius;
+        });
+        bench("bounds/boundingSphere(Vec3Stream)/batch", [=]() {
+            BoundingSphere s = boundingSphere(points);
+            out[0] = s.center;
+            out[1].x = s.radius;
+        });
+    }
+
+    // The same big batches on 1, 2, 4, ... threads, up to the number of hardware threads, each on
+    // its own TaskScheduler. These work on 1024 times as many elements as the others (the time
+    // is still divided by 1024), and main prints how close each one gets to a linear speedup.
+    void scaling() {
+        enum { big = items * 1024 };
+        static std::vector<vec3> points(big), out(big);
+        static Vec3Stream centers, normals;
+        static FloatStream radii;
+        static std::vector<uint32_t> mask(cullMaskSize(big));
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        for (int i = 0; i < big; i++) {
+            points[i] = v3[i % items] * (1.f + (float)(i / items) * 1e-3f);
+            centers.push_back((points[i] - 5.f) * 4.f);
+            radii.push_back(v3[(i + 1) % items].x * 0.2f);
+        }
+        const mat4 m = inputs<mat4>(0)[0];
+        const Frustum f = Frustum::fromRM(CreateRMCameraPerspectiveMatrix(ivec2(1920, 1080), 90.f, 0.1f, 100.f),
+                                          CreateRMCameraViewMatrix(vec3(0, 0, 30), vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, -1)));
+
+        static std::vector<std::unique_ptr<TaskScheduler>> schedulers;
+        unsigned hw = std::thread::hardware_concurrency();
+        for (unsigned t = 1; t <= (hw ? hw : 1); t = t * 2 > hw && t != hw ? hw : t * 2) {
+            schedulers.emplace_back(new TaskScheduler(t));
+            TaskScheduler* s = schedulers.back().get();
+            std::string suffix = "/threads=" + std::to_string(t);
+            bench("scaling/transformPoints(mat4,vec3)" + suffix, [=]() {
+                setExecutor(s);
+                transformPoints(m, points, span<vec3>(out));
+                setExecutor(nullptr);
+            });
+            bench("scaling/Vec3Stream/normalize" + suffix, [=]() {
+                setExecutor(s);
+                normalize(centers, normals);
+                setExecutor(nullptr);
+            });
+            bench("scaling/cullSpheres" + suffix, [=]() {
+                setExecutor(s);
+                cullSpheres(f, centers, radii, span<uint32_t>(mask));
+                setExecutor(nullptr);
+            });
+            bench("scaling/boundingBox(vec3)" + suffix, [=]() {
+                setExecutor(s);
+                AABB b = boundingBox(points);
+                setExecutor(nullptr);
+                out[0] = b.min;
+            });
+            bench("scaling/parallel_reduce(sum)" + suffix, [=]() {
+                setExecutor(s);
+                const vec3* p = points.data();
+                vec3 sum = parallel_reduce((size_t)big, vec3(0, 0, 0), [=](size_t b, size_t e) {
+                    vec3 r(0, 0, 0);
+                    for (size_t i = b; i < e; i++) r += p[i];
+                    return r;
+                }, [](vec3 a, vec3 b) -> vec3 { return a + b; });
+                setExecutor(nullptr);
+                out[0] = sum;
+            });
+        }
+    }
+
+    // A long chain of vector arithmetic, a*2 + b*3 - a*b + (a-b)/4. Builds with LINA_EXPR defined
+    // (lina_bench_expr) run these through the expression templates, the others through the plain
+    // operators and the free stream functions, the names are the same so one can be the
+    // --baseline of the other.
+    void chains() {
+        binary<vec3, vec3, vec3>("chain/Vector3<float>", [](vec3 a, vec3 b) -> vec3 {
+            return a * 2.f + b * 3.f - a * b + (a - b) / 4.f;
+        });
+        binary<vec4, vec4, vec4>("chain/Vector4<float>", [](vec4 a, vec4 b) -> vec4 {
+            return a * 2.f + b * 3.f - a * b + (a - b) / 4.f;
+        });
+
+        static Vec3Stream a, b, out, t0, t1;
+        const std::vector<vec3>& v3 = inputs<vec3>(0);
+        const std::vector<vec3>& w3 = inputs<vec3>(1);
+        for (int i = 0; i < items; i++) {
+            a.push_back(v3[i]);
+            b.push_back(w3[i]);
+        }
+        bench("chain/Vec3Stream/batch", []() {
+        #ifdef LINA_EXPR
+            out = a * 2.f + b * 3.f - a * b + (a - b) / 4.f;
+        #else
+            mul(a, 2.f, t0);
+            mul(b, 3.f, t1);
+            add(t0, t1, t0);
+            mul(a, b, t1);
+            sub(t0, t1, t0);
+            sub(a, b, t1);
+            div(t1, 4.f, t1);
+            add(t0, t1, out);
+        #endif
+        });
+    }
+
+    struct Result {
+        std::string name;
+        double ns;
+    };
+
+    double runOne(const Bench& b, double min_ms) {
+        typedef std::chrono::steady_clock clock;
+        // Figure out how many repetitions fill a fifth of the time, then take the fastest of 5 samples.
+        size_t reps = 1;
+        for (;;) {
+            clock::time_point t0 = clock::now();
+            for (size_t r = 0; r < reps; r++) b.run();
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+            if (ms >= min_ms / (double)samples || reps >= ((size_t)1 << 30)) break;
+            reps *= 2;
+        }
+        double best = 1e300;
+        for (int s = 0; s < samples; s++) {
+            clock::time_point t0 = clock::now();
+            for (size_t r = 0; r < reps; r++) b.run();
+            double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            if (ns < best) best = ns;
+        }
+        return best / ((double)reps * (double)items);
+    }
+
+    const char* simdName() {
+        switch (LINA_SIMD) {
+            case LINA_SIMD_SSE2: return "SSE2";
+            case LINA_SIMD_AVX:  return "AVX";
+            case LINA_SIMD_AVX2: return "AVX2";
+            case LINA_SIMD_NEON: return "NEON";
+            default:             return "SCALAR";
+        }
+    }
+
+    bool writeJson(const char* path, const std::vector<Result>& results) {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "{\n  \"lina_bench\": 1,\n  \"simd\": \"%s\",\n  \"items\": %d,\n  \"results\": [\n", simdName(), (int)items);
+        for (size_t i = 0; i < results.size(); i++)
+            fprintf(f, "    {\"name\": \"%s\", \"ns_per_item\": %.4f}%s\n", results[i].name.c_str(), results[i].ns, i + 1 < results.size() ? "," : "");
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+        return true;
+    }
+
+    // Only understands what writeJson writes.
+    bool readJson(const char* path, std::map<std::string, double>& out) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        std::string text;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+        fclose(f);
+
+        const std::string name_key = "\"name\": \"", ns_key = "\"ns_per_item\": ";
+        size_t pos = 0;
+        while ((pos = text.find(name_key, pos)) != std::string::npos) {
+            pos += name_key.size();
+            size_t end = text.find('"', pos);
+            size_t ns = text.find(ns_key, end);
+            if (end == std::string::npos || ns == std::string::npos) return false;
+            out[text.substr(pos, end - pos)] = strtod(text.c_str() + ns + ns_key.size(), nullptr);
+            pos = ns;
+        }
+        return true;
+    }
+
+    void usage() {
+        fprintf(stderr, "usage: lina_bench [--filter <text>] [--min-time <ms>] [--json <file>] "
+                        "[--baseline <file>] [--threshold <percent>] [--list]\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    const char *filter = "", *json = nullptr, *baseline = nullptr;
+    double min_ms = 50.0, threshold = 10.0;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        if (!strcmp(argv[i], "--filter") && more) filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") && more) min_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && more) json = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && more) baseline = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && more) threshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--list")) list = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::map<std::string, double> base;
+    if (baseline && !readJson(baseline, base)) {
+        fprintf(stderr, "lina_bench: can't read baseline '%s'\n", baseline);
+        return 2;
+    }
+
+    vectors<float>("float");
+    vectorFast<vec2>("Vector2<float>");
+    vectorFast<vec3>("Vector3<float>");
+    vectorFast<vec4>("Vector4<float>");
+    vectors<int>("int");
+    vectors<unsigned>("unsigned");
+    matrices();
+    builders();
+    transforms();
+    chains();
+    bulk();
+    packing();
+    allocators();
+    skinning();
+    files();
+    snapshots();
+    solvers();
+    bounds();
+    scaling();
+
+    std::vector<Result> results;
+    int regressions = 0;
+    if (!list) printf("lina_bench, LINA_SIMD = %s, %d items per run\n\n", simdName(), (int)items);
+    for (const Bench& b : registry()) {
+        if (!strstr(b.name.c_str(), filter)) continue;
+        if (list) {
+            printf("%s\n", b.name.c_str());
+            continue;
+        }
+        double ns = runOne(b, min_ms);
+        results.push_back({b.name, ns});
+        printf("%-60s %10.3f ns", b.name.c_str(), ns);
+        std::map<std::string, double>::const_iterator it = base.find(b.name);
+        if (it != base.end() && it->second > 0.0) {
+            double change = (ns / it->second - 1.0) * 100.0;
+            printf("  %+7.1f%%", change);
+            if (change > threshold) {
+                printf("  REGRESSION");
+                regressions++;
+            }
+        }
+        printf("\n");
+    }
+
+    // How much faster every scaling/ benchmark got than the same one on 1 thread.
+    bool scale_header = false;
+    for (const Result& r : results) {
+        size_t at = r.name.find("/threads=");
+        if (r.name.compare(0, 8, "scaling/") != 0 || at == std::string::npos) continue;
+        unsigned threads = (unsigned)atoi(r.name.c_str() + at + 9);
+        std::string one = r.name.substr(0, at) + "/threads=1";
+        for (const Result& o : results) {
+            if (o.name != one || r.ns <= 0.0) continue;
+            if (!scale_header) printf("\nscaling (speedup over 1 thread, efficiency = speedup / threads)\n\n");
+            scale_header = true;
+            double speedup = o.ns / r.ns;
+            printf("%-60s %9.2fx %9.0f%%\n", r.name.c_str(), speedup, speedup / threads * 100.0);
+        }
+    }
+
+    if (json && !writeJson(json, results)) {
+        fprintf(stderr, "lina_bench: can't write '%s'\n", json);
+        return 2;
+    }
+    if (baseline) {
+        printf("\n%d regression%s over %.1f%%\n", regressions, regressions == 1 ? "" : "s", threshold);
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
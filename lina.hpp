@@ -2,8 +2,11 @@
 #define LINA_HPP
 
 #include <math.h>
+#include <string.h>
 #include <type_traits>
+#include <utility>
 #include <stdint.h>
+#include <stddef.h>
 
 /*
 
@@ -59,7 +62,240 @@ Matrix addition/subtraction is pretty simple, you just add/subtract every value
 matrix A with the corrosponding value in matrix B and put it in the corrosponding
 position in matrix C. 
 
+>>> Inverses <<<
+The inverse of a matrix undoes it, M * M.inverse() is the identity matrix. Not
+every matrix has one, if determinant() is 0 the result is full of inf/nan.
+mat4 has two cheaper versions for the common cases:
+    inverseAffine(): the bottom row is 0 0 0 1 (model matrices), only needs a 3x3 inverse.
+    inverseRigid():  only rotation and translation (view matrices), just a transpose.
+and inverseTranspose3x3() gives you the normal matrix of a model matrix.
 
+>>> Euler Rotations <<<
+rotation(r) is rotationX(r.x) * rotationY(r.y) * rotationZ(r.z). For the other
+orders use fromEuler, the order is the order the axis matrices get multiplied in:
+    mat4 m = mat4::fromEuler(angles, EulerOrder::ZYX);  // rotationZ * rotationY * rotationX
+rotation and fromEuler (mat4, mat3 and affine3) and the euler model matrix
+builders don't multiply the axis matrices together, the products are worked out
+ahead of time, so they only need one sincos per axis and a few multiplies.
+
+translate, scale, rotateX/Y/Z and rotate do the same as multiplying by the
+matching builder (m.rotateY(a) is m *= rotationY(a)), but only touch the columns
+that change: rotateX only mixes columns 1 and 2, scale just scales the columns,
+translate only changes the last column. The results are the same as the
+products up to rounding.
+
+
+
+###################
+    Quaternions
+###################
+'quat' is a rotation stored as 4 floats. Quaternions are cheaper to build
+(quat::fromEuler only needs 3 sin/cos pairs), cheaper to combine (q1 * q2 is
+16 multiplies instead of 64) and can be interpolated with quat::slerp and
+quat::nlerp. Turn one into a matrix with toMat3() / toMat4(), or pass it
+straight to CreateRMModelMatrix / CreateCMModelMatrix.
+
+They follow the same conventions as the rotation matrices:
+    quat::fromEuler(r).toMat4() == mat4::rotation(r)
+    (q1 * q2).toMat4()         == q1.toMat4() * q2.toMat4()
+
+###################
+ Affine Matrices
+###################
+Most of the mat4s you build (translations, rotations, scales, model matrices)
+have a bottom row of 0 0 0 1. 'affine3' is a 3x4 matrix that just doesn't store
+that row, so it's 12 floats instead of 16, combining two of them takes 36
+multiplies instead of 64, and the inverse is a 3x3 inverse plus a translation.
+Use toMat4() when you need the full matrix, it's lossless.
+
+###################
+    Transforms
+###################
+A 'Transform' keeps the translation, rotation (a quat) and scale of an object
+apart instead of baking them into a matrix:
+    Transform tr(position, quat::fromEuler(angles));
+    tr.translate(velocity * dt);
+    draw(tr.matrix());
+
+matrix() builds translation * rotation * scalation straight from the three
+parts (no products) the first time you call it after a change, and returns the
+same matrix until the next setter. So an object that doesn't move costs nothing
+per frame, and one that does costs one direct build. affine() gives you the
+same thing as an affine3.
+
+Transforms can be combined (a * b does b first, like the matrices), inverted
+and interpolated (Transform::interpolate, slerp for the rotation) without
+going through a matrix. A TRS can't represent a shear, so combining and
+inverting are only exact when the scale is uniform. With a non-uniform scale on
+a rotated parent, use the matrices.
+
+###################
+  Aligned Types
+###################
+The vector and matrix structs are just floats, so they're only aligned to 4
+bytes, and a mat4 in an array can straddle two cache lines. vec4a, mat3a and
+mat4a are the same types with a bigger alignment:
+    vec4a: 16 bytes, same size as a vec4.
+    mat4a: 64 bytes, same size as a mat4, so every one is exactly one cache line.
+    mat3a: 16 bytes, which pads it from 36 to 48 bytes.
+
+They convert to and from the normal types for free and have all the same
+functions, but anything that returns a new vector or matrix returns the
+normal type, so store the result in an aligned one:
+    mat4a world = parent * local;
+
+std::vector only respects an alignment bigger than 16 since C++17, use
+lina::aligned_vector from lina_alloc.hpp to be safe.
+
+###################
+   Storage Order
+###################
+mat4, mat3 and mat2 are stored row by row (row major), OpenGL, Vulkan and
+most shaders want the columns next to each other (column major). cmat4, cmat3
+and cmat2 are the same matrices stored column by column, so an array of them can
+be uploaded as is, without transposing every matrix first.
+
+The constructors and members still go by row and column, cm._03 is the
+translation x of a cmat4 just like m._03 is for a mat4, only where it sits in
+memory is different. They have the same operators as the row major matrices
+(products, inverse, transposed, ...), which run on the same kernels, and convert
+to and from them with cmat4(m) and toMat4(), which is a transpose.
+transposedMat4() and fromTransposedMat4() are the free conversion, they keep
+the memory as is, so you get the transpose.
+
+The storage order can also be a template parameter, mat4_t<StorageOrder::ColumnMajor>
+is cmat4, and the camera and model matrix builders take it:
+    cmat4 mvp = CreateCameraPerspectiveMatrix<StorageOrder::ColumnMajor>(size, fov, 0.1f, 100.f).transposed()
+              * CreateCameraViewMatrix<StorageOrder::ColumnMajor>(position, right, up, forward)
+              * CreateModelMatrix<StorageOrder::ColumnMajor>(position, rotation);
+CreateRM* and CreateCM* are the same builders for code that stores both in a mat4.
+
+The perspective builder lays out its matrix for v * m while the view and model
+builders are for m * v, and that's the same for both storage orders, so the
+projection needs the .transposed() above. Without it the product isn't the
+view-projection, and CreateCameraPerspectiveMatrix<StorageOrder::ColumnMajor>(...)
+* view can't go straight into Frustum::fromCM any more than the row major one
+can go into Frustum::fromRM. Frustum::fromRM(projection, view) and
+Frustum::fromCM(projection, view) in lina_cull.hpp take the CreateRM* and
+CreateCM* matrices as they come and do the transpose for you.
+
+asMat4<O>(float*) and asMat3<O>(float*) use floats you already have (a mapped
+uniform buffer for example) as a matrix of the given order, without copying:
+    asMat4<StorageOrder::ColumnMajor>(mapped + 16 * i) = CreateModelMatrix<StorageOrder::ColumnMajor>(p, r);
+
+###################
+       SIMD
+###################
+The matrix products (mat4 * mat4, mat4 * vec4, mat3 * mat3, mat3 * vec3), the
+transposes, the inverses and the quaternion product and rotation can be done
+with SIMD instructions. Which instruction set gets used is picked at compile time with
+the 'LINA_SIMD' macro, if you don't define it yourself it's picked from
+whatever the compiler is targeting (-msse2, -mavx, -mavx2 -mfma, or NEON on
+ARM). The possible values are:
+    LINA_SIMD_SCALAR: plain C++, this is the reference every other path is checked against.
+    LINA_SIMD_SSE2:   4 wide SSE2.
+    LINA_SIMD_AVX:    SSE2, but mat4 * mat4 does two rows per instruction.
+    LINA_SIMD_AVX2:   AVX with FMA (needs -mavx2 -mfma).
+    LINA_SIMD_NEON:   ARM NEON, fused multiply-add on AArch64.
+
+The scalar reference kernels are always available in 'lina::detail' (the
+functions ending in '_scalar'), so you can compare against them whatever
+LINA_SIMD is set to. tests/kernels.cpp does that for every level, against the
+bounds below.
+
+>>> Precision <<<
+Every path adds the products in the same order as the scalar code does
+((a0*b0 + a1*b1) + a2*b2) + a3*b3, so the paths without FMA give the exact
+same bits as the scalar reference. The FMA paths skip the rounding of each
+product, so an element can differ from the scalar reference by at most
+8 * 2^-24 * (|a0*b0| + |a1*b1| + |a2*b2| + |a3*b3|), which is 4 ULP of the
+result when the products don't cancel each other out. Keep in mind that the
+compiler is allowed to contract the scalar code into FMAs too (-ffp-contract),
+in which case the same bound applies to the scalar code.
+
+Transposes only move values around, so they are always exact.
+
+The inverses don't follow the scalar code's order (the SIMD mat4 inverse works
+on 2x2 blocks, the 3x3 ones on cross products), so they can differ from the
+scalar reference by a few ULP, more for badly conditioned matrices.
+
+###################
+ Precision Policies
+###################
+length, normalize and normalized (vectors, quat and the stream functions), div
+on streams and the rotation builders (rotationX/Y/Z, rotation and fromEuler of
+mat4, mat3 and affine3, rotateX/Y/Z and rotate, CalculateCameraForwardVector)
+take a precision policy as an optional template parameter:
+    vec3 n = v.normalized<lina::fast>();
+    mat4 r = mat4::rotationY<lina::fast>(angle);
+    normalize<lina::fast>(particles, particles);
+You can also call the policies directly, lina::fast::rsqrt(x),
+lina::fast::sincos(angle, s, c) and so on.
+
+    precise: the default, sqrtf, sinf, cosf and real divisions, so it's exactly
+             what you'd get without the policy.
+    fast:    the hardware estimate instructions plus one Newton step, and
+             polynomials for sin and cos. The largest errors we've measured:
+                 rsqrt, normalize:  relative error 3e-7 (about 5 ULP)
+                 recip, div:        relative error 2.1e-7 (about 4 ULP)
+                 sincos:            absolute error 8e-8 for |angle| <= 8192,
+                                    about 1e-6 at 100000, don't use it for
+                                    angles bigger than that.
+             sqrt and length are the same as precise, the square root
+             instruction is already faster than the estimate plus a Newton step.
+             rsqrt(0) and recip(0) are NaN instead of inf.
+
+Without SIMD there are no estimate instructions, so fast just adds a Newton
+step to the exact values. On NEON the estimates are coarser and get one more
+Newton step, which ends up around the same error.
+
+How much fast saves depends on the CPU and the libm. The stream functions and
+loops the compiler can vectorize win the most (fast sincos is about 3x faster
+than sinf + cosf in a loop). glibc's sincosf and the division on recent x86
+cores are already quick, so a single call there saves a lot less.
+
+###################
+     Constexpr
+###################
+The vector types, Rect and the matrix structs can all be used in constant
+expressions, so something like
+    constexpr mat4 ui_root = mat4::translation({10, 10, 0}) * mat4::scalation({2, 2, 1, 1});
+gets done by the compiler instead of at runtime. Everything is constexpr
+except for the functions that need sqrt or trig functions (length, normalize,
+the rotation builders, the perspective and model matrix builders).
+
+The functions that modify a vector or matrix in place (+=, translate, ...) need
+C++14, and the ones that use the SIMD kernels (matrix products, transposes and inverses)
+also need a compiler that has std::is_constant_evaluated or
+__builtin_is_constant_evaluated (GCC 9, Clang 9, MSVC 19.25 or newer),
+LINA_HAS_CONSTEXPR_SIMD is 1 when they are. In constant expressions they fall
+back to plain C++.
+
+###################
+Expression Templates
+###################
+If you define 'LINA_EXPR' before including lina, the +, -, * and / operators of
+the vector types don't compute anything anymore, they return a small object
+that remembers the operation and its operands. The actual math happens when
+that gets assigned to a vector, one component at a time, so
+    vec3 r = a * 2.f + b * 3.f - a * b;
+is a single loop over x, y and z with no temporary vectors in between. The
+same goes for the vector streams (see 'Expression Templates' in
+lina_stream.hpp), which is where it really pays off, since every temporary
+there is a whole array.
+
+It has to be turned on for the whole program (every file that includes lina
+has to agree on it), and it changes a few things:
+    - The result of an operator isn't a vector, so call methods on it after
+      converting it: vec3(a + b).length() instead of (a + b).length().
+    - It only holds references to its operands, so don't keep it around with
+      'auto', it'll point at temporaries that are gone:
+          auto r = a + b;   // r is an expression, not a vec3
+          vec3 r = a + b;   // fine
+      Lambdas and functions returning auto have the same problem, give them
+      a return type.
+    - scalar * vector works too, not just vector * scalar.
+All of it is still constexpr.
 
 */
 
@@ -67,6 +303,71 @@ position in matrix C.
 #define PRINT_VEC3(__vec, __type) printf("<"#__type", "#__type, #__type">\n", __vec.x, __vec.y, __vec.z);
 #define PRINT_VEC4(__vec, __type) printf("<"#__type", "#__type, #__type, #__type">\n", __vec.x, __vec.y, vec.z, vec.w);
 
+#define LINA_SIMD_SCALAR 0
+#define LINA_SIMD_SSE2   1
+#define LINA_SIMD_AVX    2
+#define LINA_SIMD_AVX2   3
+#define LINA_SIMD_NEON   4
+
+#ifndef LINA_SIMD
+    #if defined(__AVX2__) && defined(__FMA__)
+        #define LINA_SIMD LINA_SIMD_AVX2
+    #elif defined(__AVX__)
+        #define LINA_SIMD LINA_SIMD_AVX
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define LINA_SIMD LINA_SIMD_SSE2
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define LINA_SIMD LINA_SIMD_NEON
+    #else
+        #define LINA_SIMD LINA_SIMD_SCALAR
+    #endif
+#endif
+
+#define LINA_SIMD_X86 (LINA_SIMD >= LINA_SIMD_SSE2 && LINA_SIMD <= LINA_SIMD_AVX2)
+
+// Functions that assign to members or use if statements can only be constexpr since C++14.
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+    #define LINA_CONSTEXPR14 constexpr
+#else
+    #define LINA_CONSTEXPR14 inline
+#endif
+
+// The functions that use the SIMD kernels are constexpr when the compiler can tell us that
+// it's evaluating a constant expression, in which case they use plain C++ instead.
+#if defined(__cpp_lib_is_constant_evaluated)
+    #define LINA_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__has_builtin)
+    #if __has_builtin(__builtin_is_constant_evaluated)
+        #define LINA_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+    #endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+    #define LINA_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if defined(LINA_IS_CONSTANT_EVALUATED) && (__cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L))
+    #define LINA_CONSTEXPR_SIMD constexpr
+    #define LINA_HAS_CONSTEXPR_SIMD 1
+#else
+    #undef LINA_IS_CONSTANT_EVALUATED
+    #define LINA_IS_CONSTANT_EVALUATED() false
+    #define LINA_CONSTEXPR_SIMD inline
+    #define LINA_HAS_CONSTEXPR_SIMD 0
+#endif
+
+#if LINA_SIMD == LINA_SIMD_NEON
+    #include <arm_neon.h>
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        #define LINA_SIMD_FMA 1
+    #else
+        #define LINA_SIMD_FMA 0
+    #endif
+#elif LINA_SIMD != LINA_SIMD_SCALAR
+    #include <immintrin.h>
+    #define LINA_SIMD_FMA (LINA_SIMD == LINA_SIMD_AVX2)
+#else
+    #define LINA_SIMD_FMA 0
+#endif
+
 
 namespace lina {
     constexpr double PI = M_PI;
@@ -77,13 +378,148 @@ namespace lina {
         return 1.f/tanf(x);
     }
 
-    inline float dtor(float deg) {
+    constexpr float dtor(float deg) {
         return deg * PI / 180.f;
     }
-    inline float rtod(float rad) {
+    constexpr float rtod(float rad) {
         return rad * 180.f /  PI;
     }
 
+#ifdef LINA_EXPR
+    /*
+        Expression templates
+    */
+    template <typename T, typename> struct Vector2;
+    template <typename T, typename> struct Vector3;
+    template <typename T, typename> struct Vector4;
+
+    namespace expr {
+        // Every expression node derives from this, it's how the operators tell them apart from everything else.
+        struct node_tag {};
+        template <typename E>
+        struct is_node : std::is_base_of<node_tag, E> {};
+
+        template <typename V> struct vec_traits { static constexpr int size = 0; };
+        template <typename T, typename U> struct vec_traits<Vector2<T, U>> { typedef T value_type; static constexpr int size = 2; };
+        template <typename T, typename U> struct vec_traits<Vector3<T, U>> { typedef T value_type; static constexpr int size = 3; };
+        template <typename T, typename U> struct vec_traits<Vector4<T, U>> { typedef T value_type; static constexpr int size = 4; };
+
+        template <int I> struct component;
+        template <> struct component<0> { template <typename V> static constexpr auto get(const V& v) -> decltype(v.x) { return v.x; } };
+        template <> struct component<1> { template <typename V> static constexpr auto get(const V& v) -> decltype(v.y) { return v.y; } };
+        template <> struct component<2> { template <typename V> static constexpr auto get(const V& v) -> decltype(v.z) { return v.z; } };
+        template <> struct component<3> { template <typename V> static constexpr auto get(const V& v) -> decltype(v.w) { return v.w; } };
+
+        // A vector used in an expression, only holds a reference to it.
+        template <typename V>
+        struct leaf : node_tag {
+            typedef typename vec_traits<V>::value_type value_type;
+            static constexpr int size = vec_traits<V>::size;
+            const V& v;
+
+            constexpr leaf(const V& v) : v(v) {}
+            template <int I> constexpr value_type get() const { return component<I>::get(v); }
+        };
+
+        // A scalar used in an expression, it's the same for every component.
+        template <typename T>
+        struct scalar : node_tag {
+            typedef T value_type;
+            static constexpr int size = 0;
+            T s;
+
+            constexpr scalar(T s) : s(s) {}
+            template <int I> constexpr T get() const { return s; }
+        };
+
+        struct add_op { template <typename T> static constexpr T apply(T a, T b) { return (T)(a + b); } };
+        struct sub_op { template <typename T> static constexpr T apply(T a, T b) { return (T)(a - b); } };
+        struct mul_op { template <typename T> static constexpr T apply(T a, T b) { return (T)(a * b); } };
+        struct div_op { template <typename T> static constexpr T apply(T a, T b) { return (T)(a / b); } };
+
+        // l (op) r, component by component. The components are only worked out when the expression
+        // gets assigned to a vector, one at a time, so there's no temporary vector per operator.
+        template <typename Op, typename L, typename R>
+        struct binary : node_tag {
+            typedef typename std::conditional<L::size != 0, typename L::value_type, typename R::value_type>::type value_type;
+            static constexpr int size = L::size != 0 ? L::size : R::size;
+            static_assert(L::size == 0 || R::size == 0 || L::size == R::size, "lina: can't mix vectors of different sizes in one expression.");
+            L l;
+            R r;
+
+            constexpr binary(const L& l, const R& r) : l(l), r(r) {}
+            template <int I> constexpr value_type get() const {
+                return Op::apply((value_type)l.template get<I>(), (value_type)r.template get<I>());
+            }
+        };
+
+        template <typename E>
+        struct negate : node_tag {
+            typedef typename E::value_type value_type;
+            static constexpr int size = E::size;
+            E e;
+
+            constexpr negate(const E& e) : e(e) {}
+            template <int I> constexpr value_type get() const { return (value_type)-e.template get<I>(); }
+        };
+
+        template <typename X>
+        struct is_operand : std::integral_constant<bool, vec_traits<X>::size != 0 || is_node<X>::value> {};
+
+        // Turns one side of an operator into a node, `O` is the other side. Scalars take the
+        // component type of the other side, just like Vector3<T>::operator*(T) did.
+        template <typename X, typename O, typename = void>
+        struct operand {
+            typedef leaf<X> type;
+            static constexpr type make(const X& x) { return type(x); }
+        };
+        template <typename X, typename O>
+        struct operand<X, O, typename std::enable_if<is_node<X>::value>::type> {
+            typedef X type;
+            static constexpr const X& make(const X& x) { return x; }
+        };
+        template <typename X, typename O>
+        struct operand<X, O, typename std::enable_if<std::is_arithmetic<X>::value>::type> {
+            typedef scalar<typename operand<O, X>::type::value_type> type;
+            static constexpr type make(X x) { return type((typename type::value_type)x); }
+        };
+
+        // Vector/expression (op) vector/expression/scalar, or scalar (op) vector/expression. The node
+        // type is only worked out when that's the case, so other types never get a hard error here.
+        template <typename Op, typename L, typename R, bool =
+            (is_operand<L>::value && (is_operand<R>::value || std::is_arithmetic<R>::value)) ||
+            (std::is_arithmetic<L>::value && is_operand<R>::value)>
+        struct binary_result {};
+        template <typename Op, typename L, typename R>
+        struct binary_result<Op, L, R, true> {
+            typedef binary<Op, typename operand<L, R>::type, typename operand<R, L>::type> type;
+        };
+
+    #define LINA_EXPR_OPERATOR(op, name) \
+        template <typename L, typename R> \
+        constexpr typename binary_result<name, L, R>::type operator op(const L& l, const R& r) { \
+            return typename binary_result<name, L, R>::type(operand<L, R>::make(l), operand<R, L>::make(r)); \
+        }
+        LINA_EXPR_OPERATOR(+, add_op)
+        LINA_EXPR_OPERATOR(-, sub_op)
+        LINA_EXPR_OPERATOR(*, mul_op)
+        LINA_EXPR_OPERATOR(/, div_op)
+    #undef LINA_EXPR_OPERATOR
+
+        // Vectors have their own operator-(), this is just for expressions.
+        template <typename E, typename = typename std::enable_if<is_node<E>::value>::type>
+        constexpr negate<E> operator-(const E& e) { return negate<E>(e); }
+    }
+    using expr::operator+;
+    using expr::operator-;
+    using expr::operator*;
+    using expr::operator/;
+#endif
+
+    // Precision policies (see 'Precision Policies').
+    struct precise;
+    struct fast;
+
     /* 
         Vectors 
     */
@@ -91,99 +527,109 @@ namespace lina {
     struct Vector2 {
         T x, y;
         
-        Vector2(T x, T y) {
-            this->x=x; this->y=y;
-        }
-        Vector2() {x=y=(T)0;}
+        constexpr Vector2(T x, T y) : x(x), y(y) {}
+        constexpr Vector2() : x((T)0), y((T)0) {}
+    #ifdef LINA_EXPR
+        // Evaluates an expression (see 'Expression Templates').
+        template <typename E, typename = typename std::enable_if<expr::is_node<E>::value && E::size == 2>::type>
+        constexpr Vector2(const E& e) : x((T)e.template get<0>()), y((T)e.template get<1>()) {}
+    #endif
  
-        void nullify() {x=y=(T)0;}
+        LINA_CONSTEXPR14 void nullify() {x=y=(T)0;}
  
-        Vector2<T> operator-() {
+        constexpr Vector2<T> operator-() const {
             return Vector2<T>(-x, -y);
         }
  
-        Vector2<T> operator+(Vector2<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector2<T> operator+(Vector2<T> v) const {
             return Vector2<T>(x+v.x, y+v.y);
         }
-        Vector2<T> operator+(T v) {
+        constexpr Vector2<T> operator+(T v) const {
             return Vector2<T>(x+v, y+v);
         }
-        void operator+=(Vector2<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator+=(Vector2<T> v) {
             x+=v.x; y+=v.y; 
         }
-        void operator+=(T v) {
+        LINA_CONSTEXPR14 void operator+=(T v) {
             x+=v; y+=v;
         }
  
-        Vector2<T> operator-(Vector2<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector2<T> operator-(Vector2<T> v) const {
             return Vector2<T>(x-v.x, y-v.y);
         }
-        Vector2<T> operator-(T v) {
+        constexpr Vector2<T> operator-(T v) const {
             return Vector2<T>(x-v, y-v);
         }
-        void operator-=(Vector2<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator-=(Vector2<T> v) {
             x-=v.x; y-=v.y; 
         }
-        void operator-=(T v) {
+        LINA_CONSTEXPR14 void operator-=(T v) {
             x-=v; y-=v;
         }
  
-        Vector2<T> operator*(Vector2<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector2<T> operator*(Vector2<T> v) const {
             return Vector2<T>(x*v.x, y*v.y);
         }
-        Vector2<T> operator*(T v) {
+        constexpr Vector2<T> operator*(T v) const {
             return Vector2<T>(x*v, y*v);
         }
-        void operator*=(Vector2<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator*=(Vector2<T> v) {
             x*=v.x; y*=v.y; 
         }
-        void operator*=(T v) {
+        LINA_CONSTEXPR14 void operator*=(T v) {
             x*=v; y*=v;
         }
  
-        Vector2<T> operator/(Vector2<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector2<T> operator/(Vector2<T> v) const {
             return Vector2<T>(x/v.x, y/v.y);
         }
-        Vector2<T> operator/(T v) {
+        constexpr Vector2<T> operator/(T v) const {
             return Vector2<T>(x/v, y/v);
         }
-        void operator/=(Vector2<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator/=(Vector2<T> v) {
             x/=v.x; y/=v.y; 
         }
-        void operator/=(T v) {
+        LINA_CONSTEXPR14 void operator/=(T v) {
             x/=v; y/=v;
         }
  
-        bool operator==(Vector2<T> o) const {
+        constexpr bool operator==(Vector2<T> o) const {
             return x==o.x && y==o.y;
         }
  
-        void operator=(Vector2<T> v) {
-            x=v.x; y=v.y;
-        }
- 
-        float length() {
-            return sqrt(x * x + y * y);
+        template <typename P = precise>
+        float length() const {
+            return P::sqrt(x * x + y * y);
         }
  
+        template <typename P = precise>
         void normalize() {
-            this->operator/=(length());
+            *this = normalized<P>();
         }
  
-        Vector2<T> normalized() {
-            return this->operator/(length());
+        template <typename P = precise>
+        Vector2<T> normalized() const {
+            return P::normalized(*this);
         }
  
-        float dot(Vector2<T> other) {
+        constexpr float dot(Vector2<T> other) const {
             return x * other.x + y * other.y;
         }
  
-        static float dot(Vector2<T> a, Vector2<T> b) {
-            return a.x * b.y + a.y * b.y;
+        static constexpr float dot(Vector2<T> a, Vector2<T> b) {
+            return a.x * b.x + a.y * b.y;
         }
  
         template <typename _T, typename = typename std::enable_if<std::is_arithmetic<_T>::value, _T>::type>
-        operator Vector2<_T>() const {
+        constexpr operator Vector2<_T>() const {
             return Vector2<_T>((_T)x, (_T)y);
         }
 
@@ -201,109 +647,119 @@ namespace lina {
     template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
     struct Vector3 {
         T x, y, z;
-        Vector3(T x, T y, T z) {
-            this->x=x; this->y=y; this->z=z;
-        }
-        Vector3() {x=y=z=(T)0;}
+        constexpr Vector3(T x, T y, T z) : x(x), y(y), z(z) {}
+        constexpr Vector3() : x((T)0), y((T)0), z((T)0) {}
+    #ifdef LINA_EXPR
+        // Evaluates an expression (see 'Expression Templates').
+        template <typename E, typename = typename std::enable_if<expr::is_node<E>::value && E::size == 3>::type>
+        constexpr Vector3(const E& e) : x((T)e.template get<0>()), y((T)e.template get<1>()), z((T)e.template get<2>()) {}
+    #endif
  
-        void nullify() {x=y=z=(T)0;}
+        LINA_CONSTEXPR14 void nullify() {x=y=z=(T)0;}
  
-        Vector3<T> operator-() {
+        constexpr Vector3<T> operator-() const {
             return Vector3<T>(-x, -y, -z);
         }
  
-        Vector3<T> operator+(Vector3<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector3<T> operator+(Vector3<T> v) const {
             return Vector3<T>(x+v.x, y+v.y, z+v.z);
         }
-        Vector3<T> operator+(T v) {
+        constexpr Vector3<T> operator+(T v) const {
             return Vector3<T>(x+v, y+v, z+v);
         }
-        void operator+=(Vector3<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator+=(Vector3<T> v) {
             x+=v.x; y+=v.y; z+=v.z; 
         }
-        void operator+=(T v) {
+        LINA_CONSTEXPR14 void operator+=(T v) {
             x+=v; y+=v; z+=v;
         }
  
-        Vector3<T> operator-(Vector3<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector3<T> operator-(Vector3<T> v) const {
             return Vector3<T>(x-v.x, y-v.y, z-v.z);
         }
-        Vector3<T> operator-(T v) {
+        constexpr Vector3<T> operator-(T v) const {
             return Vector3<T>(x-v, y-v, z-v);
         }
-        void operator-=(Vector3<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator-=(Vector3<T> v) {
             x-=v.x; y-=v.y; z-=v.z;
         }
-        void operator-=(T v) {
+        LINA_CONSTEXPR14 void operator-=(T v) {
             x-=v; y-=v; z-=v;
         }
  
-        Vector3<T> operator*(Vector3<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector3<T> operator*(Vector3<T> v) const {
             return Vector3<T>(x*v.x, y*v.y, z*v.z);
         }
-        Vector3<T> operator*(T v) {
+        constexpr Vector3<T> operator*(T v) const {
             return Vector3<T>(x*v, y*v, z*v);
         }
-        void operator*=(Vector3<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator*=(Vector3<T> v) {
             x*=v.x; y*=v.y; z*=v.z;
         }
-        void operator*=(T v) {
+        LINA_CONSTEXPR14 void operator*=(T v) {
             x*=v; y*=v; z*=v;
         }
  
-        Vector3<T> operator/(Vector3<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector3<T> operator/(Vector3<T> v) const {
             return Vector3<T>(x/v.x, y/v.y, z/v.z);
         }
-        Vector3<T> operator/(T v) {
+        constexpr Vector3<T> operator/(T v) const {
             return Vector3<T>(x/v, y/v, z/v);
         }
-        void operator/=(Vector3<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator/=(Vector3<T> v) {
             x/=v.x; y/=v.y; z/=v.z; 
         }
-        void operator/=(T v) {
+        LINA_CONSTEXPR14 void operator/=(T v) {
             x/=v; y/=v; z/=v;
         }
  
-        bool operator==(Vector3<T> o) const {
+        constexpr bool operator==(Vector3<T> o) const {
             return this->x==o.x && this->y==o.y && this->z==o.z;
         }
  
-        void operator=(Vector3<T> v) {
-            x=v.x; y=v.y; z=v.z;
-        }
- 
-        float length() {
-            return sqrt(x * x + y * y + z * z);
+        template <typename P = precise>
+        float length() const {
+            return P::sqrt(x * x + y * y + z * z);
         }
  
+        template <typename P = precise>
         void normalize() {
-            this->operator/=(length());
+            *this = normalized<P>();
         }
  
-        Vector3<T> normalized() {
-            return this->operator/(length());
+        template <typename P = precise>
+        Vector3<T> normalized() const {
+            return P::normalized(*this);
         }
  
-        Vector3<T> cross(Vector3<T> other) {
+        constexpr Vector3<T> cross(Vector3<T> other) const {
             return Vector3<T>(y*other.z - z*other.y, z*other.x - x*other.z, x*other.y - y*other.x);
         }
         
         //template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
-        static Vector3<T> cross(Vector3<T> a, Vector3<T> b) {
+        static constexpr Vector3<T> cross(Vector3<T> a, Vector3<T> b) {
             return Vector3<T>(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x);
         }
  
-        float dot(Vector3<T> other) {
+        constexpr float dot(Vector3<T> other) const {
             return x * other.x + y * other.y + z * other.z;
         }
  
         //template <typename _T, typename = typename std::enable_if<std::is_arithmetic<_T>::value, T>::type>
-        static float dot(Vector3<T> a, Vector3<T> b) {
+        static constexpr float dot(Vector3<T> a, Vector3<T> b) {
             return a.x * b.x + a.y * b.y + a.z * b.z;
         }
  
         template <typename _T, typename = typename std::enable_if<std::is_arithmetic<_T>::value, _T>::type>
-        operator Vector3<_T>() const {
+        constexpr operator Vector3<_T>() const {
             return Vector3<_T>((_T)x, (_T)y, (_T)z);
         }
 
@@ -321,103 +777,112 @@ namespace lina {
     template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
     struct Vector4 {
         T x, y, z, w;
-        Vector4(T x, T y, T z, T w = (T)1) {
-            this->x=x; this->y=y; this->z=z; this->w=w;
-        }
-        Vector4(Vector3<T> v, T w = (T)1) {
-            x=v.x; y=v.y; z=v.z; this->w=w;
-        }
-        Vector4() {x=y=z=(T)0;w=(T)1;}
+        constexpr Vector4(T x, T y, T z, T w = (T)1) : x(x), y(y), z(z), w(w) {}
+        constexpr Vector4(Vector3<T> v, T w = (T)1) : x(v.x), y(v.y), z(v.z), w(w) {}
+        constexpr Vector4() : x((T)0), y((T)0), z((T)0), w((T)1) {}
+    #ifdef LINA_EXPR
+        // Evaluates an expression (see 'Expression Templates').
+        template <typename E, typename = typename std::enable_if<expr::is_node<E>::value && E::size == 4>::type>
+        constexpr Vector4(const E& e) : x((T)e.template get<0>()), y((T)e.template get<1>()),
+            z((T)e.template get<2>()), w((T)e.template get<3>()) {}
+    #endif
  
-        void nullify() {x=y=z=w=(T)0;}
+        LINA_CONSTEXPR14 void nullify() {x=y=z=w=(T)0;}
  
-        Vector4<T> operator-() {
+        constexpr Vector4<T> operator-() const {
             return Vector4<T>(-x, -y, -z, -w);
         }
  
-        Vector4<T> operator+(Vector3<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector4<T> operator+(Vector4<T> v) const {
             return Vector4<T>(x+v.x, y+v.y, z+v.z, w+v.w);
         }
-        Vector4<T> operator+(T v) {
+        constexpr Vector4<T> operator+(T v) const {
             return Vector4<T>(x+v, y+v, z+v, w+v);
         }
-        void operator+=(Vector4<T> v) {
-            x+=v.x; y+=v.y; z+=v.z; 
+    #endif
+        LINA_CONSTEXPR14 void operator+=(Vector4<T> v) {
+            x+=v.x; y+=v.y; z+=v.z; w+=v.w;
         }
-        void operator+=(T v) {
-            x+=v; y+=v; z+=v;
+        LINA_CONSTEXPR14 void operator+=(T v) {
+            x+=v; y+=v; z+=v; w+=v;
         }
  
-        Vector4<T> operator-(Vector4<T> v) {
-            return Vector4<T>(x-v.x, y-v.y, z-v.z, w-z.w);
+    #ifndef LINA_EXPR
+        constexpr Vector4<T> operator-(Vector4<T> v) const {
+            return Vector4<T>(x-v.x, y-v.y, z-v.z, w-v.w);
         }
-        Vector4<T> operator-(T v) {
+        constexpr Vector4<T> operator-(T v) const {
             return Vector4<T>(x-v, y-v, z-v, w-v);
         }
-        void operator-=(Vector4<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator-=(Vector4<T> v) {
             x-=v.x; y-=v.y; z-=v.z; w-=v.w;
         }
-        void operator-=(T v) {
-            x-=v; y-=v; z-=v;
+        LINA_CONSTEXPR14 void operator-=(T v) {
+            x-=v; y-=v; z-=v; w-=v;
         }
  
-        Vector4<T> operator*(Vector4<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector4<T> operator*(Vector4<T> v) const {
             return Vector4<T>(x*v.x, y*v.y, z*v.z, w*v.w);
         }
-        Vector4<T> operator*(T v) {
+        constexpr Vector4<T> operator*(T v) const {
             return Vector4<T>(x*v, y*v, z*v, w*v);
         }
-        void operator*=(Vector4<T> v) {
-            x*=v.x; y*=v.y; z*=v.z; w*=v.z;
+    #endif
+        LINA_CONSTEXPR14 void operator*=(Vector4<T> v) {
+            x*=v.x; y*=v.y; z*=v.z; w*=v.w;
         }
-        void operator*=(T v) {
+        LINA_CONSTEXPR14 void operator*=(T v) {
             x*=v; y*=v; z*=v; w*=v;
         }
  
-        Vector4<T> operator/(Vector4<T> v) {
+    #ifndef LINA_EXPR
+        constexpr Vector4<T> operator/(Vector4<T> v) const {
             return Vector4<T>(x/v.x, y/v.y, z/v.z, w/v.w);
         }
-        Vector4<T> operator/(T v) {
+        constexpr Vector4<T> operator/(T v) const {
             return Vector4<T>(x/v, y/v, z/v, w/v);
         }
-        void operator/=(Vector4<T> v) {
+    #endif
+        LINA_CONSTEXPR14 void operator/=(Vector4<T> v) {
             x/=v.x; y/=v.y; z/=v.z; w/=v.w; 
         }
-        void operator/=(T v) {
-            x/=v; y/=v; z/=v;
+        LINA_CONSTEXPR14 void operator/=(T v) {
+            x/=v; y/=v; z/=v; w/=v;
         }
  
-        bool operator==(Vector4<T> o) const {
+        constexpr bool operator==(Vector4<T> o) const {
             return this->x==o.x && this->y==o.y && this->z==o.z && this->w==o.w;
         }
  
-        void operator=(Vector4<T> v) {
-            x=v.x; y=v.y; z=v.z; w=v.w;
-        }
- 
-        float length() {
-            return sqrt(x * x + y * y + z * z + w * w);
+        template <typename P = precise>
+        float length() const {
+            return P::sqrt(x * x + y * y + z * z + w * w);
         }
  
+        template <typename P = precise>
         void normalize() {
-            this->operator/=(length());
+            *this = normalized<P>();
         }
  
-        Vector4<T> normalized() {
-            return this->operator/(length());
+        template <typename P = precise>
+        Vector4<T> normalized() const {
+            return P::normalized(*this);
         }
  
-        float dot(Vector4<T> other) {
+        constexpr float dot(Vector4<T> other) const {
             return x * other.x + y * other.y + z * other.z + w * other.w;
         }
  
         //template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
-        static float dot(Vector4<T> a, Vector4<T> b) {
-            return a.x * b.y + a.y * b.y + a.z * b.z + a.w * b.w;
+        static constexpr float dot(Vector4<T> a, Vector4<T> b) {
+            return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
         }
  
         template <typename _T, typename = typename std::enable_if<std::is_arithmetic<_T>::value, _T>::type>
-        operator Vector4<_T>() const {
+        constexpr operator Vector4<_T>() const {
             return Vector4<_T>((_T)x, (_T)y, (_T)z, (_T)w);
         }
  
@@ -439,24 +904,15 @@ namespace lina {
     template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type>
     struct Rect {
         T x, y, w, h;
-        Rect(T x, T y, T w, T h) {
-            this->x=x;
-            this->y=y;
-            this->w=w;
-            this->h=h;
-        }
-        Rect() {x=y=w=h=(T)0;}
+        constexpr Rect(T x, T y, T w, T h) : x(x), y(y), w(w), h(h) {}
+        constexpr Rect() : x((T)0), y((T)0), w((T)0), h((T)0) {}
  
-        bool operator==(Rect<T> o) const {
+        constexpr bool operator==(Rect<T> o) const {
             return x==o.x && y==o.y && w==o.w && h==o.h;
         }
  
-        void operator=(Rect<T> v) {
-            x=v.x; y=v.y; w=v.w; h=v.h;
-        }
- 
         template <typename _T, typename = typename std::enable_if<std::is_arithmetic<_T>::value, _T>::type>
-        operator Rect<_T>() const {
+        constexpr operator Rect<_T>() const {
             return Rect<_T>((_T)x, (_T)y, (_T)w, (_T)h);
         }
  
@@ -485,37 +941,1043 @@ namespace lina {
     typedef Vector3<unsigned> uvec3;
     typedef Vector2<unsigned> uvec2;
 
+    // A pointer and a size, the same idea as std::span but without needing C++20.
+    // Can be made from a pointer and a size, a C array or anything with data() and size() (std::vector, std::array, ...).
+    template <typename T>
+    struct span {
+        T* ptr;
+        size_t count;
+
+        span() noexcept : ptr(nullptr), count(0) {}
+        span(T* p, size_t n) noexcept : ptr(p), count(n) {}
+        template <size_t N>
+        span(T (&a)[N]) noexcept : ptr(a), count(N) {}
+        // The element size has to match too, so an array of mat3a can't turn into a span<mat3>.
+        template <typename C, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<C>::type, span>::value &&
+            std::is_convertible<decltype(std::declval<C&>().data()), T*>::value &&
+            sizeof(*std::declval<C&>().data()) == sizeof(T)>::type>
+        span(C&& c) noexcept : ptr(c.data()), count(c.size()) {}
+
+        T* data() const noexcept { return ptr; }
+        size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+        T& operator[](size_t i) const noexcept { return ptr[i]; }
+        T* begin() const noexcept { return ptr; }
+        T* end() const noexcept { return ptr + count; }
+
+        span<T> subspan(size_t offset, size_t n) const noexcept { return span<T>(ptr + offset, n); }
+    };
+
+    /*
+        SIMD kernels
+    */
+    // All of these work on row-major float arrays, which is how the matrix structs below lay out
+    // their members (_00, _01, _02, ... _33). The result pointer is allowed to be the same as any
+    // of the inputs.
+    namespace detail {
+        // Scalar reference kernels.
+        inline void mat4_mul_scalar(const float* a, const float* b, float* r) noexcept {
+            float t[16];
+            for (int i = 0; i < 4; i++)
+                for (int j = 0; j < 4; j++)
+                    t[i*4+j] = a[i*4+0] * b[0*4+j] + a[i*4+1] * b[1*4+j] + a[i*4+2] * b[2*4+j] + a[i*4+3] * b[3*4+j];
+            for (int i = 0; i < 16; i++) r[i] = t[i];
+        }
+
+        inline void mat4_mul_vec4_scalar(const float* m, const float* v, float* r) noexcept {
+            float t[4];
+            for (int i = 0; i < 4; i++)
+                t[i] = m[i*4+0] * v[0] + m[i*4+1] * v[1] + m[i*4+2] * v[2] + m[i*4+3] * v[3];
+            r[0] = t[0]; r[1] = t[1]; r[2] = t[2]; r[3] = t[3];
+        }
+
+        inline void mat4_transpose_scalar(const float* m, float* r) noexcept {
+            float t[16];
+            for (int i = 0; i < 4; i++)
+                for (int j = 0; j < 4; j++)
+                    t[j*4+i] = m[i*4+j];
+            for (int i = 0; i < 16; i++) r[i] = t[i];
+        }
+
+        inline void mat3_mul_scalar(const float* a, const float* b, float* r) noexcept {
+            float t[9];
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    t[i*3+j] = a[i*3+0] * b[0*3+j] + a[i*3+1] * b[1*3+j] + a[i*3+2] * b[2*3+j];
+            for (int i = 0; i < 9; i++) r[i] = t[i];
+        }
+
+        inline void mat3_mul_vec3_scalar(const float* m, const float* v, float* r) noexcept {
+            float t[3];
+            for (int i = 0; i < 3; i++)
+                t[i] = m[i*3+0] * v[0] + m[i*3+1] * v[1] + m[i*3+2] * v[2];
+            r[0] = t[0]; r[1] = t[1]; r[2] = t[2];
+        }
+
+        inline void mat3_transpose_scalar(const float* m, float* r) noexcept {
+            float t[9];
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    t[j*3+i] = m[i*3+j];
+            for (int i = 0; i < 9; i++) r[i] = t[i];
+        }
+
+        // Quaternions are x, y, z, w.
+        inline void quat_mul_scalar(const float* a, const float* b, float* r) noexcept {
+            float x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+            float y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+            float z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+            float w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+            r[0] = x; r[1] = y; r[2] = z; r[3] = w;
+        }
+
+        // v + w * t + cross(q, t) with t = 2 * cross(q, v), for a unit quaternion that's q * v * q^-1.
+        inline void quat_rotate_scalar(const float* q, const float* v, float* r) noexcept {
+            float tx = 2.f * (q[1] * v[2] - q[2] * v[1]);
+            float ty = 2.f * (q[2] * v[0] - q[0] * v[2]);
+            float tz = 2.f * (q[0] * v[1] - q[1] * v[0]);
+            float x = v[0] + q[3] * tx + (q[1] * tz - q[2] * ty);
+            float y = v[1] + q[3] * ty + (q[2] * tx - q[0] * tz);
+            float z = v[2] + q[3] * tz + (q[0] * ty - q[1] * tx);
+            r[0] = x; r[1] = y; r[2] = z;
+        }
+
+        // 3x4 affine matrices, the bottom row is always 0 0 0 1 so it isn't stored.
+        inline void affine3_mul_scalar(const float* a, const float* b, float* r) noexcept {
+            float t[12];
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++)
+                    t[i*4+j] = a[i*4+0] * b[0*4+j] + a[i*4+1] * b[1*4+j] + a[i*4+2] * b[2*4+j];
+                t[i*4+3] = a[i*4+0] * b[3] + a[i*4+1] * b[7] + a[i*4+2] * b[11] + a[i*4+3];
+            }
+            for (int i = 0; i < 12; i++) r[i] = t[i];
+        }
+
+        // Inverses, singular matrices give inf/nan.
+        inline void mat4_inverse_scalar(const float* m, float* r) noexcept {
+            float s0 = m[0] * m[5] - m[4] * m[1];
+            float s1 = m[0] * m[6] - m[4] * m[2];
+            float s2 = m[0] * m[7] - m[4] * m[3];
+            float s3 = m[1] * m[6] - m[5] * m[2];
+            float s4 = m[1] * m[7] - m[5] * m[3];
+            float s5 = m[2] * m[7] - m[6] * m[3];
+            float c5 = m[10] * m[15] - m[14] * m[11];
+            float c4 = m[9] * m[15] - m[13] * m[11];
+            float c3 = m[9] * m[14] - m[13] * m[10];
+            float c2 = m[8] * m[15] - m[12] * m[11];
+            float c1 = m[8] * m[14] - m[12] * m[10];
+            float c0 = m[8] * m[13] - m[12] * m[9];
+            float d = 1.f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+            float t[16] = {
+                ( m[5] * c5 - m[6] * c4 + m[7] * c3) * d, (-m[1] * c5 + m[2] * c4 - m[3] * c3) * d,
+                ( m[13] * s5 - m[14] * s4 + m[15] * s3) * d, (-m[9] * s5 + m[10] * s4 - m[11] * s3) * d,
+                (-m[4] * c5 + m[6] * c2 - m[7] * c1) * d, ( m[0] * c5 - m[2] * c2 + m[3] * c1) * d,
+                (-m[12] * s5 + m[14] * s2 - m[15] * s1) * d, ( m[8] * s5 - m[10] * s2 + m[11] * s1) * d,
+                ( m[4] * c4 - m[5] * c2 + m[7] * c0) * d, (-m[0] * c4 + m[1] * c2 - m[3] * c0) * d,
+                ( m[12] * s4 - m[13] * s2 + m[15] * s0) * d, (-m[8] * s4 + m[9] * s2 - m[11] * s0) * d,
+                (-m[4] * c3 + m[5] * c1 - m[6] * c0) * d, ( m[0] * c3 - m[1] * c1 + m[2] * c0) * d,
+                (-m[12] * s3 + m[13] * s1 - m[14] * s0) * d, ( m[8] * s3 - m[9] * s1 + m[10] * s0) * d
+            };
+            for (int i = 0; i < 16; i++) r[i] = t[i];
+        }
+
+        // The inverse transpose of the 3x3 matrix whose rows start at m, m + stride and m + 2*stride,
+        // which is the cofactor matrix divided by the determinant.
+        inline void inverse_transpose3_scalar(const float* m, int stride, float* r) noexcept {
+            const float* a = m; const float* b = m + stride; const float* c = m + 2*stride;
+            float t[9] = {
+                b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0],
+                c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0],
+                a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]
+            };
+            float d = 1.f / (a[0] * t[0] + a[1] * t[1] + a[2] * t[2]);
+            for (int i = 0; i < 9; i++) r[i] = t[i] * d;
+        }
+
+        inline void mat3_inverse_transpose_scalar(const float* m, float* r) noexcept {
+            inverse_transpose3_scalar(m, 3, r);
+        }
+
+        inline void mat3_inverse_scalar(const float* m, float* r) noexcept {
+            float t[9];
+            inverse_transpose3_scalar(m, 3, t);
+            mat3_transpose_scalar(t, r);
+        }
+
+        // Inverse transpose of the top left 3x3 of a mat4, written as a 3x3.
+        inline void mat4_inverse_transpose3x3_scalar(const float* m, float* r) noexcept {
+            inverse_transpose3_scalar(m, 4, r);
+        }
+
+        inline void affine3_inverse_scalar(const float* m, float* r) noexcept {
+            float c[9];
+            inverse_transpose3_scalar(m, 4, c);
+            float tx = m[3], ty = m[7], tz = m[11];
+            for (int i = 0; i < 3; i++) {
+                r[i*4+0] = c[0*3+i];
+                r[i*4+1] = c[1*3+i];
+                r[i*4+2] = c[2*3+i];
+                r[i*4+3] = -(c[0*3+i] * tx + c[1*3+i] * ty + c[2*3+i] * tz);
+            }
+        }
+
+    #if LINA_SIMD == LINA_SIMD_NEON
+        typedef float32x4_t f128;
+
+        inline f128 madd(f128 a, f128 b, f128 c) noexcept {
+        #if LINA_SIMD_FMA
+            return vfmaq_f32(c, a, b);
+        #else
+            return vaddq_f32(vmulq_f32(a, b), c);
+        #endif
+        }
+
+        template <int I>
+        inline f128 splat(f128 v) noexcept {
+            return vdupq_n_f32(vgetq_lane_f32(v, I));
+        }
+
+        inline void transpose4(f128& r0, f128& r1, f128& r2, f128& r3) noexcept {
+            float32x4x2_t t01 = vtrnq_f32(r0, r1);
+            float32x4x2_t t23 = vtrnq_f32(r2, r3);
+            r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+            r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+            r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+            r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+        }
+
+        // Loads the 3 rows of a 3x3 matrix, the last lane of each row is garbage.
+        inline void load3x3(const float* m, f128& r0, f128& r1, f128& r2) noexcept {
+            r0 = vld1q_f32(m);
+            r1 = vld1q_f32(m + 3);
+            f128 t = vld1q_f32(m + 5);
+            r2 = vextq_f32(t, t, 1);
+        }
+
+        inline void store3x3(float* m, f128 r0, f128 r1, f128 r2) noexcept {
+            vst1q_f32(m, r0);
+            vst1q_f32(m + 3, r1);
+            vst1_f32(m + 6, vget_low_f32(r2));
+            vst1q_lane_f32(m + 8, r2, 2);
+        }
+
+        inline void mat4_mul(const float* a, const float* b, float* r) noexcept {
+            f128 b0 = vld1q_f32(b), b1 = vld1q_f32(b + 4), b2 = vld1q_f32(b + 8), b3 = vld1q_f32(b + 12);
+            for (int i = 0; i < 4; i++) {
+                f128 ai = vld1q_f32(a + i*4);
+                f128 t = vmulq_f32(splat<0>(ai), b0);
+                t = madd(splat<1>(ai), b1, t);
+                t = madd(splat<2>(ai), b2, t);
+                t = madd(splat<3>(ai), b3, t);
+                vst1q_f32(r + i*4, t);
+            }
+        }
+
+        inline void mat4_mul_vec4(const float* m, const float* v, float* r) noexcept {
+            float32x4x4_t c = vld4q_f32(m);
+            f128 vv = vld1q_f32(v);
+            f128 t = vmulq_f32(c.val[0], splat<0>(vv));
+            t = madd(c.val[1], splat<1>(vv), t);
+            t = madd(c.val[2], splat<2>(vv), t);
+            t = madd(c.val[3], splat<3>(vv), t);
+            vst1q_f32(r, t);
+        }
+
+        inline void mat4_transpose(const float* m, float* r) noexcept {
+            float32x4x4_t c = vld4q_f32(m);
+            vst1q_f32(r, c.val[0]);
+            vst1q_f32(r + 4, c.val[1]);
+            vst1q_f32(r + 8, c.val[2]);
+            vst1q_f32(r + 12, c.val[3]);
+        }
+
+        inline void mat3_mul(const float* a, const float* b, float* r) noexcept {
+            f128 a0, a1, a2, b0, b1, b2;
+            load3x3(a, a0, a1, a2);
+            load3x3(b, b0, b1, b2);
+            f128 r0 = madd(splat<2>(a0), b2, madd(splat<1>(a0), b1, vmulq_f32(splat<0>(a0), b0)));
+            f128 r1 = madd(splat<2>(a1), b2, madd(splat<1>(a1), b1, vmulq_f32(splat<0>(a1), b0)));
+            f128 r2 = madd(splat<2>(a2), b2, madd(splat<1>(a2), b1, vmulq_f32(splat<0>(a2), b0)));
+            store3x3(r, r0, r1, r2);
+        }
+
+        inline void mat3_mul_vec3(const float* m, const float* v, float* r) noexcept {
+            f128 c0, c1, c2, c3 = vdupq_n_f32(0.f);
+            load3x3(m, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            f128 t = madd(c2, vdupq_n_f32(v[2]), madd(c1, vdupq_n_f32(v[1]), vmulq_f32(c0, vdupq_n_f32(v[0]))));
+            vst1_f32(r, vget_low_f32(t));
+            vst1q_lane_f32(r + 2, t, 2);
+        }
+
+        inline void mat3_transpose(const float* m, float* r) noexcept {
+            f128 c0, c1, c2, c3 = vdupq_n_f32(0.f);
+            load3x3(m, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void quat_mul(const float* a, const float* b, float* r) noexcept {
+            const float32x4_t s1 = {1.f, -1.f, 1.f, -1.f}, s2 = {1.f, 1.f, -1.f, -1.f}, s3 = {-1.f, 1.f, 1.f, -1.f};
+            f128 va = vld1q_f32(a), vb = vld1q_f32(b);
+            f128 zwxy = vextq_f32(vb, vb, 2);
+            f128 t = vmulq_f32(splat<3>(va), vb);
+            t = madd(splat<0>(va), vmulq_f32(vrev64q_f32(zwxy), s1), t);
+            t = madd(splat<1>(va), vmulq_f32(zwxy, s2), t);
+            t = madd(splat<2>(va), vmulq_f32(vrev64q_f32(vb), s3), t);
+            vst1q_f32(r, t);
+        }
+
+        // cross product of the first 3 lanes, lane 3 is garbage.
+        inline f128 cross3(f128 a, f128 b) noexcept {
+            float x[4], y[4];
+            vst1q_f32(x, a); vst1q_f32(y, b);
+            f128 a_yzx = {x[1], x[2], x[0], x[3]}, b_yzx = {y[1], y[2], y[0], y[3]};
+            f128 c = vsubq_f32(vmulq_f32(a, b_yzx), vmulq_f32(a_yzx, b));
+            vst1q_f32(x, c);
+            f128 r = {x[1], x[2], x[0], x[3]};
+            return r;
+        }
+
+        inline void quat_rotate(const float* q, const float* v, float* r) noexcept {
+            f128 vq = vld1q_f32(q);
+            f128 vv = {v[0], v[1], v[2], 0.f};
+            f128 t = vmulq_f32(cross3(vq, vv), vdupq_n_f32(2.f));
+            f128 res = vaddq_f32(madd(splat<3>(vq), t, vv), cross3(vq, t));
+            vst1_f32(r, vget_low_f32(res));
+            vst1q_lane_f32(r + 2, res, 2);
+        }
+
+        inline void affine3_mul(const float* a, const float* b, float* r) noexcept {
+            const uint32x4_t w_only = {0, 0, 0, 0xFFFFFFFFu};
+            f128 b0 = vld1q_f32(b), b1 = vld1q_f32(b + 4), b2 = vld1q_f32(b + 8);
+            for (int i = 0; i < 3; i++) {
+                f128 ai = vld1q_f32(a + i*4);
+                f128 t = vmulq_f32(splat<0>(ai), b0);
+                t = madd(splat<1>(ai), b1, t);
+                t = madd(splat<2>(ai), b2, t);
+                t = vaddq_f32(t, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(ai), w_only)));
+                vst1q_f32(r + i*4, t);
+            }
+        }
+
+        // NEON doesn't have cheap arbitrary shuffles, so the mat4 inverse uses the scalar kernel.
+        inline void mat4_inverse(const float* m, float* r) noexcept { mat4_inverse_scalar(m, r); }
+
+        // Rows of the inverse transpose of the 3x3 matrix in r0, r1, r2 (see inverse_transpose3_scalar).
+        inline void inverse_transpose3(f128 r0, f128 r1, f128 r2, f128& c0, f128& c1, f128& c2) noexcept {
+            c0 = cross3(r1, r2);
+            c1 = cross3(r2, r0);
+            c2 = cross3(r0, r1);
+            f128 d = vmulq_f32(r0, c0);
+            d = vdupq_n_f32(1.f / (vgetq_lane_f32(d, 0) + vgetq_lane_f32(d, 1) + vgetq_lane_f32(d, 2)));
+            c0 = vmulq_f32(c0, d);
+            c1 = vmulq_f32(c1, d);
+            c2 = vmulq_f32(c2, d);
+        }
+
+        inline void mat3_inverse_transpose(const float* m, float* r) noexcept {
+            f128 r0, r1, r2, c0, c1, c2;
+            load3x3(m, r0, r1, r2);
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void mat3_inverse(const float* m, float* r) noexcept {
+            f128 r0, r1, r2, c0, c1, c2, c3 = vdupq_n_f32(0.f);
+            load3x3(m, r0, r1, r2);
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void mat4_inverse_transpose3x3(const float* m, float* r) noexcept {
+            f128 c0, c1, c2;
+            inverse_transpose3(vld1q_f32(m), vld1q_f32(m + 4), vld1q_f32(m + 8), c0, c1, c2);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void affine3_inverse(const float* m, float* r) noexcept {
+            f128 r0 = vld1q_f32(m), r1 = vld1q_f32(m + 4), r2 = vld1q_f32(m + 8);
+            f128 c0, c1, c2, c3 = vdupq_n_f32(0.f);
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            // -(inverse * translation), the columns of the inverse are c0, c1, c2.
+            f128 t = vnegq_f32(madd(c2, splat<3>(r2), madd(c1, splat<3>(r1), vmulq_f32(c0, splat<3>(r0)))));
+            transpose4(c0, c1, c2, c3);
+            vst1q_f32(r, vsetq_lane_f32(vgetq_lane_f32(t, 0), c0, 3));
+            vst1q_f32(r + 4, vsetq_lane_f32(vgetq_lane_f32(t, 1), c1, 3));
+            vst1q_f32(r + 8, vsetq_lane_f32(vgetq_lane_f32(t, 2), c2, 3));
+        }
+    #elif LINA_SIMD != LINA_SIMD_SCALAR
+        typedef __m128 f128;
+
+        inline f128 madd(f128 a, f128 b, f128 c) noexcept {
+        #if LINA_SIMD_FMA
+            return _mm_fmadd_ps(a, b, c);
+        #else
+            return _mm_add_ps(_mm_mul_ps(a, b), c);
+        #endif
+        }
+
+        template <int I>
+        inline f128 splat(f128 v) noexcept {
+            return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I));
+        }
+
+        inline void transpose4(f128& r0, f128& r1, f128& r2, f128& r3) noexcept {
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        }
+
+        // Loads the 3 rows of a 3x3 matrix, the last lane of each row is garbage.
+        inline void load3x3(const float* m, f128& r0, f128& r1, f128& r2) noexcept {
+            r0 = _mm_loadu_ps(m);
+            r1 = _mm_loadu_ps(m + 3);
+            f128 t = _mm_loadu_ps(m + 5);
+            r2 = _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 3, 2, 1));
+        }
+
+        inline void store3x3(float* m, f128 r0, f128 r1, f128 r2) noexcept {
+            _mm_storeu_ps(m, r0);
+            _mm_storeu_ps(m + 3, r1);
+            _mm_storel_pi((__m64*)(m + 6), r2);
+            _mm_store_ss(m + 8, _mm_movehl_ps(r2, r2));
+        }
+
+        inline void mat4_mul(const float* a, const float* b, float* r) noexcept {
+        #if LINA_SIMD >= LINA_SIMD_AVX
+            // Two rows of the result per instruction, every row of b is in both halves.
+            __m256 b0 = _mm256_broadcast_ps((const __m128*)(b));
+            __m256 b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+            __m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+            __m256 b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+            __m256 a01 = _mm256_loadu_ps(a);
+            __m256 a23 = _mm256_loadu_ps(a + 8);
+            __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+            __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+        #if LINA_SIMD_FMA
+            r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1, r01);
+            r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1, r23);
+            r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2, r01);
+            r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2, r23);
+            r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3, r01);
+            r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3, r23);
+        #else
+            r01 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1), r01);
+            r23 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1), r23);
+            r01 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2), r01);
+            r23 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2), r23);
+            r01 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3), r01);
+            r23 = _mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3), r23);
+        #endif
+            _mm256_storeu_ps(r, r01);
+            _mm256_storeu_ps(r + 8, r23);
+        #else
+            f128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+            for (int i = 0; i < 4; i++) {
+                f128 ai = _mm_loadu_ps(a + i*4);
+                f128 t = _mm_mul_ps(splat<0>(ai), b0);
+                t = madd(splat<1>(ai), b1, t);
+                t = madd(splat<2>(ai), b2, t);
+                t = madd(splat<3>(ai), b3, t);
+                _mm_storeu_ps(r + i*4, t);
+            }
+        #endif
+        }
+
+        inline void mat4_mul_vec4(const float* m, const float* v, float* r) noexcept {
+            f128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+            transpose4(c0, c1, c2, c3);
+            f128 vv = _mm_loadu_ps(v);
+            f128 t = _mm_mul_ps(c0, splat<0>(vv));
+            t = madd(c1, splat<1>(vv), t);
+            t = madd(c2, splat<2>(vv), t);
+            t = madd(c3, splat<3>(vv), t);
+            _mm_storeu_ps(r, t);
+        }
+
+        inline void mat4_transpose(const float* m, float* r) noexcept {
+            f128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+            transpose4(c0, c1, c2, c3);
+            _mm_storeu_ps(r, c0);
+            _mm_storeu_ps(r + 4, c1);
+            _mm_storeu_ps(r + 8, c2);
+            _mm_storeu_ps(r + 12, c3);
+        }
+
+        inline void mat3_mul(const float* a, const float* b, float* r) noexcept {
+            f128 a0, a1, a2, b0, b1, b2;
+            load3x3(a, a0, a1, a2);
+            load3x3(b, b0, b1, b2);
+            f128 r0 = madd(splat<2>(a0), b2, madd(splat<1>(a0), b1, _mm_mul_ps(splat<0>(a0), b0)));
+            f128 r1 = madd(splat<2>(a1), b2, madd(splat<1>(a1), b1, _mm_mul_ps(splat<0>(a1), b0)));
+            f128 r2 = madd(splat<2>(a2), b2, madd(splat<1>(a2), b1, _mm_mul_ps(splat<0>(a2), b0)));
+            store3x3(r, r0, r1, r2);
+        }
+
+        inline void mat3_mul_vec3(const float* m, const float* v, float* r) noexcept {
+            f128 c0, c1, c2, c3 = _mm_setzero_ps();
+            load3x3(m, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            f128 t = madd(c2, _mm_set1_ps(v[2]), madd(c1, _mm_set1_ps(v[1]), _mm_mul_ps(c0, _mm_set1_ps(v[0]))));
+            _mm_storel_pi((__m64*)r, t);
+            _mm_store_ss(r + 2, _mm_movehl_ps(t, t));
+        }
+
+        inline void mat3_transpose(const float* m, float* r) noexcept {
+            f128 c0, c1, c2, c3 = _mm_setzero_ps();
+            load3x3(m, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void quat_mul(const float* a, const float* b, float* r) noexcept {
+            const f128 s1 = _mm_setr_ps(0.f, -0.f, 0.f, -0.f), s2 = _mm_setr_ps(0.f, 0.f, -0.f, -0.f), s3 = _mm_setr_ps(-0.f, 0.f, 0.f, -0.f);
+            f128 va = _mm_loadu_ps(a), vb = _mm_loadu_ps(b);
+            f128 t = _mm_mul_ps(splat<3>(va), vb);
+            t = madd(splat<0>(va), _mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(0, 1, 2, 3)), s1), t);
+            t = madd(splat<1>(va), _mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(1, 0, 3, 2)), s2), t);
+            t = madd(splat<2>(va), _mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 3, 0, 1)), s3), t);
+            _mm_storeu_ps(r, t);
+        }
+
+        // cross product of the first 3 lanes, lane 3 is garbage.
+        inline f128 cross3(f128 a, f128 b) noexcept {
+            f128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+            f128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+            f128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+            return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+        }
+
+        inline void quat_rotate(const float* q, const float* v, float* r) noexcept {
+            f128 vq = _mm_loadu_ps(q);
+            f128 vv = _mm_setr_ps(v[0], v[1], v[2], 0.f);
+            f128 t = _mm_mul_ps(cross3(vq, vv), _mm_set1_ps(2.f));
+            f128 res = _mm_add_ps(madd(splat<3>(vq), t, vv), cross3(vq, t));
+            _mm_storel_pi((__m64*)r, res);
+            _mm_store_ss(r + 2, _mm_movehl_ps(res, res));
+        }
+
+        inline void affine3_mul(const float* a, const float* b, float* r) noexcept {
+            const f128 w_only = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+            f128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8);
+            for (int i = 0; i < 3; i++) {
+                f128 ai = _mm_loadu_ps(a + i*4);
+                f128 t = _mm_mul_ps(splat<0>(ai), b0);
+                t = madd(splat<1>(ai), b1, t);
+                t = madd(splat<2>(ai), b2, t);
+                t = _mm_add_ps(t, _mm_and_ps(ai, w_only));
+                _mm_storeu_ps(r + i*4, t);
+            }
+        }
+
+        template <int X, int Y, int Z, int W>
+        inline f128 shuffle(f128 a, f128 b) noexcept {
+            return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+        }
+
+        // 2x2 blocks of a mat4 stored as (_00, _01, _10, _11) in one register.
+        // block2_mul is a * b, block2_adj_mul is adj(a) * b and block2_mul_adj is a * adj(b).
+        inline f128 block2_mul(f128 a, f128 b) noexcept {
+            return _mm_add_ps(_mm_mul_ps(a, shuffle<0, 3, 0, 3>(b, b)), _mm_mul_ps(shuffle<1, 0, 3, 2>(a, a), shuffle<2, 1, 2, 1>(b, b)));
+        }
+        inline f128 block2_adj_mul(f128 a, f128 b) noexcept {
+            return _mm_sub_ps(_mm_mul_ps(shuffle<3, 3, 0, 0>(a, a), b), _mm_mul_ps(shuffle<1, 1, 2, 2>(a, a), shuffle<2, 3, 0, 1>(b, b)));
+        }
+        inline f128 block2_mul_adj(f128 a, f128 b) noexcept {
+            return _mm_sub_ps(_mm_mul_ps(a, shuffle<3, 0, 3, 0>(b, b)), _mm_mul_ps(shuffle<1, 0, 3, 2>(a, a), shuffle<2, 1, 2, 1>(b, b)));
+        }
+
+        // Blockwise inverse: the mat4 is split into the 2x2 blocks A B / C D and the inverse is
+        // built from their adjugates, which needs a lot fewer shuffles than the 4x4 cofactors.
+        inline void mat4_inverse(const float* m, float* r) noexcept {
+            f128 r0 = _mm_loadu_ps(m), r1 = _mm_loadu_ps(m + 4), r2 = _mm_loadu_ps(m + 8), r3 = _mm_loadu_ps(m + 12);
+            f128 A = _mm_movelh_ps(r0, r1), B = _mm_movehl_ps(r1, r0);
+            f128 C = _mm_movelh_ps(r2, r3), D = _mm_movehl_ps(r3, r2);
+
+            // (|A|, |B|, |C|, |D|)
+            f128 dets = _mm_sub_ps(
+                _mm_mul_ps(shuffle<0, 2, 0, 2>(r0, r2), shuffle<1, 3, 1, 3>(r1, r3)),
+                _mm_mul_ps(shuffle<1, 3, 1, 3>(r0, r2), shuffle<0, 2, 0, 2>(r1, r3))
+            );
+            f128 det_a = splat<0>(dets), det_b = splat<1>(dets), det_c = splat<2>(dets), det_d = splat<3>(dets);
+
+            f128 d_c = block2_adj_mul(D, C);
+            f128 a_b = block2_adj_mul(A, B);
+            f128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), block2_mul(B, d_c));
+            f128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), block2_mul(C, a_b));
+            f128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), block2_mul_adj(D, a_b));
+            f128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), block2_mul_adj(A, d_c));
+
+            // |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+            f128 tr = _mm_mul_ps(a_b, shuffle<0, 2, 1, 3>(d_c, d_c));
+            tr = _mm_add_ps(tr, shuffle<1, 0, 3, 2>(tr, tr));
+            tr = _mm_add_ps(tr, shuffle<2, 3, 0, 1>(tr, tr));
+            f128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+
+            f128 rdet = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+            x = _mm_mul_ps(x, rdet);
+            y = _mm_mul_ps(y, rdet);
+            z = _mm_mul_ps(z, rdet);
+            w = _mm_mul_ps(w, rdet);
+
+            // x, y, z, w are the adjugates of the blocks, so they get transposed back on the way out.
+            _mm_storeu_ps(r, shuffle<3, 1, 3, 1>(x, y));
+            _mm_storeu_ps(r + 4, shuffle<2, 0, 2, 0>(x, y));
+            _mm_storeu_ps(r + 8, shuffle<3, 1, 3, 1>(z, w));
+            _mm_storeu_ps(r + 12, shuffle<2, 0, 2, 0>(z, w));
+        }
+
+        // Rows of the inverse transpose of the 3x3 matrix in r0, r1, r2 (see inverse_transpose3_scalar).
+        inline void inverse_transpose3(f128 r0, f128 r1, f128 r2, f128& c0, f128& c1, f128& c2) noexcept {
+            c0 = cross3(r1, r2);
+            c1 = cross3(r2, r0);
+            c2 = cross3(r0, r1);
+            f128 d = _mm_mul_ps(r0, c0);
+            d = _mm_div_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_add_ps(splat<0>(d), splat<1>(d)), splat<2>(d)));
+            c0 = _mm_mul_ps(c0, d);
+            c1 = _mm_mul_ps(c1, d);
+            c2 = _mm_mul_ps(c2, d);
+        }
+
+        inline void mat3_inverse_transpose(const float* m, float* r) noexcept {
+            f128 r0, r1, r2, c0, c1, c2;
+            load3x3(m, r0, r1, r2);
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void mat3_inverse(const float* m, float* r) noexcept {
+            f128 r0, r1, r2, c0, c1, c2, c3 = _mm_setzero_ps();
+            load3x3(m, r0, r1, r2);
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            transpose4(c0, c1, c2, c3);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void mat4_inverse_transpose3x3(const float* m, float* r) noexcept {
+            f128 c0, c1, c2;
+            inverse_transpose3(_mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), c0, c1, c2);
+            store3x3(r, c0, c1, c2);
+        }
+
+        inline void affine3_inverse(const float* m, float* r) noexcept {
+            const f128 w_only = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+            f128 r0 = _mm_loadu_ps(m), r1 = _mm_loadu_ps(m + 4), r2 = _mm_loadu_ps(m + 8);
+            f128 c0, c1, c2, c3 = _mm_setzero_ps();
+            inverse_transpose3(r0, r1, r2, c0, c1, c2);
+            // -(inverse * translation), the columns of the inverse are c0, c1, c2.
+            f128 t = _mm_sub_ps(c3, madd(c2, splat<3>(r2), madd(c1, splat<3>(r1), _mm_mul_ps(c0, splat<3>(r0)))));
+            transpose4(c0, c1, c2, c3);
+            _mm_storeu_ps(r, _mm_or_ps(c0, _mm_and_ps(splat<0>(t), w_only)));
+            _mm_storeu_ps(r + 4, _mm_or_ps(c1, _mm_and_ps(splat<1>(t), w_only)));
+            _mm_storeu_ps(r + 8, _mm_or_ps(c2, _mm_and_ps(splat<2>(t), w_only)));
+        }
+    #else
+        inline void mat4_mul(const float* a, const float* b, float* r) noexcept { mat4_mul_scalar(a, b, r); }
+        inline void mat4_mul_vec4(const float* m, const float* v, float* r) noexcept { mat4_mul_vec4_scalar(m, v, r); }
+        inline void mat4_transpose(const float* m, float* r) noexcept { mat4_transpose_scalar(m, r); }
+        inline void mat3_mul(const float* a, const float* b, float* r) noexcept { mat3_mul_scalar(a, b, r); }
+        inline void mat3_mul_vec3(const float* m, const float* v, float* r) noexcept { mat3_mul_vec3_scalar(m, v, r); }
+        inline void mat3_transpose(const float* m, float* r) noexcept { mat3_transpose_scalar(m, r); }
+        inline void quat_mul(const float* a, const float* b, float* r) noexcept { quat_mul_scalar(a, b, r); }
+        inline void quat_rotate(const float* q, const float* v, float* r) noexcept { quat_rotate_scalar(q, v, r); }
+        inline void affine3_mul(const float* a, const float* b, float* r) noexcept { affine3_mul_scalar(a, b, r); }
+        inline void mat4_inverse(const float* m, float* r) noexcept { mat4_inverse_scalar(m, r); }
+        inline void mat3_inverse(const float* m, float* r) noexcept { mat3_inverse_scalar(m, r); }
+        inline void mat3_inverse_transpose(const float* m, float* r) noexcept { mat3_inverse_transpose_scalar(m, r); }
+        inline void mat4_inverse_transpose3x3(const float* m, float* r) noexcept { mat4_inverse_transpose3x3_scalar(m, r); }
+        inline void affine3_inverse(const float* m, float* r) noexcept { affine3_inverse_scalar(m, r); }
+    #endif
+
+        // floatv is the widest float vector LINA_SIMD has, the bulk kernels (streams, batches and
+        // so on) are written against it so they don't have to be written once per instruction set.
+    #if LINA_SIMD_X86 && LINA_SIMD >= LINA_SIMD_AVX
+        struct floatv { __m256 v; };
+        enum { floatv_width = 8 };
+
+        inline floatv loadv(const float* p) noexcept { return {_mm256_loadu_ps(p)}; }
+        inline void storev(float* p, floatv a) noexcept { _mm256_storeu_ps(p, a.v); }
+        inline floatv setv(float s) noexcept { return {_mm256_set1_ps(s)}; }
+        inline floatv operator+(floatv a, floatv b) noexcept { return {_mm256_add_ps(a.v, b.v)}; }
+        inline floatv operator-(floatv a, floatv b) noexcept { return {_mm256_sub_ps(a.v, b.v)}; }
+        inline floatv operator*(floatv a, floatv b) noexcept { return {_mm256_mul_ps(a.v, b.v)}; }
+        inline floatv operator/(floatv a, floatv b) noexcept { return {_mm256_div_ps(a.v, b.v)}; }
+        inline floatv sqrtv(floatv a) noexcept { return {_mm256_sqrt_ps(a.v)}; }
+        // Hardware estimates of 1 / sqrt(a) and 1 / a, good to about 12 bits.
+        inline floatv rsqrtev(floatv a) noexcept { return {_mm256_rsqrt_ps(a.v)}; }
+        inline floatv rcpev(floatv a) noexcept { return {_mm256_rcp_ps(a.v)}; }
+        inline floatv minv(floatv a, floatv b) noexcept { return {_mm256_min_ps(a.v, b.v)}; }
+        inline floatv maxv(floatv a, floatv b) noexcept { return {_mm256_max_ps(a.v, b.v)}; }
+        inline floatv absv(floatv a) noexcept { return {_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v)}; }
+        // |a| with the sign of b.
+        inline floatv copysignv(floatv a, floatv b) noexcept {
+            const __m256 sign = _mm256_set1_ps(-0.f);
+            return {_mm256_or_ps(_mm256_andnot_ps(sign, a.v), _mm256_and_ps(sign, b.v))};
+        }
+        inline floatv maddv(floatv a, floatv b, floatv c) noexcept {
+        #if LINA_SIMD_FMA
+            return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+        #else
+            return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)};
+        #endif
+        }
+        // bit i is set when lane i of a >= lane i of b.
+        inline unsigned gemaskv(floatv a, floatv b) noexcept { return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+    #elif LINA_SIMD == LINA_SIMD_NEON
+        struct floatv { float32x4_t v; };
+        enum { floatv_width = 4 };
+
+        inline floatv loadv(const float* p) noexcept { return {vld1q_f32(p)}; }
+        inline void storev(float* p, floatv a) noexcept { vst1q_f32(p, a.v); }
+        inline floatv setv(float s) noexcept { return {vdupq_n_f32(s)}; }
+        inline floatv operator+(floatv a, floatv b) noexcept { return {vaddq_f32(a.v, b.v)}; }
+        inline floatv operator-(floatv a, floatv b) noexcept { return {vsubq_f32(a.v, b.v)}; }
+        inline floatv operator*(floatv a, floatv b) noexcept { return {vmulq_f32(a.v, b.v)}; }
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        inline floatv operator/(floatv a, floatv b) noexcept { return {vdivq_f32(a.v, b.v)}; }
+        inline floatv sqrtv(floatv a) noexcept { return {vsqrtq_f32(a.v)}; }
+    #else
+        inline floatv operator/(floatv a, floatv b) noexcept {
+            float x[4], y[4];
+            vst1q_f32(x, a.v); vst1q_f32(y, b.v);
+            for (int i = 0; i < 4; i++) x[i] /= y[i];
+            return {vld1q_f32(x)};
+        }
+        inline floatv sqrtv(floatv a) noexcept {
+            float x[4];
+            vst1q_f32(x, a.v);
+            for (int i = 0; i < 4; i++) x[i] = sqrtf(x[i]);
+            return {vld1q_f32(x)};
+        }
+    #endif
+        // The NEON estimates are only good to about 8 bits, so these do one Newton step right
+        // away to get to the same 12 bits or so as x86.
+        inline floatv rsqrtev(floatv a) noexcept {
+            float32x4_t y = vrsqrteq_f32(a.v);
+            return {vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a.v, y), y))};
+        }
+        inline floatv rcpev(floatv a) noexcept {
+            float32x4_t y = vrecpeq_f32(a.v);
+            return {vmulq_f32(y, vrecpsq_f32(a.v, y))};
+        }
+        inline floatv minv(floatv a, floatv b) noexcept { return {vminq_f32(a.v, b.v)}; }
+        inline floatv maxv(floatv a, floatv b) noexcept { return {vmaxq_f32(a.v, b.v)}; }
+        inline floatv absv(floatv a) noexcept { return {vabsq_f32(a.v)}; }
+        inline floatv copysignv(floatv a, floatv b) noexcept { return {vbslq_f32(vdupq_n_u32(0x80000000u), b.v, a.v)}; }
+        inline floatv maddv(floatv a, floatv b, floatv c) noexcept { return {madd(a.v, b.v, c.v)}; }
+        inline unsigned gemaskv(floatv a, floatv b) noexcept {
+            const uint32x4_t bits = {1, 2, 4, 8};
+            uint32x4_t m = vandq_u32(vcgeq_f32(a.v, b.v), bits);
+        #if defined(__aarch64__) || defined(_M_ARM64)
+            return vaddvq_u32(m);
+        #else
+            uint32x2_t t = vadd_u32(vget_low_u32(m), vget_high_u32(m));
+            return vget_lane_u32(vpadd_u32(t, t), 0);
+        #endif
+        }
+    #elif LINA_SIMD != LINA_SIMD_SCALAR
+        struct floatv { __m128 v; };
+        enum { floatv_width = 4 };
+
+        inline floatv loadv(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+        inline void storev(float* p, floatv a) noexcept { _mm_storeu_ps(p, a.v); }
+        inline floatv setv(float s) noexcept { return {_mm_set1_ps(s)}; }
+        inline floatv operator+(floatv a, floatv b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+        inline floatv operator-(floatv a, floatv b) noexcept { return {_mm_sub_ps(a.v, b.v)}; }
+        inline floatv operator*(floatv a, floatv b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+        inline floatv operator/(floatv a, floatv b) noexcept { return {_mm_div_ps(a.v, b.v)}; }
+        inline floatv sqrtv(floatv a) noexcept { return {_mm_sqrt_ps(a.v)}; }
+        inline floatv rsqrtev(floatv a) noexcept { return {_mm_rsqrt_ps(a.v)}; }
+        inline floatv rcpev(floatv a) noexcept { return {_mm_rcp_ps(a.v)}; }
+        inline floatv minv(floatv a, floatv b) noexcept { return {_mm_min_ps(a.v, b.v)}; }
+        inline floatv maxv(floatv a, floatv b) noexcept { return {_mm_max_ps(a.v, b.v)}; }
+        inline floatv absv(floatv a) noexcept { return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)}; }
+        inline floatv copysignv(floatv a, floatv b) noexcept {
+            const __m128 sign = _mm_set1_ps(-0.f);
+            return {_mm_or_ps(_mm_andnot_ps(sign, a.v), _mm_and_ps(sign, b.v))};
+        }
+        inline floatv maddv(floatv a, floatv b, floatv c) noexcept { return {madd(a.v, b.v, c.v)}; }
+        inline unsigned gemaskv(floatv a, floatv b) noexcept { return (unsigned)_mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)); }
+    #else
+        struct floatv { float v; };
+        enum { floatv_width = 1 };
+
+        inline floatv loadv(const float* p) noexcept { return {*p}; }
+        inline void storev(float* p, floatv a) noexcept { *p = a.v; }
+        inline floatv setv(float s) noexcept { return {s}; }
+        inline floatv operator+(floatv a, floatv b) noexcept { return {a.v + b.v}; }
+        inline floatv operator-(floatv a, floatv b) noexcept { return {a.v - b.v}; }
+        inline floatv operator*(floatv a, floatv b) noexcept { return {a.v * b.v}; }
+        inline floatv operator/(floatv a, floatv b) noexcept { return {a.v / b.v}; }
+        inline floatv sqrtv(floatv a) noexcept { return {sqrtf(a.v)}; }
+        // No estimate instructions here, these are just exact.
+        inline floatv rsqrtev(floatv a) noexcept { return {1.f / sqrtf(a.v)}; }
+        inline floatv rcpev(floatv a) noexcept { return {1.f / a.v}; }
+        inline floatv minv(floatv a, floatv b) noexcept { return {a.v < b.v ? a.v : b.v}; }
+        inline floatv maxv(floatv a, floatv b) noexcept { return {a.v > b.v ? a.v : b.v}; }
+        inline floatv absv(floatv a) noexcept { return {fabsf(a.v)}; }
+        inline floatv copysignv(floatv a, floatv b) noexcept { return {copysignf(a.v, b.v)}; }
+        inline floatv maddv(floatv a, floatv b, floatv c) noexcept { return {a.v * b.v + c.v}; }
+        inline unsigned gemaskv(floatv a, floatv b) noexcept { return a.v >= b.v ? 1u : 0u; }
+    #endif
+
+        // Scalar estimates of 1 / sqrt(x) and 1 / x, same precision as rsqrtev and rcpev.
+        inline float rsqrte(float x) noexcept {
+        #if LINA_SIMD_X86
+            return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            float32x2_t v = vdup_n_f32(x), y = vrsqrte_f32(v);
+            return vget_lane_f32(vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y)), 0);
+        #else
+            return 1.f / sqrtf(x);
+        #endif
+        }
+
+        inline float rcpe(float x) noexcept {
+        #if LINA_SIMD_X86
+            return _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x)));
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            float32x2_t v = vdup_n_f32(x), y = vrecpe_f32(v);
+            return vget_lane_f32(vmul_f32(y, vrecps_f32(v, y)), 0);
+        #else
+            return 1.f / x;
+        #endif
+        }
+    }
+
+    /*
+        Precision policies
+    */
+    // The default, the same results as sqrtf, sinf, cosf and a plain division.
+    struct precise {
+        template <typename T>
+        static float sqrt(T x) noexcept { return (float)::sqrt(x); }
+        static float rsqrt(float x) noexcept { return 1.f / sqrtf(x); }
+        static float recip(float x) noexcept { return 1.f / x; }
+        static float div(float a, float b) noexcept { return a / b; }
+        static void sincos(float radians, float& s, float& c) noexcept {
+            s = sinf(radians);
+            c = cosf(radians);
+        }
+        template <typename V>
+        static V normalized(const V& v) noexcept { return V(v / (decltype(v.x))v.length()); }
+
+        static detail::floatv sqrt(detail::floatv x) noexcept { return detail::sqrtv(x); }
+        static detail::floatv rsqrt(detail::floatv x) noexcept { return detail::setv(1.f) / detail::sqrtv(x); }
+        static detail::floatv div(detail::floatv a, detail::floatv b) noexcept { return a / b; }
+    };
+
+    // Hardware estimates plus a Newton step and polynomial sin/cos, see 'Precision Policies' for the errors.
+    struct fast {
+        static float rsqrt(float x) noexcept {
+            float y = detail::rsqrte(x);
+            return y * (1.5f - 0.5f * x * y * y);
+        }
+        static float recip(float x) noexcept {
+            float y = detail::rcpe(x);
+            return y * (2.f - x * y);
+        }
+        // The square root instruction is already faster than the estimate plus a Newton step, so
+        // this is just sqrtf. The win is in rsqrt, which saves the division after it.
+        static float sqrt(float x) noexcept { return sqrtf(x); }
+        static float div(float a, float b) noexcept { return a * recip(b); }
+
+        static void sincos(float radians, float& s, float& c) noexcept {
+            // radians = j * pi/2 + r with |r| <= pi/4. pi/2 is split into 3 parts with few enough
+            // bits that j * part is exact, so r doesn't lose bits for the larger angles.
+            // Adding and subtracting 1.5 * 2^23 rounds to the nearest integer without leaving the
+            // float registers, and leaves that integer in the low bits.
+            float fj = radians * 0.636619772f + 12582912.f;
+            uint32_t j;
+            memcpy(&j, &fj, 4);
+            fj -= 12582912.f;
+            float r = ((radians - fj * 1.5703125f) - fj * 4.837512969970703125e-4f) - fj * 7.54978995489188216e-8f;
+            float z = r * r;
+            // Minimax polynomials for |r| <= pi/4 (the same ones as Cephes' sinf and cosf).
+            float sr = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+            float cr = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.f;
+            // Every quarter turn swaps sin and cos and flips one of the signs. Done on the bits
+            // since the quadrant is random for random angles and branches would mispredict.
+            uint32_t sb, cb;
+            memcpy(&sb, &sr, 4);
+            memcpy(&cb, &cr, 4);
+            uint32_t swap = 0u - (j & 1);
+            uint32_t sv = ((sb & ~swap) | (cb & swap)) ^ ((j & 2) << 30);
+            uint32_t cv = ((cb & ~swap) | (sb & swap)) ^ (((j + 1) & 2) << 30);
+            memcpy(&s, &sv, 4);
+            memcpy(&c, &cv, 4);
+        }
+        template <typename V>
+        static V normalized(const V& v) noexcept { return V(v * (decltype(v.x))rsqrt(v.dot(v))); }
+
+        static detail::floatv rsqrt(detail::floatv x) noexcept {
+            detail::floatv y = detail::rsqrtev(x);
+            return y * (detail::setv(1.5f) - detail::setv(0.5f) * x * y * y);
+        }
+        static detail::floatv recip(detail::floatv x) noexcept {
+            detail::floatv y = detail::rcpev(x);
+            return y * (detail::setv(2.f) - x * y);
+        }
+        static detail::floatv sqrt(detail::floatv x) noexcept { return detail::sqrtv(x); }
+        static detail::floatv div(detail::floatv a, detail::floatv b) noexcept { return a * recip(b); }
+    };
+
+    // The order the axis rotations are multiplied in, XYZ is rotationX * rotationY * rotationZ
+    // (what mat4::rotation does), so with column vectors Z gets applied first.
+    enum class EulerOrder { XYZ, XZY, YXZ, YZX, ZXY, ZYX };
+
+    namespace detail {
+        // Writes the 3x3 rotation for the Euler angles `radians` to r (row by row), the products of
+        // the three axis matrices worked out by hand so it's one sincos per axis and 12-16 multiplies.
+        template <typename P>
+        inline void euler_rotation(vec3 radians, EulerOrder order, float* r) noexcept {
+            float sx, cx, sy, cy, sz, cz;
+            P::sincos(radians.x, sx, cx);
+            P::sincos(radians.y, sy, cy);
+            P::sincos(radians.z, sz, cz);
+            float a, b;
+            switch (order) {
+            default:
+            case EulerOrder::XYZ:
+                a = sx * sy; b = cx * sy;
+                r[0] = cy * cz;          r[1] = -cy * sz;         r[2] = sy;
+                r[3] = a * cz + cx * sz; r[4] = cx * cz - a * sz; r[5] = -sx * cy;
+                r[6] = sx * sz - b * cz; r[7] = b * sz + sx * cz; r[8] = cx * cy;
+                break;
+            case EulerOrder::XZY:
+                a = cx * sz; b = sx * sz;
+                r[0] = cy * cz;          r[1] = -sz;              r[2] = sy * cz;
+                r[3] = a * cy + sx * sy; r[4] = cx * cz;          r[5] = a * sy - sx * cy;
+                r[6] = b * cy - cx * sy; r[7] = sx * cz;          r[8] = b * sy + cx * cy;
+                break;
+            case EulerOrder::YXZ:
+                a = sx * sy; b = sx * cy;
+                r[0] = cy * cz + a * sz; r[1] = a * cz - cy * sz; r[2] = cx * sy;
+                r[3] = cx * sz;          r[4] = cx * cz;          r[5] = -sx;
+                r[6] = b * sz - sy * cz; r[7] = b * cz + sy * sz; r[8] = cx * cy;
+                break;
+            case EulerOrder::YZX:
+                a = cy * sz; b = sy * sz;
+                r[0] = cy * cz;          r[1] = sx * sy - a * cx; r[2] = a * sx + cx * sy;
+                r[3] = sz;               r[4] = cx * cz;          r[5] = -sx * cz;
+                r[6] = -sy * cz;         r[7] = b * cx + sx * cy; r[8] = cx * cy - b * sx;
+                break;
+            case EulerOrder::ZXY:
+                a = sx * sz; b = sx * cz;
+                r[0] = cy * cz - a * sy; r[1] = -cx * sz;         r[2] = a * cy + sy * cz;
+                r[3] = b * sy + cy * sz; r[4] = cx * cz;          r[5] = sy * sz - b * cy;
+                r[6] = -cx * sy;         r[7] = sx;               r[8] = cx * cy;
+                break;
+            case EulerOrder::ZYX:
+                a = sy * cz; b = sy * sz;
+                r[0] = cy * cz;          r[1] = a * sx - cx * sz; r[2] = a * cx + sx * sz;
+                r[3] = cy * sz;          r[4] = b * sx + cx * cz; r[5] = b * cx - sx * cz;
+                r[6] = -sy;              r[7] = sx * cy;          r[8] = cx * cy;
+                break;
+            }
+        }
+
+        // m = m * r for the top left 3x3 of a matrix with `rows` rows of `stride` floats, only the
+        // first 3 columns change.
+        inline void rotate_rows(float* m, int rows, int stride, const float* r) noexcept {
+            for (int i = 0; i < rows; i++, m += stride) {
+                float m0 = m[0], m1 = m[1], m2 = m[2];
+                m[0] = m0 * r[0] + m1 * r[3] + m2 * r[6];
+                m[1] = m0 * r[1] + m1 * r[4] + m2 * r[7];
+                m[2] = m0 * r[2] + m1 * r[5] + m2 * r[8];
+            }
+        }
+
+        // m = m * (a rotation around one axis), which only mixes columns I and J.
+        template <int I, int J>
+        inline void rotate_columns(float* m, int rows, int stride, float s, float c) noexcept {
+            for (int k = 0; k < rows; k++, m += stride) {
+                float a = m[I], b = m[J];
+                m[I] = a * c + b * s;
+                m[J] = b * c - a * s;
+            }
+        }
+
+    #if LINA_SIMD != LINA_SIMD_SCALAR
+        // The mat4 versions, one row per register. Writing the floats one by one and then reading
+        // the matrix back with vector loads (which is what the next product does) stalls on the
+        // store forwarding, so these are worth it even though they don't save any math.
+    #if LINA_SIMD == LINA_SIMD_NEON
+        inline f128 row_load(const float* p) noexcept { return vld1q_f32(p); }
+        inline void row_store(float* p, f128 v) noexcept { vst1q_f32(p, v); }
+        inline f128 row_mul(f128 a, f128 b) noexcept { return vmulq_f32(a, b); }
+    #else
+        inline f128 row_load(const float* p) noexcept { return _mm_loadu_ps(p); }
+        inline void row_store(float* p, f128 v) noexcept { _mm_storeu_ps(p, v); }
+        inline f128 row_mul(f128 a, f128 b) noexcept { return _mm_mul_ps(a, b); }
+    #endif
+
+        inline void mat4_rotate(float* m, const float* r) noexcept {
+            const float r0[4] = {r[0], r[1], r[2], 0.f};
+            const float r1[4] = {r[3], r[4], r[5], 0.f};
+            const float r2[4] = {r[6], r[7], r[8], 0.f};
+            const float w[4] = {0.f, 0.f, 0.f, 1.f};
+            f128 b0 = row_load(r0), b1 = row_load(r1), b2 = row_load(r2), b3 = row_load(w);
+            for (int i = 0; i < 4; i++, m += 4) {
+                f128 a = row_load(m);
+                f128 t = row_mul(a, b3);
+                t = madd(splat<0>(a), b0, t);
+                t = madd(splat<1>(a), b1, t);
+                t = madd(splat<2>(a), b2, t);
+                row_store(m, t);
+            }
+        }
+
+        template <int I, int J>
+        inline void mat4_rotate_columns(float* m, float s, float c) noexcept {
+            float d[4] = {1.f, 1.f, 1.f, 1.f}, u[4] = {0.f, 0.f, 0.f, 0.f}, v[4] = {0.f, 0.f, 0.f, 0.f};
+            d[I] = d[J] = c;
+            u[I] = s;
+            v[J] = -s;
+            f128 dd = row_load(d), uu = row_load(u), vv = row_load(v);
+            for (int k = 0; k < 4; k++, m += 4) {
+                f128 a = row_load(m);
+                row_store(m, madd(splat<I>(a), vv, madd(splat<J>(a), uu, row_mul(a, dd))));
+            }
+        }
+    #else
+        inline void mat4_rotate(float* m, const float* r) noexcept { rotate_rows(m, 4, 4, r); }
+        template <int I, int J>
+        inline void mat4_rotate_columns(float* m, float s, float c) noexcept { rotate_columns<I, J>(m, 4, 4, s, c); }
+    #endif
+    }
+
     /* 
         Matrices
     */
+    struct mat3;
+
     struct mat4 {
         union {float _00, _m11;}; union {float _01, _m12;}; union {float _02, _m13;}; union {float _03, _m14;};
         union {float _10, _m21;}; union {float _11, _m22;}; union {float _12, _m23;}; union {float _13, _m24;};
         union {float _20, _m31;}; union {float _21, _m32;}; union {float _22, _m33;}; union {float _23, _m34;};
         union {float _30, _m41;}; union {float _31, _m42;}; union {float _32, _m43;}; union {float _33, _m44;};
         
-        inline mat4(
+        inline constexpr mat4(
             float _1_00, float _2_01, float _3_02, float _4_03,
             float _5_10, float _6_11, float _7_12, float _8_13,
             float _9_20, float _10_21, float _11_22, float _12_23,
             float _13_30, float _14_31, float _15_32, float _16_33
-        ) {
-            _00=_1_00;  _01=_2_01;  _02=_3_02;  _03=_4_03;
-            _10=_5_10;  _11=_6_11;  _12=_7_12;  _13=_8_13;
-            _20=_9_20;  _21=_10_21; _22=_11_22; _23=_12_23;
-            _30=_13_30; _31=_14_31; _32=_15_32; _33=_16_33;
-        }
+        ) : _00(_1_00),  _01(_2_01),  _02(_3_02),  _03(_4_03),
+            _10(_5_10),  _11(_6_11),  _12(_7_12),  _13(_8_13),
+            _20(_9_20),  _21(_10_21), _22(_11_22), _23(_12_23),
+            _30(_13_30), _31(_14_31), _32(_15_32), _33(_16_33) {}
 
         // Creates an identitiy matrix.
-        inline mat4() {
-            _00=_11=_22=_33=1.0f;
-            _01=_02=_03=_10=_12=
-                _13=_20=_21=_23=_30=
-                _31=_32=0;
-        }
+        inline constexpr mat4() :
+            _00(1.f), _01(0.f), _02(0.f), _03(0.f),
+            _10(0.f), _11(1.f), _12(0.f), _13(0.f),
+            _20(0.f), _21(0.f), _22(1.f), _23(0.f),
+            _30(0.f), _31(0.f), _32(0.f), _33(1.f) {}
 
         // returns an identity matrix
-        inline static mat4 identity() {
+        inline static constexpr mat4 identity() {
             // This function is pointless, but some people might like the explicity of using "mat4::identity()"
             // instead of "mat4()" and some people might not realize that the constructor creates an Identity matrix.
             // Even though theres a comment.
@@ -523,7 +1985,7 @@ namespace lina {
         }
 
         // returns a matrix with every value initialized to 0.
-        inline static mat4 zeroed() {
+        inline static constexpr mat4 zeroed() {
             return mat4(
                 0.f, 0.f, 0.f, 0.f,
                 0.f, 0.f, 0.f, 0.f,
@@ -532,10 +1994,14 @@ namespace lina {
             );
         }
 
+        // returns a pointer to the 16 values of the matrix, row by row.
+        inline float* data() noexcept { return &_00; }
+        inline const float* data() const noexcept { return &_00; }
+
         // Operations
         
         // returns a translation matrix 
-        inline static mat4 translation(vec3 T) noexcept {
+        inline static constexpr mat4 translation(vec3 T) noexcept {
             return mat4(
                 1.f, 0.f, 0.f, T.x,
                 0.f, 1.f, 0.f, T.y,
@@ -544,13 +2010,16 @@ namespace lina {
             );
         }
 
-        // translates this matrix by T.
-        inline void translate(vec3 T) noexcept {
-            *this *= translation(T);
+        // translates this matrix by T, same as *this *= translation(T) but only the last column changes.
+        LINA_CONSTEXPR14 void translate(vec3 T) noexcept {
+            _03 += _00 * T.x + _01 * T.y + _02 * T.z;
+            _13 += _10 * T.x + _11 * T.y + _12 * T.z;
+            _23 += _20 * T.x + _21 * T.y + _22 * T.z;
+            _33 += _30 * T.x + _31 * T.y + _32 * T.z;
         }
 
         // returns a scale matrix.
-        inline static mat4 scalation(vec4 S) noexcept {
+        inline static constexpr mat4 scalation(vec4 S) noexcept {
             return mat4(
                 S.x, 0.f, 0.f, 0.f,
                 0.f, S.y, 0.f, 0.f,
@@ -559,81 +2028,185 @@ namespace lina {
             );
         }
 
-        // scales this matrix by S.
-        inline void scale(vec4 S) noexcept {
-            *this *= scalation(S);
+        // scales this matrix by S, same as *this *= scalation(S) but it just scales the columns.
+        LINA_CONSTEXPR14 void scale(vec4 S) noexcept {
+            _00 *= S.x; _01 *= S.y; _02 *= S.z; _03 *= S.w;
+            _10 *= S.x; _11 *= S.y; _12 *= S.z; _13 *= S.w;
+            _20 *= S.x; _21 *= S.y; _22 *= S.z; _23 *= S.w;
+            _30 *= S.x; _31 *= S.y; _32 *= S.z; _33 *= S.w;
         }
 
         // returns a rotation matrix for the X axis that is rotated by `degrees`.
+        template <typename P = precise>
         inline static mat4 rotationX(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat4(
                 1.f, 0.f, 0.f, 0.f, 
-                0.f, cosf(degrees), -sinf(degrees), 0.f,
-                0.f, sinf(degrees), cosf(degrees), 0.f,
+                0.f, c, -s, 0.f,
+                0.f, s, c, 0.f,
                 0.f, 0.f, 0.f, 1.f
             );
         }
 
-        // rotates this matrix on the X axis by `degrees`.
+        // rotates this matrix on the X axis by `degrees`, only columns 1 and 2 change.
+        template <typename P = precise>
         inline void rotateX(float degrees) noexcept {
-            *this *= rotationX(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::mat4_rotate_columns<1, 2>(data(), s, c);
         }
         
+        template <typename P = precise>
         inline static mat4 rotationY(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat4(
-                cosf(degrees), 0.f, sinf(degrees), 0.f,
+                c, 0.f, s, 0.f,
                 0.f, 1.f, 0.f, 0.f,
-                -sinf(degrees), 0.f, cosf(degrees), 0.f,
+                -s, 0.f, c, 0.f,
                 0.f, 0.f, 0.f, 1.f
             );
         }
         
+        template <typename P = precise>
         inline void rotateY(float degrees) noexcept {
-            *this *= rotationY(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::mat4_rotate_columns<2, 0>(data(), s, c);
         }
         
+        template <typename P = precise>
         inline static mat4 rotationZ(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat4(
-                cosf(degrees), -sinf(degrees), 0.f, 0.f,
-                sinf(degrees), cosf(degrees), 0.f, 0.f, 
+                c, -s, 0.f, 0.f,
+                s, c, 0.f, 0.f, 
                 0.f, 0.f, 1.f, 0.f,
                 0.f, 0.f, 0.f, 1.f
             );
         }
         
+        template <typename P = precise>
         inline void rotateZ(float degrees) noexcept {
-            *this *= rotationZ(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::mat4_rotate_columns<0, 1>(data(), s, c);
         }
         
+        // returns rotationX * rotationY * rotationZ, built directly instead of with the products.
+        template <typename P = precise>
         inline static mat4 rotation(vec3 degrees) noexcept {
-            return rotationX(degrees.x) * rotationY(degrees.y) * rotationZ(degrees.z);
-        }
-        
-        inline void rotate(vec3 degrees) noexcept {
-            *this *= rotation(degrees);
+            return fromEuler<P>(degrees);
         }
 
-        inline mat4 transposed() const noexcept {
+        // returns the rotation for the Euler angles `radians` multiplied in `order`, see 'Euler Rotations'.
+        template <typename P = precise>
+        inline static mat4 fromEuler(vec3 radians, EulerOrder order = EulerOrder::XYZ) noexcept {
+            float r[9];
+            detail::euler_rotation<P>(radians, order, r);
             return mat4(
-                _00, _10, _20, _30,
-                _01, _11, _21, _31,
-                _02, _12, _22, _32, 
-                _03, _13, _23, _33
+                r[0], r[1], r[2], 0.f,
+                r[3], r[4], r[5], 0.f,
+                r[6], r[7], r[8], 0.f,
+                0.f,  0.f,  0.f,  1.f
             );
         }
-        inline void transpose() noexcept {
+
+        // same as *this *= rotation(degrees), the last column doesn't change.
+        template <typename P = precise>
+        inline void rotate(vec3 degrees, EulerOrder order = EulerOrder::XYZ) noexcept {
+            float r[9];
+            detail::euler_rotation<P>(degrees, order, r);
+            detail::mat4_rotate(data(), r);
+        }
+
+        LINA_CONSTEXPR_SIMD mat4 transposed() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return mat4(
+                    _00, _10, _20, _30,
+                    _01, _11, _21, _31,
+                    _02, _12, _22, _32, 
+                    _03, _13, _23, _33
+                );
+            }
+            mat4 r;
+            detail::mat4_transpose(data(), r.data());
+            return r;
+        }
+        LINA_CONSTEXPR_SIMD void transpose() noexcept {
             *this = transposed();
         }
+        inline constexpr float determinant() const noexcept {
+            return (_00 * _11 - _10 * _01) * (_22 * _33 - _32 * _23) - (_00 * _12 - _10 * _02) * (_21 * _33 - _31 * _23) +
+                   (_00 * _13 - _10 * _03) * (_21 * _32 - _31 * _22) + (_01 * _12 - _11 * _02) * (_20 * _33 - _30 * _23) -
+                   (_01 * _13 - _11 * _03) * (_20 * _32 - _30 * _22) + (_02 * _13 - _12 * _03) * (_20 * _31 - _30 * _21);
+        }
+
+        // Inverses
+        // If the matrix can't be inverted (determinant() == 0) the result is full of inf/nan, so
+        // check the determinant first if that can happen.
+        // inverse() works for any matrix, inverseAffine() and inverseRigid() are faster but only
+        // work for the matrices described above them. Those two expect the translation in the
+        // last column like the RM builders put it, for CM matrices use inverseAffine(m.transposed()).transposed().
+        LINA_CONSTEXPR_SIMD mat4 inverse() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                float s0 = _00 * _11 - _10 * _01, s1 = _00 * _12 - _10 * _02, s2 = _00 * _13 - _10 * _03;
+                float s3 = _01 * _12 - _11 * _02, s4 = _01 * _13 - _11 * _03, s5 = _02 * _13 - _12 * _03;
+                float c5 = _22 * _33 - _32 * _23, c4 = _21 * _33 - _31 * _23, c3 = _21 * _32 - _31 * _22;
+                float c2 = _20 * _33 - _30 * _23, c1 = _20 * _32 - _30 * _22, c0 = _20 * _31 - _30 * _21;
+                float d = 1.f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+                return mat4(
+                    ( _11 * c5 - _12 * c4 + _13 * c3) * d, (-_01 * c5 + _02 * c4 - _03 * c3) * d, ( _31 * s5 - _32 * s4 + _33 * s3) * d, (-_21 * s5 + _22 * s4 - _23 * s3) * d,
+                    (-_10 * c5 + _12 * c2 - _13 * c1) * d, ( _00 * c5 - _02 * c2 + _03 * c1) * d, (-_30 * s5 + _32 * s2 - _33 * s1) * d, ( _20 * s5 - _22 * s2 + _23 * s1) * d,
+                    ( _10 * c4 - _11 * c2 + _13 * c0) * d, (-_00 * c4 + _01 * c2 - _03 * c0) * d, ( _30 * s4 - _31 * s2 + _33 * s0) * d, (-_20 * s4 + _21 * s2 - _23 * s0) * d,
+                    (-_10 * c3 + _11 * c1 - _12 * c0) * d, ( _00 * c3 - _01 * c1 + _02 * c0) * d, (-_30 * s3 + _31 * s1 - _32 * s0) * d, ( _20 * s3 - _21 * s1 + _22 * s0) * d
+                );
+            }
+            mat4 r;
+            detail::mat4_inverse(data(), r.data());
+            return r;
+        }
+        LINA_CONSTEXPR_SIMD void invert() noexcept {
+            *this = inverse();
+        }
+
+        // For matrices that only translate and scale / rotate / shear (the bottom row is 0 0 0 1),
+        // like model matrices. Only needs a 3x3 inverse.
+        LINA_CONSTEXPR_SIMD mat4 inverseAffine() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return inverse();
+            }
+            mat4 r;
+            detail::affine3_inverse(data(), r.data());
+            return r;
+        }
+
+        // For matrices that only rotate and translate (no scale), like view matrices. The inverse
+        // of a rotation is its transpose, so this is just a transpose and 9 multiplies.
+        inline constexpr mat4 inverseRigid() const noexcept {
+            return mat4(
+                _00, _10, _20, -(_00 * _03 + _10 * _13 + _20 * _23),
+                _01, _11, _21, -(_01 * _03 + _11 * _13 + _21 * _23),
+                _02, _12, _22, -(_02 * _03 + _12 * _13 + _22 * _23),
+                0.f, 0.f, 0.f, 1.f
+            );
+        }
+
+        // The inverse transpose of the top left 3x3, which is what normals need to be multiplied by
+        // when the matrix has a non uniform scale (the normal matrix). Works for RM and CM matrices.
+        LINA_CONSTEXPR_SIMD mat3 inverseTranspose3x3() const noexcept;
 
         // Conditions
-        inline bool isIdentity() const noexcept {
+        inline constexpr bool isIdentity() const noexcept {
             return _00 == 1.f && _01 == 0.f && _02 == 0.f && _03 == 0.f &&
                    _10 == 0.f && _11 == 1.f && _12 == 0.f && _13 == 0.f &&
                    _20 == 0.f && _21 == 0.f && _22 == 1.f && _23 == 0.f &&
                    _30 == 0.f && _31 == 0.f && _32 == 0.f && _33 == 1.f ;
         }
 
-        inline bool isZeroed() {
+        inline constexpr bool isZeroed() const {
             // I'm aware this function is both pointless and can be done simpler, 
             // I don't care.
             return _00 == 0.f && _01 == 0.f && _02 == 0.f && _03 == 0.f &&
@@ -642,7 +2215,7 @@ namespace lina {
                    _30 == 0.f && _31 == 0.f && _32 == 0.f && _33 == 0.f ;
         }
 
-        inline bool isTranslation() const noexcept {
+        inline constexpr bool isTranslation() const noexcept {
             return _00 == 1.f && _01 == 0 && _02 == 0 &&
                    _00 == 1.f && _01 == 0 && _02 == 0 &&
                    _00 == 1.f && _01 == 0 && _02 == 0 &&
@@ -651,14 +2224,14 @@ namespace lina {
         }
 
         // Operators
-        inline bool operator==(mat4 o) const noexcept {
+        inline constexpr bool operator==(mat4 o) const noexcept {
             return _00 == o._00 && _01 == o._01 && _02 == o._02 && _03 == o._03 &&
                    _10 == o._10 && _11 == o._11 && _12 == o._12 && _13 == o._13 &&
                    _20 == o._20 && _21 == o._21 && _22 == o._22 && _23 == o._23 &&
                    _30 == o._30 && _31 == o._31 && _32 == o._32 && _33 == o._33;
         }
 
-        inline mat4 operator+(mat4 m) const noexcept {
+        inline constexpr mat4 operator+(mat4 m) const noexcept {
             return mat4(
                 _00 + m._00, _01 + m._01, _02 + m._02, _03 + m._03, 
                 _10 + m._10, _11 + m._11, _12 + m._12, _13 + m._13, 
@@ -667,14 +2240,14 @@ namespace lina {
             );
         }
         
-        inline void operator+=(mat4 m) noexcept {
+        LINA_CONSTEXPR14 void operator+=(mat4 m) noexcept {
             _00 += m._00; _01 += m._01; _02 += m._02; _03 += m._03; 
             _10 += m._10; _11 += m._11; _12 += m._12; _13 += m._13; 
             _20 += m._20; _21 += m._21; _22 += m._22; _23 += m._23; 
             _30 += m._30; _31 += m._31; _32 += m._32; _33 += m._33;
         }
         
-        inline mat4 operator+(vec4 v) const noexcept {
+        inline constexpr mat4 operator+(vec4 v) const noexcept {
             return mat4(
                 _00 + v.x, _01, _02, _03,
                 _10 + v.y, _11, _12, _13,
@@ -683,14 +2256,14 @@ namespace lina {
             );
         }
         
-        inline void operator+=(vec4 v) noexcept {
+        LINA_CONSTEXPR14 void operator+=(vec4 v) noexcept {
             _00 += v.x;
             _10 += v.y;
             _20 += v.z;
             _30 += v.w;
         }
 
-        inline mat4 operator-(mat4 m) const noexcept {
+        inline constexpr mat4 operator-(mat4 m) const noexcept {
             return mat4(
                 _00 - m._00, _01 - m._01, _02 - m._02, _03 - m._03, 
                 _10 - m._10, _11 - m._11, _12 - m._12, _13 - m._13, 
@@ -699,14 +2272,14 @@ namespace lina {
             );
         }
         
-        inline void operator-=(mat4 m) noexcept {
+        LINA_CONSTEXPR14 void operator-=(mat4 m) noexcept {
             _00 -= m._00; _01 -= m._01; _02 -= m._02; _03 -= m._03; 
             _10 -= m._10; _11 -= m._11; _12 -= m._12; _13 -= m._13; 
             _20 -= m._20; _21 -= m._21; _22 -= m._22; _23 -= m._23; 
             _30 -= m._30; _31 -= m._31; _32 -= m._32; _33 -= m._33;
         }
         
-        inline mat4 operator-(vec4 v) const noexcept {
+        inline constexpr mat4 operator-(vec4 v) const noexcept {
             return mat4(
                 _00 - v.x, _01, _02, _03,
                 _10 - v.y, _11, _12, _13,
@@ -715,51 +2288,47 @@ namespace lina {
             );
         }
         
-        inline void operator-=(vec4 v) noexcept {
+        LINA_CONSTEXPR14 void operator-=(vec4 v) noexcept {
             _00 -= v.x;
             _10 -= v.y;
             _20 -= v.z;
             _30 -= v.w;
         }
 
-        inline mat4 operator*(mat4 m) const noexcept {
-            return mat4(
-                _00 * m._00 + _01 * m._10 + _02 * m._20 + _03 * m._30, _00 * m._01 + _01 * m._11 + _02 * m._21 + _03 * m._31, _00 * m._02 + _01 * m._12 + _02 * m._22 + _03 * m._32, _00 * m._03 + _01 * m._13 + _02 * m._23 + _03 * m._33,
-                _10 * m._00 + _11 * m._10 + _12 * m._20 + _13 * m._30, _10 * m._01 + _11 * m._11 + _12 * m._21 + _13 * m._31, _10 * m._02 + _11 * m._12 + _12 * m._22 + _13 * m._32, _10 * m._03 + _11 * m._13 + _12 * m._23 + _13 * m._33,
-                _20 * m._00 + _21 * m._10 + _22 * m._20 + _23 * m._30, _20 * m._01 + _21 * m._11 + _22 * m._21 + _23 * m._31, _20 * m._02 + _21 * m._12 + _22 * m._22 + _23 * m._32, _20 * m._03 + _21 * m._13 + _22 * m._23 + _23 * m._33,
-                _30 * m._00 + _31 * m._10 + _32 * m._20 + _33 * m._30, _30 * m._01 + _31 * m._11 + _32 * m._21 + _33 * m._31, _30 * m._02 + _31 * m._12 + _32 * m._22 + _33 * m._32, _30 * m._03 + _31 * m._13 + _32 * m._23 + _33 * m._33
-            );
+        LINA_CONSTEXPR_SIMD mat4 operator*(mat4 m) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return mat4(
+                    _00 * m._00 + _01 * m._10 + _02 * m._20 + _03 * m._30, _00 * m._01 + _01 * m._11 + _02 * m._21 + _03 * m._31, _00 * m._02 + _01 * m._12 + _02 * m._22 + _03 * m._32, _00 * m._03 + _01 * m._13 + _02 * m._23 + _03 * m._33,
+                    _10 * m._00 + _11 * m._10 + _12 * m._20 + _13 * m._30, _10 * m._01 + _11 * m._11 + _12 * m._21 + _13 * m._31, _10 * m._02 + _11 * m._12 + _12 * m._22 + _13 * m._32, _10 * m._03 + _11 * m._13 + _12 * m._23 + _13 * m._33,
+                    _20 * m._00 + _21 * m._10 + _22 * m._20 + _23 * m._30, _20 * m._01 + _21 * m._11 + _22 * m._21 + _23 * m._31, _20 * m._02 + _21 * m._12 + _22 * m._22 + _23 * m._32, _20 * m._03 + _21 * m._13 + _22 * m._23 + _23 * m._33,
+                    _30 * m._00 + _31 * m._10 + _32 * m._20 + _33 * m._30, _30 * m._01 + _31 * m._11 + _32 * m._21 + _33 * m._31, _30 * m._02 + _31 * m._12 + _32 * m._22 + _33 * m._32, _30 * m._03 + _31 * m._13 + _32 * m._23 + _33 * m._33
+                );
+            }
+            mat4 r;
+            detail::mat4_mul(data(), m.data(), r.data());
+            return r;
         }
         
-        inline void operator*=(mat4 m) noexcept {
-            _00 = _00 * m._00 + _01 * m._10 + _02 * m._20 + _03 * m._30;
-            _01 = _00 * m._01 + _01 * m._11 + _02 * m._21 + _03 * m._31;
-            _02 = _00 * m._02 + _01 * m._12 + _02 * m._22 + _03 * m._32;
-            _03 = _00 * m._03 + _01 * m._13 + _02 * m._23 + _03 * m._33;
-                
-            _10 = _10 * m._00 + _11 * m._10 + _12 * m._20 + _13 * m._30;
-            _11 = _10 * m._01 + _11 * m._11 + _12 * m._21 + _13 * m._31;
-            _12 = _10 * m._02 + _11 * m._12 + _12 * m._22 + _13 * m._32;
-            _13 = _10 * m._03 + _11 * m._13 + _12 * m._23 + _13 * m._33;
-                
-            _20 = _20 * m._00 + _21 * m._10 + _22 * m._20 + _23 * m._30;
-            _21 = _20 * m._01 + _21 * m._11 + _22 * m._21 + _23 * m._31;
-            _22 = _20 * m._02 + _21 * m._12 + _22 * m._22 + _23 * m._32;
-            _23 = _20 * m._03 + _21 * m._13 + _22 * m._23 + _23 * m._33;
-                
-            _30 = _30 * m._00 + _31 * m._10 + _32 * m._20 + _33 * m._30; 
-            _31 = _30 * m._01 + _31 * m._11 + _32 * m._21 + _33 * m._31; 
-            _32 = _30 * m._02 + _31 * m._12 + _32 * m._22 + _33 * m._32; 
-            _33 = _30 * m._03 + _31 * m._13 + _32 * m._23 + _33 * m._33;    
+        LINA_CONSTEXPR_SIMD void operator*=(mat4 m) noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                *this = *this * m;
+                return;
+            }
+            detail::mat4_mul(data(), m.data(), data());
         }
         
-        inline vec4 operator*(vec4 v) const noexcept {
-            return vec4(
-                v.x * _00 + v.x * _10 + v.x * _20 + v.x * _30,
-                v.y * _01 + v.y * _11 + v.y * _21 + v.y * _31,
-                v.z * _02 + v.z * _12 + v.z * _22 + v.z * _32,
-                v.w * _03 + v.w * _13 + v.w * _23 + v.w * _33
-            );
+        LINA_CONSTEXPR_SIMD vec4 operator*(vec4 v) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return vec4(
+                    _00 * v.x + _01 * v.y + _02 * v.z + _03 * v.w,
+                    _10 * v.x + _11 * v.y + _12 * v.z + _13 * v.w,
+                    _20 * v.x + _21 * v.y + _22 * v.z + _23 * v.w,
+                    _30 * v.x + _31 * v.y + _32 * v.z + _33 * v.w
+                );
+            }
+            vec4 r;
+            detail::mat4_mul_vec4(data(), &v.x, &r.x);
+            return r;
         }
     };
     // TODO: Add the functions that mat4 has to mat3 and mat2
@@ -768,29 +2337,27 @@ namespace lina {
         union {float _10, _m21;}; union {float _11, _m22;}; union {float _12, _m23;};
         union {float _20, _m31;}; union {float _21, _m32;}; union {float _22, _m33;};         
 
-        inline mat3(
+        // I don't know why I decided to name the arguments like this.
+        inline constexpr mat3(
             float _1_00, float _2_01, float _3_02,
             float _4_10, float _5_11, float _6_12,
             float _7_20, float _8_21, float _9_22
-        ) {
-            // I don't know why I decided to name the arguments like this.
-            _00 = _1_00; _01 = _2_01; _02 = _3_02;
-            _10 = _4_10; _11 = _5_11; _12 = _6_12;
-            _00 = _7_20; _01 = _8_21; _02 = _9_22;
-        }
+        ) : _00(_1_00), _01(_2_01), _02(_3_02),
+            _10(_4_10), _11(_5_11), _12(_6_12),
+            _20(_7_20), _21(_8_21), _22(_9_22) {}
         // Creates an identitiy matrix.
-        inline mat3() {
-            _00 = _11 = _22 = 1.f;
-            _01 = _02 = _10 = _12 = _20 = _21 = 0.f;
-        }
+        inline constexpr mat3() :
+            _00(1.f), _01(0.f), _02(0.f),
+            _10(0.f), _11(1.f), _12(0.f),
+            _20(0.f), _21(0.f), _22(1.f) {}
 
         // returns a 3x3 identity matrix.
-        inline static mat3 identity() {
+        inline static constexpr mat3 identity() {
             return mat3();
         }
 
         // returns a 3x3 matrix with every value initialized to 0.
-        inline static mat3 zeroed() {
+        inline static constexpr mat3 zeroed() {
             return mat3(
                 0.f, 0.f, 0.f,
                 0.f, 0.f, 0.f,
@@ -798,24 +2365,30 @@ namespace lina {
             );
         }
 
+        // returns a pointer to the 9 values of the matrix, row by row.
+        inline float* data() noexcept { return &_00; }
+        inline const float* data() const noexcept { return &_00; }
+
         // Operations
 
         // returns a 3x3 translation matrix with the given translation.
-        inline static mat3 translation(vec2 T) noexcept {
+        inline static constexpr mat3 translation(vec2 T) noexcept {
             return mat3(
                 1.f, 0.f, T.x,
                 0.f, 1.f, T.y,
                 0.f, 0.f, 1.f
             );
         }
-        // translates the matrix by T.
-        inline void translate(vec2 T) noexcept {
-            *this *= translation(T);
+        // translates the matrix by T, only the last column changes.
+        LINA_CONSTEXPR14 void translate(vec2 T) noexcept {
+            _02 += _00 * T.x + _01 * T.y;
+            _12 += _10 * T.x + _11 * T.y;
+            _22 += _20 * T.x + _21 * T.y;
         }
 
         // returns a 3x3 scale matrix with the given scale vector.
         // (I don't know what the scale equivelent to "translation" or "rotation" is)
-        inline static mat3 scalation(vec3 S) noexcept {
+        inline static constexpr mat3 scalation(vec3 S) noexcept {
             return mat3(
                 S.x, 0.f, 0.f,
                 0.f, S.y, 0.f,
@@ -823,82 +2396,154 @@ namespace lina {
             );
         }
 
-        // scales the matrix by S.
-        inline void scale(vec3 S) noexcept {
-            *this *= scalation(S);
+        // scales the matrix by S, which just scales the columns.
+        LINA_CONSTEXPR14 void scale(vec3 S) noexcept {
+            _00 *= S.x; _01 *= S.y; _02 *= S.z;
+            _10 *= S.x; _11 *= S.y; _12 *= S.z;
+            _20 *= S.x; _21 *= S.y; _22 *= S.z;
         }
 
         // returns a 3x3 rotation matrix for the X axis.
+        template <typename P = precise>
         inline static mat3 rotationX(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat3(
                 1.f, 0.f, 0.f, 
-                0.f, cosf(degrees), -sinf(degrees),
-                0.f, sinf(degrees), cosf(degrees)
+                0.f, c, -s,
+                0.f, s, c
             );
         }
 
         // rotates the matrix on the X axis by `degrees`.
+        template <typename P = precise>
         inline void rotateX(float degrees) noexcept {
-            *this *= rotationX(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::rotate_columns<1, 2>(data(), 3, 3, s, c);
         }
         
         // returns a 3x3 rotation matrix for the Y axis.
+        template <typename P = precise>
         inline static mat3 rotationY(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat3(
-                cosf(degrees), 0.f, sinf(degrees),
+                c, 0.f, s,
                 0.f, 1.f, 0.f,
-                -sinf(degrees), 0.f, cosf(degrees)
+                -s, 0.f, c
             );
         }
         
         // rotates the matrix on the Y axis by `degrees`.
+        template <typename P = precise>
         inline void rotateY(float degrees) noexcept {
-            *this *= rotationY(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::rotate_columns<2, 0>(data(), 3, 3, s, c);
         }
         
         // returns a 3x3 rotation matrix for the Z axis.
+        template <typename P = precise>
         inline static mat3 rotationZ(float degrees) noexcept {
+            float s, c;
+            P::sincos(degrees, s, c);
             return mat3(
-                cosf(degrees), -sinf(degrees), 0.f,
-                sinf(degrees), cosf(degrees), 0.f,
+                c, -s, 0.f,
+                s, c, 0.f,
                 0.f, 0.f, 1.f
             );
         }
         
         // rotates the matrix on the Z axis by `degrees`.
+        template <typename P = precise>
         inline void rotateZ(float degrees) noexcept {
-            *this *= rotationZ(degrees);
+            float s, c;
+            P::sincos(degrees, s, c);
+            detail::rotate_columns<0, 1>(data(), 3, 3, s, c);
         }
         
         // returns a 3x3 rotation matrix for all axis, the X,Y,Z components corrospond with the axis it will rotate.
+        template <typename P = precise>
         inline static mat3 rotation(vec3 degrees) noexcept {
-            return rotationX(degrees.x) * rotationY(degrees.y) * rotationZ(degrees.z);
-        }
-        
-        inline void rotate(vec3 degrees) noexcept {
-            *this *= rotation(degrees);
+            return fromEuler<P>(degrees);
         }
 
-        inline mat3 transposed() const noexcept {
+        // returns the rotation for the Euler angles `radians` multiplied in `order`, see 'Euler Rotations'.
+        template <typename P = precise>
+        inline static mat3 fromEuler(vec3 radians, EulerOrder order = EulerOrder::XYZ) noexcept {
+            float r[9];
+            detail::euler_rotation<P>(radians, order, r);
             return mat3(
-                _00, _10, _20,
-                _01, _11, _21,
-                _02, _12, _22
+                r[0], r[1], r[2],
+                r[3], r[4], r[5],
+                r[6], r[7], r[8]
             );
         }
 
-        inline void transpose() noexcept {
+        template <typename P = precise>
+        inline void rotate(vec3 degrees, EulerOrder order = EulerOrder::XYZ) noexcept {
+            float r[9];
+            detail::euler_rotation<P>(degrees, order, r);
+            detail::rotate_rows(data(), 3, 3, r);
+        }
+
+        LINA_CONSTEXPR_SIMD mat3 transposed() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return mat3(
+                    _00, _10, _20,
+                    _01, _11, _21,
+                    _02, _12, _22
+                );
+            }
+            mat3 r;
+            detail::mat3_transpose(data(), r.data());
+            return r;
+        }
+
+        LINA_CONSTEXPR_SIMD void transpose() noexcept {
             *this = transposed();
         }
+        inline constexpr float determinant() const noexcept {
+            return _00 * (_11 * _22 - _12 * _21) - _01 * (_10 * _22 - _12 * _20) + _02 * (_10 * _21 - _11 * _20);
+        }
+
+        // Inverses, see mat4::inverse.
+        LINA_CONSTEXPR_SIMD mat3 inverse() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return inverseTransposed().transposed();
+            }
+            mat3 r;
+            detail::mat3_inverse(data(), r.data());
+            return r;
+        }
+        LINA_CONSTEXPR_SIMD void invert() noexcept {
+            *this = inverse();
+        }
+
+        // inverse().transposed() without the transpose, the normal matrix of a 3x3 transform.
+        LINA_CONSTEXPR_SIMD mat3 inverseTransposed() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                float d = 1.f / determinant();
+                return mat3(
+                    (_11 * _22 - _12 * _21) * d, (_12 * _20 - _10 * _22) * d, (_10 * _21 - _11 * _20) * d,
+                    (_21 * _02 - _22 * _01) * d, (_22 * _00 - _20 * _02) * d, (_20 * _01 - _21 * _00) * d,
+                    (_01 * _12 - _02 * _11) * d, (_02 * _10 - _00 * _12) * d, (_00 * _11 - _01 * _10) * d
+                );
+            }
+            mat3 r;
+            detail::mat3_inverse_transpose(data(), r.data());
+            return r;
+        }
 
         // Conditions
-        inline bool isIdentity() const noexcept {
+        inline constexpr bool isIdentity() const noexcept {
             return _00 == 1.f && _01 == 0.f && _02 == 0.f &&
                    _10 == 0.f && _11 == 1.f && _12 == 0.f &&
                    _20 == 0.f && _21 == 0.f && _22 == 1.f ;
         }
 
-        inline bool isTranslation() const noexcept {
+        inline constexpr bool isTranslation() const noexcept {
             return _00 == 1.f && _01 == 0.f &&
                    _10 == 0.f && _11 == 1.f &&
                    _20 == 0.f && _21 == 0.f && 
@@ -906,13 +2551,13 @@ namespace lina {
         }
 
         // Operators
-        inline bool operator==(mat3 o) const noexcept {
+        inline constexpr bool operator==(mat3 o) const noexcept {
             return _00 == o._00 && _01 == o._01 && _02 == o._02 &&
                    _10 == o._10 && _11 == o._11 && _12 == o._12 &&
                    _20 == o._20 && _21 == o._21 && _22 == o._22 ;
         }
 
-        inline mat3 operator+(mat3 m) const noexcept {
+        inline constexpr mat3 operator+(mat3 m) const noexcept {
             return mat3(
                 _00 + m._00, _01 + m._01, _02 + m._02,
                 _10 + m._10, _11 + m._11, _12 + m._12,
@@ -920,13 +2565,13 @@ namespace lina {
             );
         }
 
-        inline void operator+=(mat3 m) noexcept {
+        LINA_CONSTEXPR14 void operator+=(mat3 m) noexcept {
             _00 += m._00; _01 += m._01; _02 += m._02;
             _10 += m._10; _11 += m._11; _12 += m._12;
             _20 += m._20; _21 += m._21; _22 += m._22;
         }
 
-        inline mat3 operator+(vec3 v) const noexcept {
+        inline constexpr mat3 operator+(vec3 v) const noexcept {
             return mat3(
                 v.x + _00, _01, _02,
                 v.y + _10, _11, _12,
@@ -934,13 +2579,13 @@ namespace lina {
             );
         }
 
-        inline void operator+=(vec3 v) noexcept {
+        LINA_CONSTEXPR14 void operator+=(vec3 v) noexcept {
             _00 +=v.x;
             _10 +=v.y;
             _20 +=v.z;
         }
 
-        inline mat3 operator-(mat3 m) const noexcept {
+        inline constexpr mat3 operator-(mat3 m) const noexcept {
             return mat3(
                 _00 - m._00, _01 - m._01, _02 - m._02,
                 _10 - m._10, _11 - m._11, _12 - m._12,
@@ -948,13 +2593,13 @@ namespace lina {
             );
         }
 
-        inline void operator-=(mat3 m) noexcept {
+        LINA_CONSTEXPR14 void operator-=(mat3 m) noexcept {
             _00 -= m._00; _01 -= m._01; _02 -= m._02;
             _10 -= m._10; _11 -= m._11; _12 -= m._12;
             _20 -= m._20; _21 -= m._21; _22 -= m._22;
         }
 
-        inline mat3 operator-(vec3 v) const noexcept {
+        inline constexpr mat3 operator-(vec3 v) const noexcept {
             return mat3(
                 v.x - _00, _01, _02,
                 v.y - _10, _11, _12,
@@ -962,117 +2607,1002 @@ namespace lina {
             );
         }
 
-        inline void operator-=(vec3 v) noexcept {
+        LINA_CONSTEXPR14 void operator-=(vec3 v) noexcept {
             _00 -=v.x;
             _10 -=v.y;
             _20 -=v.z;
         }
 
-        inline mat3 operator*(mat3 m) const noexcept {
+        LINA_CONSTEXPR_SIMD mat3 operator*(mat3 m) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return mat3(
+                    _00 * m._00 + _01 * m._10 + _02 * m._20, _00 * m._01 + _01 * m._11 + _02 * m._21, _00 * m._02 + _01 * m._12 + _02 * m._22,
+                    _10 * m._00 + _11 * m._10 + _12 * m._20, _10 * m._01 + _11 * m._11 + _12 * m._21, _10 * m._02 + _11 * m._12 + _12 * m._22,
+                    _20 * m._00 + _21 * m._10 + _22 * m._20, _20 * m._01 + _21 * m._11 + _22 * m._21, _20 * m._02 + _21 * m._12 + _22 * m._22
+                );
+            }
+            mat3 r;
+            detail::mat3_mul(data(), m.data(), r.data());
+            return r;
+        }
+
+        LINA_CONSTEXPR_SIMD void operator*=(mat3 m) noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                *this = *this * m;
+                return;
+            }
+            detail::mat3_mul(data(), m.data(), data());
+        }
+
+        LINA_CONSTEXPR_SIMD vec3 operator*(vec3 v) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return vec3(
+                    _00 * v.x + _01 * v.y + _02 * v.z,
+                    _10 * v.x + _11 * v.y + _12 * v.z,
+                    _20 * v.x + _21 * v.y + _22 * v.z
+                );
+            }
+            vec3 r;
+            detail::mat3_mul_vec3(data(), &v.x, &r.x);
+            return r;
+        }
+    };
+
+    LINA_CONSTEXPR_SIMD mat3 mat4::inverseTranspose3x3() const noexcept {
+        if (LINA_IS_CONSTANT_EVALUATED()) {
+            return mat3(
+                _00, _01, _02,
+                _10, _11, _12,
+                _20, _21, _22
+            ).inverseTransposed();
+        }
+        mat3 r;
+        detail::mat4_inverse_transpose3x3(data(), r.data());
+        return r;
+    }
+
+    struct mat2 {
+        union {float _00, _m11;}; union {float _01, _m12;};
+        union {float _10, _m21;}; union {float _11, _m22;};
+
+        inline constexpr mat2(
+            float p00, float p01,
+            float p10, float p11
+        ) : _00(p00), _01(p01),
+            _10(p10), _11(p11) {}
+
+        // Creates an Identity matrix.
+        inline constexpr mat2() :
+            _00(1.f), _01(0.f),
+            _10(0.f), _11(1.f) {}
+
+        inline constexpr float determinant() const noexcept {
+            return _00 * _11 - _01 * _10;
+        }
+
+        // Inverses, see mat4::inverse.
+        inline constexpr mat2 inverse() const noexcept {
+            return inverseWithDet(1.f / determinant());
+        }
+        LINA_CONSTEXPR14 void invert() noexcept {
+            *this = inverse();
+        }
+
+    private:
+        inline constexpr mat2 inverseWithDet(float d) const noexcept {
+            return mat2(
+                _11 * d, -_01 * d,
+                -_10 * d, _00 * d
+            );
+        }
+
+    };
+
+    /*
+        Aligned types
+    */
+    // vec4, mat4 and mat3 aligned for SIMD loads and cache lines, see 'Aligned Types'.
+    struct alignas(16) vec4a : vec4 {
+        using vec4::Vector4;
+        constexpr vec4a() : vec4() {}
+        constexpr vec4a(const vec4& v) : vec4(v) {}
+    };
+
+    struct alignas(64) mat4a : mat4 {
+        using mat4::mat4;
+        constexpr mat4a() : mat4() {}
+        constexpr mat4a(const mat4& m) : mat4(m) {}
+    };
+
+    struct alignas(16) mat3a : mat3 {
+        using mat3::mat3;
+        constexpr mat3a() : mat3() {}
+        constexpr mat3a(const mat3& m) : mat3(m) {}
+    };
+
+    static_assert(sizeof(vec4a) == sizeof(vec4) && sizeof(mat4a) == sizeof(mat4), "vec4a and mat4a can't have padding");
+
+#ifdef LINA_EXPR
+    namespace expr {
+        template <> struct vec_traits<vec4a> : vec_traits<vec4> {};
+    }
+#endif
+
+    /*
+        Storage order
+    */
+    // How a matrix is laid out in memory, see 'Storage Order'. mat4/mat3/mat2 are row major,
+    // cmat4/cmat3/cmat2 are the same matrices stored column by column.
+    enum class StorageOrder { RowMajor, ColumnMajor };
+
+    struct cmat4 {
+        union {float _00, _m11;}; union {float _10, _m21;}; union {float _20, _m31;}; union {float _30, _m41;};
+        union {float _01, _m12;}; union {float _11, _m22;}; union {float _21, _m32;}; union {float _31, _m42;};
+        union {float _02, _m13;}; union {float _12, _m23;}; union {float _22, _m33;}; union {float _32, _m43;};
+        union {float _03, _m14;}; union {float _13, _m24;}; union {float _23, _m34;}; union {float _33, _m44;};
+
+        // The values go row by row, just like the mat4 constructor, they're only stored column by column.
+        inline constexpr cmat4(
+            float p00, float p01, float p02, float p03,
+            float p10, float p11, float p12, float p13,
+            float p20, float p21, float p22, float p23,
+            float p30, float p31, float p32, float p33
+        ) : _00(p00), _10(p10), _20(p20), _30(p30),
+            _01(p01), _11(p11), _21(p21), _31(p31),
+            _02(p02), _12(p12), _22(p22), _32(p32),
+            _03(p03), _13(p13), _23(p23), _33(p33) {}
+
+        // Creates an identity matrix.
+        inline constexpr cmat4() :
+            _00(1.f), _10(0.f), _20(0.f), _30(0.f),
+            _01(0.f), _11(1.f), _21(0.f), _31(0.f),
+            _02(0.f), _12(0.f), _22(1.f), _32(0.f),
+            _03(0.f), _13(0.f), _23(0.f), _33(1.f) {}
+
+        // Converts a mat4, which is a transpose in memory.
+        inline constexpr explicit cmat4(const mat4& m) :
+            _00(m._00), _10(m._10), _20(m._20), _30(m._30),
+            _01(m._01), _11(m._11), _21(m._21), _31(m._31),
+            _02(m._02), _12(m._12), _22(m._22), _32(m._32),
+            _03(m._03), _13(m._13), _23(m._23), _33(m._33) {}
+
+        inline constexpr mat4 toMat4() const noexcept {
+            return mat4(
+                _00, _01, _02, _03,
+                _10, _11, _12, _13,
+                _20, _21, _22, _23,
+                _30, _31, _32, _33
+            );
+        }
+
+        // returns the mat4 with the same 16 floats in memory, which is the transpose of this matrix.
+        // Unlike toMat4() it doesn't move anything around, so it's free.
+        inline constexpr mat4 transposedMat4() const noexcept {
+            return mat4(
+                _00, _10, _20, _30,
+                _01, _11, _21, _31,
+                _02, _12, _22, _32,
+                _03, _13, _23, _33
+            );
+        }
+
+        // the other way around, the cmat4 with the same memory as `m`, which is the transpose of `m`.
+        inline static constexpr cmat4 fromTransposedMat4(const mat4& m) noexcept {
+            return cmat4(
+                m._00, m._10, m._20, m._30,
+                m._01, m._11, m._21, m._31,
+                m._02, m._12, m._22, m._32,
+                m._03, m._13, m._23, m._33
+            );
+        }
+
+        // returns a pointer to the 16 values of the matrix, column by column.
+        inline float* data() noexcept { return &_00; }
+        inline const float* data() const noexcept { return &_00; }
+
+        // The operations work on the memory of the transposed mat4 (see 'Storage Order'), so they use
+        // the same SIMD kernels and cost the same as the mat4 ones.
+        LINA_CONSTEXPR_SIMD cmat4 transposed() const noexcept {
+            return fromTransposedMat4(toMat4());
+        }
+
+        inline constexpr float determinant() const noexcept {
+            return transposedMat4().determinant();
+        }
+
+        // the inverse of the transpose is the transpose of the inverse.
+        LINA_CONSTEXPR_SIMD cmat4 inverse() const noexcept {
+            return fromTransposedMat4(transposedMat4().inverse());
+        }
+
+        inline constexpr bool operator==(const cmat4& o) const noexcept {
+            return transposedMat4() == o.transposedMat4();
+        }
+
+        inline constexpr cmat4 operator+(const cmat4& o) const noexcept {
+            return fromTransposedMat4(transposedMat4() + o.transposedMat4());
+        }
+
+        inline constexpr cmat4 operator-(const cmat4& o) const noexcept {
+            return fromTransposedMat4(transposedMat4() - o.transposedMat4());
+        }
+
+        // (A * B)^T is B^T * A^T, so this is the mat4 product with the two sides swapped.
+        LINA_CONSTEXPR_SIMD cmat4 operator*(const cmat4& o) const noexcept {
+            return fromTransposedMat4(o.transposedMat4() * transposedMat4());
+        }
+
+        LINA_CONSTEXPR_SIMD void operator*=(const cmat4& o) noexcept {
+            *this = *this * o;
+        }
+
+        inline constexpr vec4 operator*(vec4 v) const noexcept {
+            return vec4(
+                _00 * v.x + _01 * v.y + _02 * v.z + _03 * v.w,
+                _10 * v.x + _11 * v.y + _12 * v.z + _13 * v.w,
+                _20 * v.x + _21 * v.y + _22 * v.z + _23 * v.w,
+                _30 * v.x + _31 * v.y + _32 * v.z + _33 * v.w
+            );
+        }
+    };
+
+    struct cmat3 {
+        union {float _00, _m11;}; union {float _10, _m21;}; union {float _20, _m31;};
+        union {float _01, _m12;}; union {float _11, _m22;}; union {float _21, _m32;};
+        union {float _02, _m13;}; union {float _12, _m23;}; union {float _22, _m33;};
+
+        // The values go row by row, like the mat3 constructor.
+        inline constexpr cmat3(
+            float p00, float p01, float p02,
+            float p10, float p11, float p12,
+            float p20, float p21, float p22
+        ) : _00(p00), _10(p10), _20(p20),
+            _01(p01), _11(p11), _21(p21),
+            _02(p02), _12(p12), _22(p22) {}
+
+        // Creates an identity matrix.
+        inline constexpr cmat3() :
+            _00(1.f), _10(0.f), _20(0.f),
+            _01(0.f), _11(1.f), _21(0.f),
+            _02(0.f), _12(0.f), _22(1.f) {}
+
+        inline constexpr explicit cmat3(const mat3& m) :
+            _00(m._00), _10(m._10), _20(m._20),
+            _01(m._01), _11(m._11), _21(m._21),
+            _02(m._02), _12(m._12), _22(m._22) {}
+
+        inline constexpr mat3 toMat3() const noexcept {
             return mat3(
-                _00 * m._00 + _01 * m._10 + _02 * m._20, _00 * m._01 + _01 * m._11 + _02 * m._21, _00 * m._02 + _01 * m._12 + _02 * m._22,
-                _10 * m._00 + _11 * m._10 + _12 * m._20, _10 * m._01 + _11 * m._11 + _12 * m._21, _10 * m._02 + _11 * m._12 + _12 * m._22,
-                _20 * m._00 + _21 * m._10 + _22 * m._20, _20 * m._01 + _21 * m._11 + _22 * m._21, _20 * m._02 + _21 * m._12 + _22 * m._22
+                _00, _01, _02,
+                _10, _11, _12,
+                _20, _21, _22
             );
         }
 
-        inline void operator*=(mat3 m) noexcept {
-            _00 = _00 * m._00 + _01 * m._10 + _02 * m._20;
-            _01 = _00 * m._01 + _01 * m._11 + _02 * m._21;
-            _02 = _00 * m._02 + _01 * m._12 + _02 * m._22;
-                
-            _10 = _10 * m._00 + _11 * m._10 + _12 * m._20;
-            _11 = _10 * m._01 + _11 * m._11 + _12 * m._21;
-            _12 = _10 * m._02 + _11 * m._12 + _12 * m._22;
-                
-            _20 = _20 * m._00 + _21 * m._10 + _22 * m._20;
-            _21 = _20 * m._01 + _21 * m._11 + _22 * m._21;
-            _22 = _20 * m._02 + _21 * m._12 + _22 * m._22;
+        inline constexpr mat3 transposedMat3() const noexcept {
+            return mat3(
+                _00, _10, _20,
+                _01, _11, _21,
+                _02, _12, _22
+            );
+        }
+
+        inline static constexpr cmat3 fromTransposedMat3(const mat3& m) noexcept {
+            return cmat3(
+                m._00, m._10, m._20,
+                m._01, m._11, m._21,
+                m._02, m._12, m._22
+            );
+        }
+
+        // returns a pointer to the 9 values of the matrix, column by column.
+        inline float* data() noexcept { return &_00; }
+        inline const float* data() const noexcept { return &_00; }
+
+        LINA_CONSTEXPR_SIMD cmat3 transposed() const noexcept {
+            return fromTransposedMat3(toMat3());
+        }
+
+        inline constexpr float determinant() const noexcept {
+            return transposedMat3().determinant();
+        }
+
+        LINA_CONSTEXPR_SIMD cmat3 inverse() const noexcept {
+            return fromTransposedMat3(transposedMat3().inverse());
+        }
+
+        inline constexpr bool operator==(const cmat3& o) const noexcept {
+            return transposedMat3() == o.transposedMat3();
+        }
+
+        inline constexpr cmat3 operator+(const cmat3& o) const noexcept {
+            return fromTransposedMat3(transposedMat3() + o.transposedMat3());
+        }
+
+        inline constexpr cmat3 operator-(const cmat3& o) const noexcept {
+            return fromTransposedMat3(transposedMat3() - o.transposedMat3());
+        }
+
+        LINA_CONSTEXPR_SIMD cmat3 operator*(const cmat3& o) const noexcept {
+            return fromTransposedMat3(o.transposedMat3() * transposedMat3());
+        }
+
+        LINA_CONSTEXPR_SIMD void operator*=(const cmat3& o) noexcept {
+            *this = *this * o;
         }
 
-        inline vec3 operator*(vec3 v) const noexcept {
+        inline constexpr vec3 operator*(vec3 v) const noexcept {
             return vec3(
-                v.x * _00 + v.x * _10 + v.x * _20,
-                v.y * _01 + v.y * _11 + v.y * _21,
-                v.z * _02 + v.z * _12 + v.z * _22
+                _00 * v.x + _01 * v.y + _02 * v.z,
+                _10 * v.x + _11 * v.y + _12 * v.z,
+                _20 * v.x + _21 * v.y + _22 * v.z
             );
         }
     };
 
-    struct mat2 {
-        union {float _00, _m11;}; union {float _01, _m12;};
-        union {float _10, _m21;}; union {float _11, _m22;};
+    struct cmat2 {
+        union {float _00, _m11;}; union {float _10, _m21;};
+        union {float _01, _m12;}; union {float _11, _m22;};
 
-        inline mat2(
+        // The values go row by row, like the mat2 constructor.
+        inline constexpr cmat2(
             float p00, float p01,
             float p10, float p11
-        ) {
-            _00 = p00; _01 = p01;
-            _10 = p10; _11 = p11;
+        ) : _00(p00), _10(p10),
+            _01(p01), _11(p11) {}
+
+        // Creates an identity matrix.
+        inline constexpr cmat2() :
+            _00(1.f), _10(0.f),
+            _01(0.f), _11(1.f) {}
+
+        inline constexpr explicit cmat2(const mat2& m) :
+            _00(m._00), _10(m._10),
+            _01(m._01), _11(m._11) {}
+
+        inline constexpr mat2 toMat2() const noexcept {
+            return mat2(
+                _00, _01,
+                _10, _11
+            );
         }
 
-        // Creates an Identity matrix.
-        inline mat2() {
-            _00 = 1.f; _01 = 0.f;
-            _10 = 0.f; _11 = 1.f;
+        inline constexpr mat2 transposedMat2() const noexcept {
+            return mat2(
+                _00, _10,
+                _01, _11
+            );
+        }
+
+        inline static constexpr cmat2 fromTransposedMat2(const mat2& m) noexcept {
+            return cmat2(
+                m._00, m._10,
+                m._01, m._11
+            );
+        }
+
+        inline constexpr float determinant() const noexcept {
+            return _00 * _11 - _01 * _10;
+        }
+
+        inline constexpr cmat2 inverse() const noexcept {
+            return fromTransposedMat2(transposedMat2().inverse());
+        }
+    };
+
+    static_assert(sizeof(cmat4) == sizeof(mat4) && sizeof(cmat3) == sizeof(mat3) && sizeof(cmat2) == sizeof(mat2),
+        "the column major matrices can't have padding");
+
+    namespace detail {
+        template <StorageOrder O> struct storage_types;
+        template <> struct storage_types<StorageOrder::RowMajor> { typedef mat4 mat4_type; typedef mat3 mat3_type; typedef mat2 mat2_type; };
+        template <> struct storage_types<StorageOrder::ColumnMajor> { typedef cmat4 mat4_type; typedef cmat3 mat3_type; typedef cmat2 mat2_type; };
+    }
+
+    // The matrix types for a storage order, mat4_t<StorageOrder::ColumnMajor> is cmat4.
+    template <StorageOrder O> using mat4_t = typename detail::storage_types<O>::mat4_type;
+    template <StorageOrder O> using mat3_t = typename detail::storage_types<O>::mat3_type;
+    template <StorageOrder O> using mat2_t = typename detail::storage_types<O>::mat2_type;
+
+    // Use 16 (or 9) floats you already have, a mapped uniform buffer for example, as a matrix
+    // stored in order O. Nothing gets copied, writing to the matrix writes to the buffer.
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline mat4_t<O>& asMat4(float* p) noexcept { return *reinterpret_cast<mat4_t<O>*>(p); }
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline const mat4_t<O>& asMat4(const float* p) noexcept { return *reinterpret_cast<const mat4_t<O>*>(p); }
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline mat3_t<O>& asMat3(float* p) noexcept { return *reinterpret_cast<mat3_t<O>*>(p); }
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline const mat3_t<O>& asMat3(const float* p) noexcept { return *reinterpret_cast<const mat3_t<O>*>(p); }
+
+    /*
+        Quaternions
+    */
+    // A rotation stored as a unit quaternion (x, y, z are the vector part, w is the scalar part).
+    // The rotations follow the same conventions as the rotation matrices, so quat::fromEuler(r).toMat4()
+    // is the same as mat4::rotation(r), and q1 * q2 rotates by q2 first and then by q1, just like
+    // multiplying the matrices would.
+    struct quat {
+        float x, y, z, w;
+
+        inline constexpr quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+        // Creates an identity quaternion (no rotation).
+        inline constexpr quat() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+
+        inline static constexpr quat identity() {
+            return quat();
+        }
+
+        // returns a quaternion that rotates `radians` around `axis`, the axis has to be normalized.
+        inline static quat fromAxisAngle(vec3 axis, float radians) noexcept {
+            float s = sinf(radians * 0.5f);
+            return quat(axis.x * s, axis.y * s, axis.z * s, cosf(radians * 0.5f));
+        }
+
+        inline static quat rotationX(float radians) noexcept {
+            return quat(sinf(radians * 0.5f), 0.f, 0.f, cosf(radians * 0.5f));
+        }
+
+        inline static quat rotationY(float radians) noexcept {
+            return quat(0.f, sinf(radians * 0.5f), 0.f, cosf(radians * 0.5f));
+        }
+
+        inline static quat rotationZ(float radians) noexcept {
+            return quat(0.f, 0.f, sinf(radians * 0.5f), cosf(radians * 0.5f));
+        }
+
+        // returns the same rotation as mat4::rotation(radians), which is rotationX * rotationY * rotationZ,
+        // but with 3 sin/cos pairs and no products.
+        inline static quat fromEuler(vec3 radians) noexcept {
+            float cx = cosf(radians.x * 0.5f), sx = sinf(radians.x * 0.5f);
+            float cy = cosf(radians.y * 0.5f), sy = sinf(radians.y * 0.5f);
+            float cz = cosf(radians.z * 0.5f), sz = sinf(radians.z * 0.5f);
+            return quat(
+                sx * cy * cz + cx * sy * sz,
+                cx * sy * cz - sx * cy * sz,
+                cx * cy * sz + sx * sy * cz,
+                cx * cy * cz - sx * sy * sz
+            );
+        }
+
+        inline constexpr float dot(quat o) const noexcept {
+            return x * o.x + y * o.y + z * o.z + w * o.w;
+        }
+
+        template <typename P = precise>
+        inline float length() const noexcept {
+            return P::sqrt(dot(*this));
+        }
+
+        template <typename P = precise>
+        inline void normalize() noexcept {
+            *this = normalized<P>();
+        }
+
+        template <typename P = precise>
+        inline quat normalized() const noexcept {
+            float inv = P::rsqrt(dot(*this));
+            return quat(x * inv, y * inv, z * inv, w * inv);
+        }
+
+        // returns the opposite rotation, for a unit quaternion that's also the inverse.
+        inline constexpr quat conjugate() const noexcept {
+            return quat(-x, -y, -z, w);
+        }
+
+        inline constexpr quat inverse() const noexcept {
+            return quat(-x / dot(*this), -y / dot(*this), -z / dot(*this), w / dot(*this));
+        }
+
+        // Operators
+        inline constexpr bool operator==(quat o) const noexcept {
+            return x == o.x && y == o.y && z == o.z && w == o.w;
+        }
+
+        inline constexpr quat operator-() const noexcept {
+            return quat(-x, -y, -z, -w);
+        }
+
+        inline constexpr quat operator+(quat o) const noexcept {
+            return quat(x + o.x, y + o.y, z + o.z, w + o.w);
+        }
+
+        inline constexpr quat operator*(float s) const noexcept {
+            return quat(x * s, y * s, z * s, w * s);
+        }
+
+        // Hamilton product, the result rotates by `o` first and then by this quaternion.
+        LINA_CONSTEXPR_SIMD quat operator*(quat o) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return quat(
+                    w * o.x + x * o.w + y * o.z - z * o.y,
+                    w * o.y - x * o.z + y * o.w + z * o.x,
+                    w * o.z + x * o.y - y * o.x + z * o.w,
+                    w * o.w - x * o.x - y * o.y - z * o.z
+                );
+            }
+            quat r;
+            detail::quat_mul(&x, &o.x, &r.x);
+            return r;
+        }
+
+        LINA_CONSTEXPR_SIMD void operator*=(quat o) noexcept {
+            *this = *this * o;
+        }
+
+        // rotates `v`, the quaternion has to be normalized.
+        LINA_CONSTEXPR_SIMD vec3 rotate(vec3 v) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                vec3 t = vec3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x) * 2.f;
+                return v + t * w + vec3(y * t.z - z * t.y, z * t.x - x * t.z, x * t.y - y * t.x);
+            }
+            vec3 r;
+            detail::quat_rotate(&x, &v.x, &r.x);
+            return r;
+        }
+
+        LINA_CONSTEXPR_SIMD vec3 operator*(vec3 v) const noexcept {
+            return rotate(v);
+        }
+
+        // returns the rotation matrix of this quaternion, the quaternion has to be normalized.
+        inline constexpr mat3 toMat3() const noexcept {
+            return mat3(
+                1.f - 2.f * (y * y + z * z), 2.f * (x * y - w * z),       2.f * (x * z + w * y),
+                2.f * (x * y + w * z),       1.f - 2.f * (x * x + z * z), 2.f * (y * z - w * x),
+                2.f * (x * z - w * y),       2.f * (y * z + w * x),       1.f - 2.f * (x * x + y * y)
+            );
+        }
+
+        inline constexpr mat4 toMat4() const noexcept {
+            return mat4(
+                1.f - 2.f * (y * y + z * z), 2.f * (x * y - w * z),       2.f * (x * z + w * y),       0.f,
+                2.f * (x * y + w * z),       1.f - 2.f * (x * x + z * z), 2.f * (y * z - w * x),       0.f,
+                2.f * (x * z - w * y),       2.f * (y * z + w * x),       1.f - 2.f * (x * x + y * y), 0.f,
+                0.f,                         0.f,                         0.f,                         1.f
+            );
+        }
+
+        // Linear interpolation followed by a normalize, takes the short way around.
+        // Cheaper than slerp, but the speed isn't constant over `t`.
+        inline static quat nlerp(quat a, quat b, float t) noexcept {
+            if (a.dot(b) < 0.f) b = -b;
+            return (a * (1.f - t) + b * t).normalized();
+        }
+
+        // Spherical linear interpolation, takes the short way around at a constant speed.
+        inline static quat slerp(quat a, quat b, float t) noexcept {
+            float d = a.dot(b);
+            if (d < 0.f) {
+                b = -b;
+                d = -d;
+            }
+            // Too close to each other for sin(theta) to be accurate, nlerp is just as good here.
+            if (d > 0.9995f) return (a * (1.f - t) + b * t).normalized();
+            float theta = acosf(d);
+            float s = 1.f / sinf(theta);
+            return a * (sinf((1.f - t) * theta) * s) + b * (sinf(t * theta) * s);
+        }
+    };
+
+    /*
+        Affine matrices
+    */
+    // A 3x4 matrix for transforms that only translate, rotate, scale and shear, so a mat4 with a
+    // bottom row of 0 0 0 1. That bottom row isn't stored, which makes it 12 floats instead of 16,
+    // and combining two of them only takes 36 multiplies instead of 64.
+    // The members are named the same way as in mat4 (see 'Matrices').
+    struct affine3 {
+        union {float _00, _m11;}; union {float _01, _m12;}; union {float _02, _m13;}; union {float _03, _m14;};
+        union {float _10, _m21;}; union {float _11, _m22;}; union {float _12, _m23;}; union {float _13, _m24;};
+        union {float _20, _m31;}; union {float _21, _m32;}; union {float _22, _m33;}; union {float _23, _m34;};
+
+        inline constexpr affine3(
+            float p00, float p01, float p02, float p03,
+            float p10, float p11, float p12, float p13,
+            float p20, float p21, float p22, float p23
+        ) : _00(p00), _01(p01), _02(p02), _03(p03),
+            _10(p10), _11(p11), _12(p12), _13(p13),
+            _20(p20), _21(p21), _22(p22), _23(p23) {}
+
+        // Creates an affine matrix from a 3x3 linear part and a translation.
+        inline constexpr affine3(mat3 m, vec3 T) :
+            _00(m._00), _01(m._01), _02(m._02), _03(T.x),
+            _10(m._10), _11(m._11), _12(m._12), _13(T.y),
+            _20(m._20), _21(m._21), _22(m._22), _23(T.z) {}
+
+        // Creates an identity matrix.
+        inline constexpr affine3() :
+            _00(1.f), _01(0.f), _02(0.f), _03(0.f),
+            _10(0.f), _11(1.f), _12(0.f), _13(0.f),
+            _20(0.f), _21(0.f), _22(1.f), _23(0.f) {}
+
+        inline static constexpr affine3 identity() {
+            return affine3();
+        }
+
+        // returns the top 3 rows of `m`, the bottom row is assumed to be 0 0 0 1.
+        inline static constexpr affine3 fromMat4(mat4 m) {
+            return affine3(
+                m._00, m._01, m._02, m._03,
+                m._10, m._11, m._12, m._13,
+                m._20, m._21, m._22, m._23
+            );
+        }
+
+        // returns the same matrix as a mat4, this is lossless.
+        inline constexpr mat4 toMat4() const noexcept {
+            return mat4(
+                _00, _01, _02, _03,
+                _10, _11, _12, _13,
+                _20, _21, _22, _23,
+                0.f, 0.f, 0.f, 1.f
+            );
+        }
+
+        inline constexpr mat3 linear() const noexcept {
+            return mat3(
+                _00, _01, _02,
+                _10, _11, _12,
+                _20, _21, _22
+            );
+        }
+
+        inline constexpr vec3 translationPart() const noexcept {
+            return vec3(_03, _13, _23);
+        }
+
+        // returns a pointer to the 12 values of the matrix, row by row.
+        inline float* data() noexcept { return &_00; }
+        inline const float* data() const noexcept { return &_00; }
+
+        // Operations
+        inline static constexpr affine3 translation(vec3 T) noexcept {
+            return affine3(
+                1.f, 0.f, 0.f, T.x,
+                0.f, 1.f, 0.f, T.y,
+                0.f, 0.f, 1.f, T.z
+            );
         }
 
+        inline static constexpr affine3 scalation(vec3 S) noexcept {
+            return affine3(
+                S.x, 0.f, 0.f, 0.f,
+                0.f, S.y, 0.f, 0.f,
+                0.f, 0.f, S.z, 0.f
+            );
+        }
+
+        template <typename P = precise>
+        inline static affine3 rotationX(float radians) noexcept {
+            float s, c;
+            P::sincos(radians, s, c);
+            return affine3(
+                1.f, 0.f, 0.f, 0.f,
+                0.f, c,   -s,  0.f,
+                0.f, s,   c,   0.f
+            );
+        }
+
+        template <typename P = precise>
+        inline static affine3 rotationY(float radians) noexcept {
+            float s, c;
+            P::sincos(radians, s, c);
+            return affine3(
+                c,   0.f, s,   0.f,
+                0.f, 1.f, 0.f, 0.f,
+                -s,  0.f, c,   0.f
+            );
+        }
+
+        template <typename P = precise>
+        inline static affine3 rotationZ(float radians) noexcept {
+            float s, c;
+            P::sincos(radians, s, c);
+            return affine3(
+                c,   -s,  0.f, 0.f,
+                s,   c,   0.f, 0.f,
+                0.f, 0.f, 1.f, 0.f
+            );
+        }
+
+        // same as mat4::rotation, rotationX * rotationY * rotationZ.
+        template <typename P = precise>
+        inline static affine3 rotation(vec3 radians) noexcept {
+            return fromEuler<P>(radians);
+        }
+
+        // same as mat4::fromEuler.
+        template <typename P = precise>
+        inline static affine3 fromEuler(vec3 radians, EulerOrder order = EulerOrder::XYZ) noexcept {
+            float r[9];
+            detail::euler_rotation<P>(radians, order, r);
+            return affine3(
+                r[0], r[1], r[2], 0.f,
+                r[3], r[4], r[5], 0.f,
+                r[6], r[7], r[8], 0.f
+            );
+        }
+
+        // returns translation(T) * rotation * scalation(S) without doing any products.
+        inline static constexpr affine3 fromTRS(vec3 T, quat R, vec3 S) noexcept {
+            return affine3(
+                (1.f - 2.f * (R.y * R.y + R.z * R.z)) * S.x, 2.f * (R.x * R.y - R.w * R.z) * S.y,         2.f * (R.x * R.z + R.w * R.y) * S.z,         T.x,
+                2.f * (R.x * R.y + R.w * R.z) * S.x,         (1.f - 2.f * (R.x * R.x + R.z * R.z)) * S.y, 2.f * (R.y * R.z - R.w * R.x) * S.z,         T.y,
+                2.f * (R.x * R.z - R.w * R.y) * S.x,         2.f * (R.y * R.z + R.w * R.x) * S.y,         (1.f - 2.f * (R.x * R.x + R.y * R.y)) * S.z, T.z
+            );
+        }
+
+        // transforms `p` as a point, so the translation is applied.
+        inline constexpr vec3 transformPoint(vec3 p) const noexcept {
+            return vec3(
+                _00 * p.x + _01 * p.y + _02 * p.z + _03,
+                _10 * p.x + _11 * p.y + _12 * p.z + _13,
+                _20 * p.x + _21 * p.y + _22 * p.z + _23
+            );
+        }
+
+        // transforms `d` as a direction, so the translation is ignored.
+        inline constexpr vec3 transformDirection(vec3 d) const noexcept {
+            return vec3(
+                _00 * d.x + _01 * d.y + _02 * d.z,
+                _10 * d.x + _11 * d.y + _12 * d.z,
+                _20 * d.x + _21 * d.y + _22 * d.z
+            );
+        }
+
+        // returns the inverse, which is also affine. The result is garbage (inf/nan) if the
+        // matrix can't be inverted (a scale of 0 for example).
+        LINA_CONSTEXPR_SIMD affine3 inverse() const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return inverseWithLinear(linear().inverse());
+            }
+            affine3 r;
+            detail::affine3_inverse(data(), r.data());
+            return r;
+        }
+
+        // Conditions
+        inline constexpr bool isIdentity() const noexcept {
+            return _00 == 1.f && _01 == 0.f && _02 == 0.f && _03 == 0.f &&
+                   _10 == 0.f && _11 == 1.f && _12 == 0.f && _13 == 0.f &&
+                   _20 == 0.f && _21 == 0.f && _22 == 1.f && _23 == 0.f ;
+        }
+
+        // Operators
+        inline constexpr bool operator==(affine3 o) const noexcept {
+            return _00 == o._00 && _01 == o._01 && _02 == o._02 && _03 == o._03 &&
+                   _10 == o._10 && _11 == o._11 && _12 == o._12 && _13 == o._13 &&
+                   _20 == o._20 && _21 == o._21 && _22 == o._22 && _23 == o._23 ;
+        }
+
+        LINA_CONSTEXPR_SIMD affine3 operator*(affine3 m) const noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                return affine3(
+                    _00 * m._00 + _01 * m._10 + _02 * m._20, _00 * m._01 + _01 * m._11 + _02 * m._21, _00 * m._02 + _01 * m._12 + _02 * m._22, _00 * m._03 + _01 * m._13 + _02 * m._23 + _03,
+                    _10 * m._00 + _11 * m._10 + _12 * m._20, _10 * m._01 + _11 * m._11 + _12 * m._21, _10 * m._02 + _11 * m._12 + _12 * m._22, _10 * m._03 + _11 * m._13 + _12 * m._23 + _13,
+                    _20 * m._00 + _21 * m._10 + _22 * m._20, _20 * m._01 + _21 * m._11 + _22 * m._21, _20 * m._02 + _21 * m._12 + _22 * m._22, _20 * m._03 + _21 * m._13 + _22 * m._23 + _23
+                );
+            }
+            affine3 r;
+            detail::affine3_mul(data(), m.data(), r.data());
+            return r;
+        }
+
+        LINA_CONSTEXPR_SIMD void operator*=(affine3 m) noexcept {
+            if (LINA_IS_CONSTANT_EVALUATED()) {
+                *this = *this * m;
+                return;
+            }
+            detail::affine3_mul(data(), m.data(), data());
+        }
+
+        inline constexpr vec4 operator*(vec4 v) const noexcept {
+            return vec4(
+                _00 * v.x + _01 * v.y + _02 * v.z + _03 * v.w,
+                _10 * v.x + _11 * v.y + _12 * v.z + _13 * v.w,
+                _20 * v.x + _21 * v.y + _22 * v.z + _23 * v.w,
+                v.w
+            );
+        }
+
+    private:
+        inline constexpr affine3 inverseWithLinear(mat3 i) const noexcept {
+            return affine3(i, vec3(
+                -(i._00 * _03 + i._01 * _13 + i._02 * _23),
+                -(i._10 * _03 + i._11 * _13 + i._12 * _23),
+                -(i._20 * _03 + i._21 * _13 + i._22 * _23)
+            ));
+        }
     };
 
-    inline mat4 CreateRMCameraViewMatrix(vec3 position, vec3 right, vec3 up, vec3 forward) noexcept {
-        return lina::mat4({
+    /*
+        Transforms
+    */
+    // A translation, rotation and scale kept apart, the matrix is translation * rotation * scalation.
+    // The matrix is only built when you ask for it, and then kept until something changes.
+    struct Transform {
+        // Creates an identity transform.
+        inline Transform() noexcept : t(0.f, 0.f, 0.f), r(), s(1.f, 1.f, 1.f), dirty(true) {}
+
+        inline Transform(vec3 translation, quat rotation = quat(), vec3 scale = vec3(1.f, 1.f, 1.f)) noexcept
+            : t(translation), r(rotation), s(scale), dirty(true) {}
+
+        inline vec3 translation() const noexcept { return t; }
+        inline quat rotation() const noexcept { return r; }
+        inline vec3 scale() const noexcept { return s; }
+
+        inline void setTranslation(vec3 T) noexcept { t = T; dirty = true; }
+        inline void setRotation(quat R) noexcept { r = R; dirty = true; }
+        inline void setScale(vec3 S) noexcept { s = S; dirty = true; }
+
+        // moves it by T, in the space of the parent (so the rotation and scale don't affect T).
+        inline void translate(vec3 T) noexcept {
+            t = vec3(t.x + T.x, t.y + T.y, t.z + T.z);
+            dirty = true;
+        }
+
+        // rotates it by R around its own origin, in the space of the parent.
+        inline void rotate(quat R) noexcept {
+            r = R * r;
+            dirty = true;
+        }
+
+        // true if the next matrix() call has to rebuild the matrix.
+        inline bool isDirty() const noexcept { return dirty; }
+
+        // returns translation * rotation * scalation (a row major model matrix, the same as
+        // CreateRMModelMatrix). Only rebuilt if the transform changed since the last call, which
+        // also means two threads can't call this on the same dirty transform at the same time.
+        inline const mat4& matrix() const noexcept {
+            if (dirty) {
+                cache = affine3::fromTRS(t, r, s).toMat4();
+                dirty = false;
+            }
+            return cache;
+        }
+
+        // the same as matrix() as an affine3, always built directly (it isn't cached).
+        inline affine3 affine() const noexcept {
+            return affine3::fromTRS(t, r, s);
+        }
+
+        inline vec3 transformPoint(vec3 p) const noexcept {
+            vec3 v = r.rotate(vec3(p.x * s.x, p.y * s.y, p.z * s.z));
+            return vec3(v.x + t.x, v.y + t.y, v.z + t.z);
+        }
+
+        inline vec3 transformDirection(vec3 d) const noexcept {
+            return r.rotate(vec3(d.x * s.x, d.y * s.y, d.z * s.z));
+        }
+
+        // returns the transform that does `o` first and then this one, like multiplying the matrices.
+        // A TRS can't hold a shear, so this is only exact if this transform's scale is uniform
+        // (or `o` doesn't rotate), otherwise the result just multiplies the scales together.
+        inline Transform operator*(const Transform& o) const noexcept {
+            return Transform(transformPoint(o.t), r * o.r, vec3(s.x * o.s.x, s.y * o.s.y, s.z * o.s.z));
+        }
+
+        inline void operator*=(const Transform& o) noexcept {
+            *this = *this * o;
+        }
+
+        // returns the transform that undoes this one, the rotation has to be normalized and the
+        // scale can't have a 0 in it. Exact for a uniform scale, for the same reason as operator*.
+        inline Transform inverse() const noexcept {
+            quat ri = r.conjugate();
+            vec3 si(1.f / s.x, 1.f / s.y, 1.f / s.z);
+            vec3 ti = ri.rotate(t);
+            return Transform(vec3(-ti.x * si.x, -ti.y * si.y, -ti.z * si.z), ri, si);
+        }
+
+        // interpolates the translation and the scale linearly and the rotation with quat::slerp,
+        // `t` is 0 for `a` and 1 for `b`.
+        inline static Transform interpolate(const Transform& a, const Transform& b, float t) noexcept {
+            float u = 1.f - t;
+            return Transform(
+                vec3(a.t.x * u + b.t.x * t, a.t.y * u + b.t.y * t, a.t.z * u + b.t.z * t),
+                quat::slerp(a.r, b.r, t),
+                vec3(a.s.x * u + b.s.x * t, a.s.y * u + b.s.y * t, a.s.z * u + b.s.z * t)
+            );
+        }
+
+    private:
+        vec3 t;
+        quat r;
+        vec3 s;
+        mutable mat4 cache;
+        mutable bool dirty;
+    };
+
+    // The builders below take the storage order of the matrix they return as a template parameter,
+    // CreateModelMatrix<StorageOrder::ColumnMajor>(...) returns a cmat4 that's ready to upload. The
+    // CreateRM* and CreateCM* versions return a mat4 that's laid out row major / column major in memory.
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline constexpr mat4_t<O> CreateCameraViewMatrix(vec3 position, vec3 right, vec3 up, vec3 forward) noexcept {
+        return mat4_t<O>(
             right.x,    right.y,    right.z,    -right.dot(position),
             up.x,       up.y,       up.z,       -up.dot(position),
             -forward.x, -forward.y, -forward.z, forward.dot(position),
-            0,          0,          0,          1
-        });
-    }
-
-    inline mat4 CreateCMCameraViewMatrix(vec3 position, vec3 right, vec3 up, vec3 forward) noexcept {
-        return lina::mat4({
-            right.x, up.x, -forward.x, 0,
-            right.y, up.y, -forward.y, 0,
-            right.z, up.z, -forward.z, 0,
-            -right.dot(position), -up.dot(position), forward.dot(position), 1
-        });
+            0.f,        0.f,        0.f,        1.f
+        );
     }
 
-    inline mat4 CreateRMCameraPerspectiveMatrix(ivec2 screen_size, float fov, float CloseRenderDistance, float RenderDistance, lina::vec3 cam_offset = {0, 0, 1}) noexcept {
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline mat4_t<O> CreateCameraPerspectiveMatrix(ivec2 screen_size, float fov, float CloseRenderDistance, float RenderDistance, lina::vec3 cam_offset = {0, 0, 1}) noexcept {
         float cotan_rads_2 = cot(0.5 * dtor(fov));
         
-        return lina::mat4 ({
+        return mat4_t<O>(
             cotan_rads_2 * screen_size.y/screen_size.x, 0, 0, cam_offset.x,
             0, cotan_rads_2, 0, cam_offset.y,
             0, 0, RenderDistance / (CloseRenderDistance - RenderDistance), -cam_offset.z,
             0, 0, -(RenderDistance * CloseRenderDistance) / (RenderDistance - CloseRenderDistance), 0
-        });
+        );
     }
 
-    inline mat4 CreateCMCameraPerspectiveMatrix(ivec2 screen_size, float fov, float CloseRenderDistance, float RenderDistance, lina::vec3 cam_offset = {0, 0, 1}) noexcept{
-        float cotan_rads_2 = cot(0.5 * dtor(fov));
-        
-        return lina::mat4 ({
-            cotan_rads_2 * screen_size.y/screen_size.x, 0, 0, 0,
-            0, cotan_rads_2, 0, 0,
-            0, 0, RenderDistance / (CloseRenderDistance - RenderDistance), -(RenderDistance * CloseRenderDistance) / (RenderDistance - CloseRenderDistance),
-            cam_offset.x, cam_offset.y, -cam_offset.z, 0
-        });
+    // translation * rotationX * rotationY * rotationZ * scalation, without doing the products.
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline mat4_t<O> CreateModelMatrix(vec3 position, vec3 rotation, vec4 scale = {1,1,1,1}) noexcept {
+        float r[9];
+        detail::euler_rotation<precise>(rotation, EulerOrder::XYZ, r);
+        return mat4_t<O>(
+            r[0] * scale.x, r[1] * scale.y, r[2] * scale.z, position.x * scale.w,
+            r[3] * scale.x, r[4] * scale.y, r[5] * scale.z, position.y * scale.w,
+            r[6] * scale.x, r[7] * scale.y, r[8] * scale.z, position.z * scale.w,
+            0.f, 0.f, 0.f, scale.w
+        );
+    }
+
+    // Same as translation * rotation * scalation, but built directly from the quaternion without any products.
+    template <StorageOrder O = StorageOrder::RowMajor>
+    inline constexpr mat4_t<O> CreateModelMatrix(vec3 position, quat rotation, vec4 scale = {1,1,1,1}) noexcept {
+        return mat4_t<O>(
+            (1.f - 2.f * (rotation.y * rotation.y + rotation.z * rotation.z)) * scale.x, 2.f * (rotation.x * rotation.y - rotation.w * rotation.z) * scale.y, 2.f * (rotation.x * rotation.z + rotation.w * rotation.y) * scale.z, position.x * scale.w,
+            2.f * (rotation.x * rotation.y + rotation.w * rotation.z) * scale.x, (1.f - 2.f * (rotation.x * rotation.x + rotation.z * rotation.z)) * scale.y, 2.f * (rotation.y * rotation.z - rotation.w * rotation.x) * scale.z, position.y * scale.w,
+            2.f * (rotation.x * rotation.z - rotation.w * rotation.y) * scale.x, 2.f * (rotation.y * rotation.z + rotation.w * rotation.x) * scale.y, (1.f - 2.f * (rotation.x * rotation.x + rotation.y * rotation.y)) * scale.z, position.z * scale.w,
+            0.f, 0.f, 0.f, scale.w
+        );
+    }
+
+    inline constexpr mat4 CreateRMCameraViewMatrix(vec3 position, vec3 right, vec3 up, vec3 forward) noexcept {
+        return CreateCameraViewMatrix(position, right, up, forward);
+    }
+
+    inline constexpr mat4 CreateCMCameraViewMatrix(vec3 position, vec3 right, vec3 up, vec3 forward) noexcept {
+        return CreateCameraViewMatrix<StorageOrder::ColumnMajor>(position, right, up, forward).transposedMat4();
+    }
+
+    inline mat4 CreateRMCameraPerspectiveMatrix(ivec2 screen_size, float fov, float CloseRenderDistance, float RenderDistance, lina::vec3 cam_offset = {0, 0, 1}) noexcept {
+        return CreateCameraPerspectiveMatrix(screen_size, fov, CloseRenderDistance, RenderDistance, cam_offset);
+    }
+
+    inline mat4 CreateCMCameraPerspectiveMatrix(ivec2 screen_size, float fov, float CloseRenderDistance, float RenderDistance, lina::vec3 cam_offset = {0, 0, 1}) noexcept {
+        return CreateCameraPerspectiveMatrix<StorageOrder::ColumnMajor>(screen_size, fov, CloseRenderDistance, RenderDistance, cam_offset).transposedMat4();
     }
 
     inline mat4 CreateRMModelMatrix(vec3 position, vec3 rotation, vec4 scale = {1,1,1,1}) noexcept {
-        return mat4::translation(position) * mat4::rotationX(rotation.x) * mat4::rotationY(rotation.y) * mat4::rotationZ(rotation.z) * mat4::scalation(scale);
+        return CreateModelMatrix(position, rotation, scale);
     }
     
     inline mat4 CreateCMModelMatrix(vec3 position, vec3 rotation, vec4 scale = {1,1,1,1}) noexcept {
-        return (mat4::translation(position) * mat4::rotationX(rotation.x) * mat4::rotationY(rotation.y) * mat4::rotationZ(rotation.z) * mat4::scalation(scale)).transposed();
+        return CreateModelMatrix<StorageOrder::ColumnMajor>(position, rotation, scale).transposedMat4();
+    }
+
+    inline constexpr mat4 CreateRMModelMatrix(vec3 position, quat rotation, vec4 scale = {1,1,1,1}) noexcept {
+        return CreateModelMatrix(position, rotation, scale);
+    }
+
+    inline constexpr mat4 CreateCMModelMatrix(vec3 position, quat rotation, vec4 scale = {1,1,1,1}) noexcept {
+        return CreateModelMatrix<StorageOrder::ColumnMajor>(position, rotation, scale).transposedMat4();
     }
 
+    template <typename P = precise>
     inline vec3 CalculateCameraForwardVector(float pitch, float yaw) {
-        return vec3(
-            cosf(pitch) * cosf(yaw),
-            sinf(pitch),
-            cosf(pitch) * sinf(yaw)
-        ).normalized();
+        float sp, cp, sy, cy;
+        P::sincos(pitch, sp, cp);
+        P::sincos(yaw, sy, cy);
+        return vec3(cp * cy, sp, cp * sy).normalized<P>();
     }
 
     inline vec3 CalculateCameraRightVector(vec3 vecForward, vec3 vecGlobalUp = /* Y axis */{0, 1, 0}) {
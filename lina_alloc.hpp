@@ -0,0 +1,174 @@
+#ifndef LINA_ALLOC_HPP
+#define LINA_ALLOC_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include <stdint.h>
+#include <new>
+#include <vector>
+
+/*
+
+###################
+    Allocators
+###################
+Two allocators for arrays of vectors and matrices.
+
+'aligned_allocator' is a std allocator that puts every array on a
+LINA_STREAM_ALIGNMENT (64 by default) byte boundary, or the alignment of the
+type if that's bigger. 'aligned_vector' is a std::vector that uses it:
+    lina::aligned_vector<mat4a> worlds(1000);
+A mat4 is 64 bytes, so in an aligned_vector every one of them is on its own
+cache line, even without using mat4a.
+
+================
+  Frame Arena
+================
+A 'FrameArena' is for the arrays that only live for one frame (the world
+matrices of everything that's visible, skinning palettes, ...). Allocating
+just moves a pointer forward, and reset() throws everything away at once:
+    FrameArena arena;
+    ...
+    arena.reset();  // at the start of every frame
+    mat4* palette = arena.allocate<mat4>(bone_count);
+    arena_vector<vec3> points(arena);
+
+The arena gets its memory in big blocks (1MB by default) and keeps them across
+reset(), so once it has seen the biggest frame there are no more heap
+allocations at all. Every allocation starts on a LINA_STREAM_ALIGNMENT byte
+boundary (or the alignment of the type if that's bigger).
+
+A few things to keep in mind:
+    - allocate() doesn't construct anything, write the values before reading them.
+    - Nothing gets destroyed on reset(), so only put types in it that don't
+      need their destructor to run (all the lina types are fine).
+    - reset() invalidates everything that was allocated, including the
+      arena_vectors, so don't keep them across frames.
+    - It isn't thread safe, give every thread its own arena.
+
+*/
+
+namespace lina {
+    template <typename T, size_t Alignment = (alignof(T) > LINA_STREAM_ALIGNMENT ? alignof(T) : LINA_STREAM_ALIGNMENT)>
+    struct aligned_allocator {
+        typedef T value_type;
+        template <typename U> struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+        aligned_allocator() noexcept {}
+        template <typename U>
+        aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+        T* allocate(size_t n) {
+            if (n > (size_t)-1 / sizeof(T)) throw std::bad_alloc();
+            return static_cast<T*>(detail::aligned_malloc(n ? n * sizeof(T) : 1, Alignment));
+        }
+        void deallocate(T* p, size_t) noexcept { detail::aligned_free(p); }
+    };
+
+    template <typename T, typename U, size_t A>
+    inline bool operator==(const aligned_allocator<T, A>&, const aligned_allocator<U, A>&) noexcept { return true; }
+    template <typename T, typename U, size_t A>
+    inline bool operator!=(const aligned_allocator<T, A>&, const aligned_allocator<U, A>&) noexcept { return false; }
+
+    template <typename T>
+    using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+    struct FrameArena {
+        explicit FrameArena(size_t block_size = 1 << 20) noexcept : block_size(block_size), current(0), offset(0) {}
+        ~FrameArena() {
+            for (const block& b : blocks) detail::aligned_free(b.data);
+        }
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // Returns `size` bytes starting on a multiple of `alignment`, which has to be a power of 2.
+        void* allocateBytes(size_t size, size_t alignment = LINA_STREAM_ALIGNMENT) {
+            if (alignment < LINA_STREAM_ALIGNMENT) alignment = LINA_STREAM_ALIGNMENT;
+            for (; current < blocks.size(); current++, offset = 0) {
+                const block& b = blocks[current];
+                uintptr_t start = ((uintptr_t)b.data + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+                if (start + size <= (uintptr_t)b.data + b.size) {
+                    offset = start + size - (uintptr_t)b.data;
+                    return (void*)start;
+                }
+            }
+            // None of the blocks have room left, the new one gets put at the end so the
+            // allocations stay in order for the next frame.
+            if (size > (size_t)-1 - alignment) throw std::bad_alloc();
+            size_t bytes = size + alignment > block_size ? size + alignment : block_size;
+            block b = {(char*)detail::aligned_malloc(bytes, LINA_STREAM_ALIGNMENT), bytes};
+            try {
+                blocks.push_back(b);
+            } catch (...) {
+                detail::aligned_free(b.data);
+                throw;
+            }
+            current = blocks.size() - 1;
+            uintptr_t start = ((uintptr_t)b.data + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            offset = start + size - (uintptr_t)b.data;
+            return (void*)start;
+        }
+
+        // Room for `n` Ts, not constructed.
+        template <typename T>
+        T* allocate(size_t n) {
+            if (n > (size_t)-1 / sizeof(T)) throw std::bad_alloc();
+            return static_cast<T*>(allocateBytes(n * sizeof(T), alignof(T)));
+        }
+
+        // Frees everything that was allocated, but keeps the memory for the next frame.
+        void reset() noexcept {
+            current = 0;
+            offset = 0;
+        }
+
+        // The bytes handed out since the last reset(), counting the alignment padding and
+        // the space left over at the end of full blocks.
+        size_t used() const noexcept {
+            size_t n = offset;
+            for (size_t i = 0; i < current && i < blocks.size(); i++) n += blocks[i].size;
+            return n;
+        }
+
+        // The bytes the arena holds on to.
+        size_t capacity() const noexcept {
+            size_t n = 0;
+            for (const block& b : blocks) n += b.size;
+            return n;
+        }
+
+    private:
+        struct block {
+            char* data;
+            size_t size;
+        };
+        std::vector<block> blocks;
+        size_t block_size;
+        size_t current;  // the block allocations come from
+        size_t offset;   // where the next allocation starts in that block
+    };
+
+    // A std allocator that gets its memory from a FrameArena, deallocate doesn't do anything.
+    template <typename T>
+    struct arena_allocator {
+        typedef T value_type;
+        FrameArena* arena;
+
+        arena_allocator(FrameArena& a) noexcept : arena(&a) {}
+        template <typename U>
+        arena_allocator(const arena_allocator<U>& o) noexcept : arena(o.arena) {}
+
+        T* allocate(size_t n) { return arena->allocate<T>(n); }
+        void deallocate(T*, size_t) noexcept {}
+    };
+
+    template <typename T, typename U>
+    inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept { return a.arena == b.arena; }
+    template <typename T, typename U>
+    inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept { return a.arena != b.arena; }
+
+    template <typename T>
+    using arena_vector = std::vector<T, arena_allocator<T>>;
+}
+
+#endif /* LINA_ALLOC_HPP */
@@ -0,0 +1,280 @@
+#ifndef LINA_BATCH_HPP
+#define LINA_BATCH_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_task.hpp"
+#include <vector>
+
+/*
+
+###################
+  Batch Transforms
+###################
+These apply one mat4 to a whole array of vectors, which is a lot faster than
+calling mat4 * vec4 in a loop because the matrix only gets loaded once and
+the vectors get transformed 4 or 8 at a time (see 'SIMD' in lina.hpp).
+
+    transformPoints:     transforms vec3s as points, so the translation is applied (w = 1).
+                         There's also an overload for vec4s which uses their own w.
+    transformDirections: transforms vec3s as directions, so the translation is ignored (w = 0).
+
+Every function has an in-place version that only takes one span, and a version
+that takes Vec3Stream/Vec4Stream instead of arrays. The vec3 versions only
+use the first 3 rows of the matrix, so there's no perspective divide, use the
+vec4 overload if you need the w. The vec3 versions also take an affine3.
+
+'out' needs to be at least as big as 'in', and it's fine for them to be the same array.
+
+================
+  Threading
+================
+Big batches are split across threads by the task scheduler (see 'Tasks' in
+lina_task.hpp). Each task gets at least 'batchThreshold()' vectors, so
+anything smaller than twice that just runs on the calling thread. The number
+of threads is 'batchThreadCount()', which is the number of hardware threads
+unless you set it with 'setBatchThreadCount()'. Changing either setting while
+a batch is running isn't safe.
+
+The same settings apply to every other bulk function in lina (culling,
+skinning, the stream operations, packing, ...), and they all run on
+whatever executor setExecutor() was given.
+
+*/
+
+namespace lina {
+    namespace detail {
+        enum { batch_block = 256 };
+
+        // Transforms `n` vec3s from 3 component arrays, `point` decides if the translation is added.
+        inline void transform3_soa(const float* m, bool point, const float* x, const float* y, const float* z,
+                                   float* ox, float* oy, float* oz, size_t n) noexcept {
+            floatv m00 = setv(m[0]), m01 = setv(m[1]), m02 = setv(m[2]), m03 = setv(point ? m[3] : 0.f);
+            floatv m10 = setv(m[4]), m11 = setv(m[5]), m12 = setv(m[6]), m13 = setv(point ? m[7] : 0.f);
+            floatv m20 = setv(m[8]), m21 = setv(m[9]), m22 = setv(m[10]), m23 = setv(point ? m[11] : 0.f);
+            const float* in[3] = {x, y, z};
+            float* out[3] = {ox, oy, oz};
+            stream_kernel<3, 3>(in, out, n, [&](const floatv* v, floatv* r) {
+                r[0] = maddv(m02, v[2], maddv(m01, v[1], m00 * v[0])) + m03;
+                r[1] = maddv(m12, v[2], maddv(m11, v[1], m10 * v[0])) + m13;
+                r[2] = maddv(m22, v[2], maddv(m21, v[1], m20 * v[0])) + m23;
+            });
+        }
+
+        // Same as transform3_soa but for an array of vec3, goes through small SoA blocks that stay in cache.
+        inline void transform3_aos(const float* m, bool point, const vec3* in, vec3* out, size_t n) noexcept {
+            float x[batch_block], y[batch_block], z[batch_block];
+            for (size_t i = 0; i < n; i += batch_block) {
+                size_t c = n - i < (size_t)batch_block ? n - i : (size_t)batch_block;
+                deinterleave3(&in[i].x, x, y, z, c);
+                transform3_soa(m, point, x, y, z, x, y, z, c);
+                interleave3(x, y, z, &out[i].x, c);
+            }
+        }
+
+        inline void transform4_aos(const float* m, const vec4* in, vec4* out, size_t n) noexcept {
+            const float* src = &in[0].x;
+            float* dst = &out[0].x;
+        #if LINA_SIMD == LINA_SIMD_SCALAR
+            for (size_t i = 0; i < n; i++) mat4_mul_vec4_scalar(m, src + i*4, dst + i*4);
+        #else
+            f128 c0, c1, c2, c3;
+        #if LINA_SIMD == LINA_SIMD_NEON
+            float32x4x4_t c = vld4q_f32(m);
+            c0 = c.val[0]; c1 = c.val[1]; c2 = c.val[2]; c3 = c.val[3];
+        #else
+            c0 = _mm_loadu_ps(m); c1 = _mm_loadu_ps(m + 4); c2 = _mm_loadu_ps(m + 8); c3 = _mm_loadu_ps(m + 12);
+            transpose4(c0, c1, c2, c3);
+        #endif
+            size_t i = 0;
+        #if LINA_SIMD_X86 && LINA_SIMD >= LINA_SIMD_AVX
+            // two vectors per instruction, every column is in both halves.
+            __m256 w0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+            __m256 w1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+            __m256 w2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+            __m256 w3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+            for (; i + 2 <= n; i += 2) {
+                __m256 v = _mm256_loadu_ps(src + i*4);
+                __m256 t = _mm256_mul_ps(w0, _mm256_shuffle_ps(v, v, 0x00));
+            #if LINA_SIMD_FMA
+                t = _mm256_fmadd_ps(w1, _mm256_shuffle_ps(v, v, 0x55), t);
+                t = _mm256_fmadd_ps(w2, _mm256_shuffle_ps(v, v, 0xAA), t);
+                t = _mm256_fmadd_ps(w3, _mm256_shuffle_ps(v, v, 0xFF), t);
+            #else
+                t = _mm256_add_ps(_mm256_mul_ps(w1, _mm256_shuffle_ps(v, v, 0x55)), t);
+                t = _mm256_add_ps(_mm256_mul_ps(w2, _mm256_shuffle_ps(v, v, 0xAA)), t);
+                t = _mm256_add_ps(_mm256_mul_ps(w3, _mm256_shuffle_ps(v, v, 0xFF)), t);
+            #endif
+                _mm256_storeu_ps(dst + i*4, t);
+            }
+        #endif
+            for (; i < n; i++) {
+            #if LINA_SIMD == LINA_SIMD_NEON
+                f128 v = vld1q_f32(src + i*4);
+                f128 t = vmulq_f32(c0, splat<0>(v));
+            #else
+                f128 v = _mm_loadu_ps(src + i*4);
+                f128 t = _mm_mul_ps(c0, splat<0>(v));
+            #endif
+                t = madd(c1, splat<1>(v), t);
+                t = madd(c2, splat<2>(v), t);
+                t = madd(c3, splat<3>(v), t);
+            #if LINA_SIMD == LINA_SIMD_NEON
+                vst1q_f32(dst + i*4, t);
+            #else
+                _mm_storeu_ps(dst + i*4, t);
+            #endif
+            }
+        #endif
+        }
+    }
+
+    // Sets how many threads the batch functions can use, 0 means one per hardware thread.
+    inline void setBatchThreadCount(unsigned threads) {
+        detail::batchSettings().threads = threads;
+        detail::default_scheduler().setThreadCount(threads);
+    }
+    inline unsigned batchThreadCount() noexcept {
+        unsigned t = detail::batchSettings().threads;
+        return t ? t : detail::hardware_threads();
+    }
+
+    // Sets the smallest number of vectors a thread gets, batches under twice this stay on the calling thread.
+    inline void setBatchThreshold(size_t threshold) noexcept {
+        detail::batchSettings().threshold = threshold;
+    }
+    inline size_t batchThreshold() noexcept {
+        return detail::batchSettings().threshold;
+    }
+
+    // out[i] = m * vec4(in[i], 1)
+    inline void transformPoints(const mat4& m, span<const vec3> in, span<vec3> out) {
+        const float* mp = m.data();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_aos(mp, true, in.data() + b, out.data() + b, e - b);
+        });
+    }
+    inline void transformPoints(const mat4& m, span<vec3> points) {
+        transformPoints(m, span<const vec3>(points.data(), points.size()), points);
+    }
+
+    // out[i] = m * in[i]
+    inline void transformPoints(const mat4& m, span<const vec4> in, span<vec4> out) {
+        const float* mp = m.data();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform4_aos(mp, in.data() + b, out.data() + b, e - b);
+        });
+    }
+    inline void transformPoints(const mat4& m, span<vec4> points) {
+        transformPoints(m, span<const vec4>(points.data(), points.size()), points);
+    }
+
+    // out[i] = m * vec4(in[i], 0)
+    inline void transformDirections(const mat4& m, span<const vec3> in, span<vec3> out) {
+        const float* mp = m.data();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_aos(mp, false, in.data() + b, out.data() + b, e - b);
+        });
+    }
+    inline void transformDirections(const mat4& m, span<vec3> directions) {
+        transformDirections(m, span<const vec3>(directions.data(), directions.size()), directions);
+    }
+
+    // Stream versions, `out` is resized to the size of `in`.
+    inline void transformPoints(const mat4& m, const Vec3Stream& in, Vec3Stream& out) {
+        out.resize(in.size());
+        const float* mp = m.data();
+        const float *x = in.x(), *y = in.y(), *z = in.z();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_soa(mp, true, x + b, y + b, z + b, ox + b, oy + b, oz + b, e - b);
+        });
+    }
+    inline void transformPoints(const mat4& m, Vec3Stream& points) {
+        transformPoints(m, points, points);
+    }
+
+    inline void transformDirections(const mat4& m, const Vec3Stream& in, Vec3Stream& out) {
+        out.resize(in.size());
+        const float* mp = m.data();
+        const float *x = in.x(), *y = in.y(), *z = in.z();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_soa(mp, false, x + b, y + b, z + b, ox + b, oy + b, oz + b, e - b);
+        });
+    }
+    inline void transformDirections(const mat4& m, Vec3Stream& directions) {
+        transformDirections(m, directions, directions);
+    }
+
+    inline void transformPoints(const mat4& m, const Vec4Stream& in, Vec4Stream& out) {
+        out.resize(in.size());
+        const float* mp = m.data();
+        const float *x = in.x(), *y = in.y(), *z = in.z(), *w = in.w();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z(), *ow = out.w();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::floatv mv[16];
+            for (int k = 0; k < 16; k++) mv[k] = detail::setv(mp[k]);
+            const float* src[4] = {x + b, y + b, z + b, w + b};
+            float* dst[4] = {ox + b, oy + b, oz + b, ow + b};
+            detail::stream_kernel<4, 4>(src, dst, e - b, [&](const detail::floatv* v, detail::floatv* r) {
+                for (int row = 0; row < 4; row++) {
+                    const detail::floatv* mr = mv + row*4;
+                    r[row] = detail::maddv(mr[3], v[3], detail::maddv(mr[2], v[2], detail::maddv(mr[1], v[1], mr[0] * v[0])));
+                }
+            });
+        });
+    }
+    inline void transformPoints(const mat4& m, Vec4Stream& points) {
+        transformPoints(m, points, points);
+    }
+
+    // affine3 versions, same as above without the bottom row (see 'Affine Matrices' in lina.hpp).
+    inline void transformPoints(const affine3& m, span<const vec3> in, span<vec3> out) {
+        const float* mp = m.data();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_aos(mp, true, in.data() + b, out.data() + b, e - b);
+        });
+    }
+    inline void transformPoints(const affine3& m, span<vec3> points) {
+        transformPoints(m, span<const vec3>(points.data(), points.size()), points);
+    }
+
+    inline void transformDirections(const affine3& m, span<const vec3> in, span<vec3> out) {
+        const float* mp = m.data();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_aos(mp, false, in.data() + b, out.data() + b, e - b);
+        });
+    }
+    inline void transformDirections(const affine3& m, span<vec3> directions) {
+        transformDirections(m, span<const vec3>(directions.data(), directions.size()), directions);
+    }
+
+    inline void transformPoints(const affine3& m, const Vec3Stream& in, Vec3Stream& out) {
+        out.resize(in.size());
+        const float* mp = m.data();
+        const float *x = in.x(), *y = in.y(), *z = in.z();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_soa(mp, true, x + b, y + b, z + b, ox + b, oy + b, oz + b, e - b);
+        });
+    }
+    inline void transformPoints(const affine3& m, Vec3Stream& points) {
+        transformPoints(m, points, points);
+    }
+
+    inline void transformDirections(const affine3& m, const Vec3Stream& in, Vec3Stream& out) {
+        out.resize(in.size());
+        const float* mp = m.data();
+        const float *x = in.x(), *y = in.y(), *z = in.z();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z();
+        detail::batch_for(in.size(), [=](size_t b, size_t e) {
+            detail::transform3_soa(mp, false, x + b, y + b, z + b, ox + b, oy + b, oz + b, e - b);
+        });
+    }
+    inline void transformDirections(const affine3& m, Vec3Stream& directions) {
+        transformDirections(m, directions, directions);
+    }
+}
+
+#endif /* LINA_BATCH_HPP */
@@ -0,0 +1,408 @@
+#ifndef LINA_BOUNDS_HPP
+#define LINA_BOUNDS_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_batch.hpp"
+#include "lina_task.hpp"
+#include <float.h>
+#include <math.h>
+
+/*
+
+###################
+      Bounds
+###################
+These reduce a whole point set (particles, skinned vertices, point clouds) to
+one value, from either an array of vec3 or a Vec3Stream:
+
+    boundingBox:    the smallest AABB around the points.
+    centroid:       the average of the points.
+    covariance:     the covariance matrix of the points, about their centroid
+                    (feed it to eigenSymmetric() in lina_solve.hpp to fit an
+                    oriented box).
+    boundingSphere: a sphere around the points, not the smallest one.
+
+    AABB box = boundingBox(span<const vec3>(positions));
+    BoundingSphere s = boundingSphere(positions_stream, box);
+
+They go through the points 4 or 8 at a time (see 'SIMD' in lina.hpp), in one
+pass (boundingSphere takes two, or one when you pass it the box). For no
+points boundingBox returns an empty box (min > max, see AABB::empty()), and
+the others return zeros.
+
+Infinities and NaNs in the points give meaningless results.
+
+================
+  Threading
+================
+Big point sets are cut into tasks that run on the task scheduler (see 'Tasks'
+in lina_task.hpp), and the results of the tasks are combined in order on the
+calling thread. The tasks only depend on the number of points and
+batchThreshold() (every task gets at least that many), so the results don't
+depend on the number of threads, they're the same down to the last bit on
+every run.
+
+centroid and covariance add up the points relative to the first one, in
+floats for every 256 points and in doubles after that, so they stay accurate
+for millions of points far away from the origin.
+
+================
+  Bounding Sphere
+================
+boundingSphere centers the sphere on the bounding box and makes it just big
+enough for the point that's furthest from that (and a few ulps more, so that
+every point is inside even with rounding). It's never more than sqrt(3) times
+the radius of the smallest sphere, and for the usual blobby point sets it's
+close to it. If you need the box too, compute it first and pass it in,
+that saves a pass over the points.
+
+*/
+
+namespace lina {
+    struct AABB {
+        vec3 min, max;
+
+        AABB() noexcept : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+        AABB(vec3 lo, vec3 hi) noexcept : min(lo), max(hi) {}
+
+        // True when there's nothing in it, like a box from no points.
+        bool empty() const noexcept { return min.x > max.x || min.y > max.y || min.z > max.z; }
+        vec3 center() const noexcept { return vec3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f); }
+        vec3 size() const noexcept { return vec3(max.x - min.x, max.y - min.y, max.z - min.z); }
+    };
+
+    struct BoundingSphere {
+        vec3 center;
+        float radius;
+    };
+
+    namespace detail {
+        // Every task gets at least batchThreshold() points, and whole blocks of them.
+        inline size_t bounds_grain(size_t n) noexcept {
+            size_t g = auto_grain(n), t = batchSettings().threshold;
+            if (g < t) g = t;
+            return (g + batch_block - 1) / batch_block * batch_block;
+        }
+
+        // Calls f(xyz, count) for every batch_block points of [begin, end), xyz are 3 component
+        // arrays. Arrays of vec3 go through a SoA copy that stays in cache.
+        template <typename F>
+        inline void point_blocks(const vec3* points, size_t begin, size_t end, F f) noexcept {
+            float x[batch_block], y[batch_block], z[batch_block];
+            const float* p[3] = {x, y, z};
+            for (size_t i = begin; i < end; i += batch_block) {
+                size_t c = end - i < (size_t)batch_block ? end - i : (size_t)batch_block;
+                deinterleave3(&points[i].x, x, y, z, c);
+                f(p, c);
+            }
+        }
+
+        template <typename F>
+        inline void point_blocks(const Vec3Stream& points, size_t begin, size_t end, F f) noexcept {
+            for (size_t i = begin; i < end; i += batch_block) {
+                size_t c = end - i < (size_t)batch_block ? end - i : (size_t)batch_block;
+                const float* p[3] = {points.x() + i, points.y() + i, points.z() + i};
+                f(p, c);
+            }
+        }
+
+        inline vec3 first_point(const vec3* points) noexcept { return points[0]; }
+        inline vec3 first_point(const Vec3Stream& points) noexcept { return vec3(points.x()[0], points.y()[0], points.z()[0]); }
+
+        // Calls f(acc, x, y, z) for the c points of a block, floatv_width at a time. The lanes after
+        // the last point get pad[0], pad[1] and pad[2].
+        template <typename A, typename F>
+        inline void point_lanes(const float* const* p, size_t c, const float* pad, A& acc, F f) noexcept {
+            // Everything in locals, so the accumulators stay in registers instead of going through
+            // memory after every point.
+            A a = acc;
+            const float *x = p[0], *y = p[1], *z = p[2];
+            size_t i = 0;
+            for (; i + floatv_width <= c; i += floatv_width) f(a, loadv(x + i), loadv(y + i), loadv(z + i));
+            if (i < c) {
+                float t[3][floatv_width];
+                for (size_t j = 0; j < (size_t)floatv_width; j++) {
+                    bool in = i + j < c;
+                    t[0][j] = in ? x[i + j] : pad[0];
+                    t[1][j] = in ? y[i + j] : pad[1];
+                    t[2][j] = in ? z[i + j] : pad[2];
+                }
+                f(a, loadv(t[0]), loadv(t[1]), loadv(t[2]));
+            }
+            acc = a;
+        }
+
+        inline float hmin(floatv v) noexcept {
+            float t[floatv_width];
+            storev(t, v);
+            float r = t[0];
+            for (int j = 1; j < floatv_width; j++) r = t[j] < r ? t[j] : r;
+            return r;
+        }
+
+        inline float hmax(floatv v) noexcept {
+            float t[floatv_width];
+            storev(t, v);
+            float r = t[0];
+            for (int j = 1; j < floatv_width; j++) r = t[j] > r ? t[j] : r;
+            return r;
+        }
+
+        inline double hsum(floatv v) noexcept {
+            float t[floatv_width];
+            storev(t, v);
+            double r = t[0];
+            for (int j = 1; j < floatv_width; j++) r += t[j];
+            return r;
+        }
+
+        struct box_lanes {
+            floatv lx, ly, lz, hx, hy, hz;
+        };
+
+        template <typename P>
+        inline AABB bounding_box(const P& points, size_t n) {
+            return parallel_reduce(n, AABB(), [&](size_t b, size_t e) {
+                floatv lo = setv(FLT_MAX), hi = setv(-FLT_MAX);
+                box_lanes acc = {lo, lo, lo, hi, hi, hi};
+                point_blocks(points, b, e, [&](const float* const* p, size_t c) {
+                    // Padding with a point that's in the block doesn't change anything.
+                    const float pad[3] = {p[0][0], p[1][0], p[2][0]};
+                    point_lanes(p, c, pad, acc, [](box_lanes& a, floatv x, floatv y, floatv z) {
+                        a.lx = minv(a.lx, x);
+                        a.ly = minv(a.ly, y);
+                        a.lz = minv(a.lz, z);
+                        a.hx = maxv(a.hx, x);
+                        a.hy = maxv(a.hy, y);
+                        a.hz = maxv(a.hz, z);
+                    });
+                });
+                return AABB(vec3(hmin(acc.lx), hmin(acc.ly), hmin(acc.lz)), vec3(hmax(acc.hx), hmax(acc.hy), hmax(acc.hz)));
+            }, [](const AABB& a, const AABB& b) {
+                return AABB(vec3(fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z)),
+                            vec3(fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z)));
+            }, bounds_grain(n));
+        }
+
+        // Arrays of vec3 don't need to be split into x, y and z for a box, they're read as one array
+        // of floats 3 floatv at a time. Float k of those 3 is always component k % 3.
+        inline AABB bounding_box(const vec3* points, size_t n) {
+            return parallel_reduce(n, AABB(), [=](size_t b, size_t e) {
+                const float* f = &points[b].x;
+                size_t floats = (e - b) * 3, i = 0;
+                floatv l0 = setv(FLT_MAX), l1 = l0, l2 = l0, h0 = setv(-FLT_MAX), h1 = h0, h2 = h0;
+                for (; i + 3 * floatv_width <= floats; i += 3 * floatv_width) {
+                    floatv v0 = loadv(f + i), v1 = loadv(f + i + floatv_width), v2 = loadv(f + i + 2 * floatv_width);
+                    l0 = minv(l0, v0);
+                    l1 = minv(l1, v1);
+                    l2 = minv(l2, v2);
+                    h0 = maxv(h0, v0);
+                    h1 = maxv(h1, v1);
+                    h2 = maxv(h2, v2);
+                }
+                float lo[3 * floatv_width], hi[3 * floatv_width];
+                storev(lo, l0);
+                storev(lo + floatv_width, l1);
+                storev(lo + 2 * floatv_width, l2);
+                storev(hi, h0);
+                storev(hi + floatv_width, h1);
+                storev(hi + 2 * floatv_width, h2);
+                float r[6] = {FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+                for (size_t k = 0; k < 3 * (size_t)floatv_width; k++) {
+                    r[k % 3] = fminf(r[k % 3], lo[k]);
+                    r[3 + k % 3] = fmaxf(r[3 + k % 3], hi[k]);
+                }
+                for (; i < floats; i++) {
+                    r[i % 3] = fminf(r[i % 3], f[i]);
+                    r[3 + i % 3] = fmaxf(r[3 + i % 3], f[i]);
+                }
+                return AABB(vec3(r[0], r[1], r[2]), vec3(r[3], r[4], r[5]));
+            }, [](const AABB& a, const AABB& b) {
+                return AABB(vec3(fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z)),
+                            vec3(fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z)));
+            }, bounds_grain(n));
+        }
+
+        // The sums of (p - origin) and of its products, xx, xy, xz, yy, yz, zz.
+        struct point_sums {
+            double s[3];
+            double m[6];
+        };
+
+        struct sum_lanes {
+            floatv ox, oy, oz;
+            floatv sx, sy, sz, xx, xy, xz, yy, yz, zz;
+        };
+
+        template <bool Products, typename P>
+        inline point_sums sum_points(const P& points, size_t n, vec3 origin) {
+            point_sums zero = {};
+            return parallel_reduce(n, zero, [&](size_t b, size_t e) {
+                point_sums r = {};
+                // Padding with the origin adds zeros.
+                const float pad[3] = {origin.x, origin.y, origin.z};
+                point_blocks(points, b, e, [&](const float* const* p, size_t c) {
+                    floatv z0 = setv(0.f);
+                    sum_lanes acc = {setv(origin.x), setv(origin.y), setv(origin.z), z0, z0, z0, z0, z0, z0, z0, z0, z0};
+                    point_lanes(p, c, pad, acc, [](sum_lanes& a, floatv x, floatv y, floatv z) {
+                        x = x - a.ox;
+                        y = y - a.oy;
+                        z = z - a.oz;
+                        a.sx = a.sx + x;
+                        a.sy = a.sy + y;
+                        a.sz = a.sz + z;
+                        if (Products) {
+                            a.xx = maddv(x, x, a.xx);
+                            a.xy = maddv(x, y, a.xy);
+                            a.xz = maddv(x, z, a.xz);
+                            a.yy = maddv(y, y, a.yy);
+                            a.yz = maddv(y, z, a.yz);
+                            a.zz = maddv(z, z, a.zz);
+                        }
+                    });
+                    r.s[0] += hsum(acc.sx);
+                    r.s[1] += hsum(acc.sy);
+                    r.s[2] += hsum(acc.sz);
+                    if (Products) {
+                        r.m[0] += hsum(acc.xx);
+                        r.m[1] += hsum(acc.xy);
+                        r.m[2] += hsum(acc.xz);
+                        r.m[3] += hsum(acc.yy);
+                        r.m[4] += hsum(acc.yz);
+                        r.m[5] += hsum(acc.zz);
+                    }
+                });
+                return r;
+            }, [](const point_sums& a, const point_sums& b) {
+                point_sums r;
+                for (int k = 0; k < 3; k++) r.s[k] = a.s[k] + b.s[k];
+                for (int k = 0; k < 6; k++) r.m[k] = a.m[k] + b.m[k];
+                return r;
+            }, bounds_grain(n));
+        }
+
+        // The plain sums of an array of vec3 read as floats, like bounding_box above. The floats are
+        // added up in blocks of batch_block points, which is a whole number of floatv triples.
+        inline point_sums sum_points(const vec3* points, size_t n, vec3 origin) {
+            point_sums zero = {};
+            return parallel_reduce(n, zero, [=](size_t b, size_t e) {
+                point_sums r = {};
+                const float o[3] = {origin.x, origin.y, origin.z};
+                float pattern[3 * floatv_width];
+                for (size_t k = 0; k < 3 * (size_t)floatv_width; k++) pattern[k] = o[k % 3];
+                const floatv o0 = loadv(pattern), o1 = loadv(pattern + floatv_width), o2 = loadv(pattern + 2 * floatv_width);
+                const float* f = &points[b].x;
+                size_t floats = (e - b) * 3, i = 0;
+                while (i + 3 * floatv_width <= floats) {
+                    size_t end = floats - i < 3 * (size_t)batch_block ? floats - (floats - i) % (3 * floatv_width) : i + 3 * batch_block;
+                    floatv s0 = setv(0.f), s1 = s0, s2 = s0;
+                    for (; i < end; i += 3 * floatv_width) {
+                        s0 = s0 + (loadv(f + i) - o0);
+                        s1 = s1 + (loadv(f + i + floatv_width) - o1);
+                        s2 = s2 + (loadv(f + i + 2 * floatv_width) - o2);
+                    }
+                    float t[3 * floatv_width];
+                    storev(t, s0);
+                    storev(t + floatv_width, s1);
+                    storev(t + 2 * floatv_width, s2);
+                    for (size_t k = 0; k < 3 * (size_t)floatv_width; k++) r.s[k % 3] += t[k];
+                }
+                for (; i < floats; i++) r.s[i % 3] += f[i] - o[i % 3];
+                return r;
+            }, [](const point_sums& a, const point_sums& b) {
+                point_sums r = {};
+                for (int k = 0; k < 3; k++) r.s[k] = a.s[k] + b.s[k];
+                return r;
+            }, bounds_grain(n));
+        }
+
+        inline vec3 centroid(const vec3* points, size_t n) {
+            if (!n) return vec3(0.f, 0.f, 0.f);
+            vec3 o = points[0];
+            point_sums r = sum_points(points, n, o);
+            return vec3((float)(o.x + r.s[0] / n), (float)(o.y + r.s[1] / n), (float)(o.z + r.s[2] / n));
+        }
+
+        template <typename P>
+        inline vec3 centroid(const P& points, size_t n) {
+            if (!n) return vec3(0.f, 0.f, 0.f);
+            vec3 o = first_point(points);
+            point_sums r = sum_points<false>(points, n, o);
+            return vec3((float)(o.x + r.s[0] / n), (float)(o.y + r.s[1] / n), (float)(o.z + r.s[2] / n));
+        }
+
+        template <typename P>
+        inline mat3 covariance(const P& points, size_t n) {
+            if (!n) return mat3(0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f);
+            point_sums r = sum_points<true>(points, n, first_point(points));
+            double mx = r.s[0] / n, my = r.s[1] / n, mz = r.s[2] / n;
+            float xx = (float)(r.m[0] / n - mx * mx), xy = (float)(r.m[1] / n - mx * my), xz = (float)(r.m[2] / n - mx * mz);
+            float yy = (float)(r.m[3] / n - my * my), yz = (float)(r.m[4] / n - my * mz), zz = (float)(r.m[5] / n - mz * mz);
+            return mat3(xx, xy, xz, xy, yy, yz, xz, yz, zz);
+        }
+
+        template <typename P>
+        inline BoundingSphere bounding_sphere(const P& points, size_t n, const AABB& box) {
+            if (!n) return BoundingSphere{vec3(0.f, 0.f, 0.f), 0.f};
+            vec3 c = box.center();
+            float d2 = parallel_reduce(n, 0.f, [&](size_t b, size_t e) {
+                // The center, and the largest squared distance to it.
+                floatv z0 = setv(0.f);
+                sum_lanes acc = {setv(c.x), setv(c.y), setv(c.z), z0, z0, z0, z0, z0, z0, z0, z0, z0};
+                // Padding with the center adds zeros.
+                const float pad[3] = {c.x, c.y, c.z};
+                point_blocks(points, b, e, [&](const float* const* p, size_t cnt) {
+                    point_lanes(p, cnt, pad, acc, [](sum_lanes& a, floatv x, floatv y, floatv z) {
+                        x = x - a.ox;
+                        y = y - a.oy;
+                        z = z - a.oz;
+                        a.sx = maxv(a.sx, maddv(z, z, maddv(y, y, x * x)));
+                    });
+                });
+                return hmax(acc.sx);
+            }, [](float a, float b) { return a > b ? a : b; }, bounds_grain(n));
+            return BoundingSphere{c, sqrtf(d2) * (1.f + 4.f * FLT_EPSILON)};
+        }
+    }
+
+    // The smallest AABB around all the points.
+    inline AABB boundingBox(span<const vec3> points) {
+        return detail::bounding_box(points.data(), points.size());
+    }
+    inline AABB boundingBox(const Vec3Stream& points) {
+        return detail::bounding_box(points, points.size());
+    }
+
+    // The average of all the points.
+    inline vec3 centroid(span<const vec3> points) {
+        return detail::centroid(points.data(), points.size());
+    }
+    inline vec3 centroid(const Vec3Stream& points) {
+        return detail::centroid(points, points.size());
+    }
+
+    // The covariance matrix of the points (divided by the number of points, not one less).
+    inline mat3 covariance(span<const vec3> points) {
+        return detail::covariance(points.data(), points.size());
+    }
+    inline mat3 covariance(const Vec3Stream& points) {
+        return detail::covariance(points, points.size());
+    }
+
+    // A sphere around all the points, see 'Bounding Sphere'. `box` has to be boundingBox(points).
+    inline BoundingSphere boundingSphere(span<const vec3> points, const AABB& box) {
+        return detail::bounding_sphere(points.data(), points.size(), box);
+    }
+    inline BoundingSphere boundingSphere(const Vec3Stream& points, const AABB& box) {
+        return detail::bounding_sphere(points, points.size(), box);
+    }
+    inline BoundingSphere boundingSphere(span<const vec3> points) {
+        return boundingSphere(points, boundingBox(points));
+    }
+    inline BoundingSphere boundingSphere(const Vec3Stream& points) {
+        return boundingSphere(points, boundingBox(points));
+    }
+}
+
+#endif /* LINA_BOUNDS_HPP */
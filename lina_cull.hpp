@@ -0,0 +1,232 @@
+#ifndef LINA_CULL_HPP
+#define LINA_CULL_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_batch.hpp"
+#include <stdint.h>
+
+/*
+
+###################
+  Frustum Culling
+###################
+A 'Frustum' is the 6 planes (left, right, bottom, top, near, far) that enclose
+everything a camera can see. With the camera builders pass the projection and
+the view separately, to Frustum::fromRM or Frustum::fromCM depending on which
+builders you used:
+    mat4 projection = CreateRMCameraPerspectiveMatrix(screen_size, fov, 0.1f, 100.f);
+    mat4 view = CreateRMCameraViewMatrix(position, right, up, forward);
+    Frustum f = Frustum::fromRM(projection, view);
+
+The perspective builders lay out their matrix transposed compared to the view
+builders (CreateRMCameraPerspectiveMatrix is made for v * m, the view for
+m * v), so 'projection * view' isn't the view-projection, the two matrix
+overloads take care of that.
+
+For a view-projection matrix you built some other way there's the single
+matrix version, the planes are pulled straight out of the matrix so it works
+for any projection:
+    Frustum f = Frustum::fromRM(view_proj);    // clip = view_proj * v
+By default the near plane is at a clip space depth of 0 (Direct3D, Vulkan,
+Metal, and the perspective builders), pass ClipDepth::MinusOneToOne for OpenGL
+style matrices.
+
+To test a single object use containsPoint, intersectsSphere and intersectsAABB.
+For a lot of objects use the batch functions below.
+
+================
+  Batch Culling
+================
+    cullSpheres: spheres as a Vec3Stream of centers and a FloatStream of radii,
+                 or as a Vec4Stream with the radius in w.
+    cullAABBs:   boxes as a Vec3Stream of min corners and one of max corners.
+
+They test 4 or 8 objects at a time (see 'SIMD' in lina.hpp) and write a
+visibility bitmask, bit (i % 32) of visible[i / 32] is set when object i is at
+least partly inside the frustum. 'visible' needs to hold at least
+cullMaskSize(n) words, the bits after the last object are cleared.
+
+The tests are conservative, an object is only culled when it's completely on
+the outside of one of the planes, so a big box or sphere near a corner of the
+frustum can be reported as visible even though it isn't.
+
+Big batches are split across threads just like the batch transforms (see
+'Threading' in lina_batch.hpp), every thread gets whole words of the mask.
+
+*/
+
+namespace lina {
+    enum class ClipDepth {
+        ZeroToOne,     // 0 <= z <= w in clip space (Direct3D, Vulkan, Metal).
+        MinusOneToOne  // -w <= z <= w in clip space (OpenGL).
+    };
+
+    struct Frustum {
+        enum { Left, Right, Bottom, Top, Near, Far };
+
+        // xyz is the unit normal of the plane, pointing inwards, w is the distance, so a point p
+        // is on the inside of a plane when p.x * x + p.y * y + p.z * z + w >= 0.
+        vec4 planes[6];
+
+        // Extracts the planes of a row-major view-projection matrix (clip = m * v).
+        inline static Frustum fromRM(const mat4& m, ClipDepth depth = ClipDepth::ZeroToOne) noexcept {
+            vec4 r0(m._00, m._01, m._02, m._03);
+            vec4 r1(m._10, m._11, m._12, m._13);
+            vec4 r2(m._20, m._21, m._22, m._23);
+            vec4 r3(m._30, m._31, m._32, m._33);
+            Frustum f;
+            f.planes[Left] = r3 + r0;
+            f.planes[Right] = r3 - r0;
+            f.planes[Bottom] = r3 + r1;
+            f.planes[Top] = r3 - r1;
+            f.planes[Near] = depth == ClipDepth::ZeroToOne ? r2 : r3 + r2;
+            f.planes[Far] = r3 - r2;
+            for (vec4& p : f.planes) {
+                float l = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+                p = vec4(p.x / l, p.y / l, p.z / l, p.w / l);
+            }
+            return f;
+        }
+
+        // Extracts the planes of a column-major view-projection matrix.
+        inline static Frustum fromCM(const mat4& m, ClipDepth depth = ClipDepth::ZeroToOne) noexcept {
+            return fromRM(m.transposed(), depth);
+        }
+
+        // From CreateRMCameraPerspectiveMatrix and CreateRMCameraViewMatrix, the projection is
+        // laid out for v * m, so the view-projection is projection^T * view.
+        inline static Frustum fromRM(const mat4& projection, const mat4& view, ClipDepth depth = ClipDepth::ZeroToOne) noexcept {
+            return fromRM(projection.transposed() * view, depth);
+        }
+
+        // From CreateCMCameraPerspectiveMatrix and CreateCMCameraViewMatrix, where it's the view
+        // that's transposed.
+        inline static Frustum fromCM(const mat4& projection, const mat4& view, ClipDepth depth = ClipDepth::ZeroToOne) noexcept {
+            return fromRM(projection * view.transposed(), depth);
+        }
+
+        inline float distance(int plane, vec3 p) const noexcept {
+            return planes[plane].x * p.x + planes[plane].y * p.y + planes[plane].z * p.z + planes[plane].w;
+        }
+
+        inline bool containsPoint(vec3 p) const noexcept {
+            for (int i = 0; i < 6; i++)
+                if (distance(i, p) < 0.f) return false;
+            return true;
+        }
+
+        inline bool intersectsSphere(vec3 center, float radius) const noexcept {
+            for (int i = 0; i < 6; i++)
+                if (distance(i, center) < -radius) return false;
+            return true;
+        }
+
+        // Only tests the corner of the box that's furthest along each plane's normal.
+        inline bool intersectsAABB(vec3 min, vec3 max) const noexcept {
+            for (int i = 0; i < 6; i++) {
+                vec3 p(planes[i].x >= 0.f ? max.x : min.x, planes[i].y >= 0.f ? max.y : min.y, planes[i].z >= 0.f ? max.z : min.z);
+                if (distance(i, p) < 0.f) return false;
+            }
+            return true;
+        }
+    };
+
+    // The number of 32 bit words a visibility mask for `n` objects needs.
+    inline constexpr size_t cullMaskSize(size_t n) noexcept {
+        return (n + 31) / 32;
+    }
+
+    namespace detail {
+        // Runs `f` over [begin, end) of NI input arrays floatv_width elements at a time, `f` returns
+        // one bit per lane that gets written into the mask. `begin` has to be a multiple of 32.
+        // The elements that don't fill a whole floatv go through a zero padded copy.
+        template <int NI, typename F>
+        inline void cull_kernel(const float* const* in, uint32_t* mask, size_t begin, size_t end, F f) noexcept {
+            for (size_t w0 = begin; w0 < end; w0 += 32) {
+                size_t we = end - w0 < 32 ? end : w0 + 32;
+                uint32_t word = 0;
+                size_t i = w0;
+                for (; i + floatv_width <= we; i += floatv_width) {
+                    floatv a[NI];
+                    for (int k = 0; k < NI; k++) a[k] = loadv(in[k] + i);
+                    word |= (uint32_t)f(a) << (i - w0);
+                }
+                if (i < we) {
+                    size_t left = we - i;
+                    float tmp[NI][floatv_width] = {};
+                    floatv a[NI];
+                    for (int k = 0; k < NI; k++) {
+                        for (size_t j = 0; j < left; j++) tmp[k][j] = in[k][i + j];
+                        a[k] = loadv(tmp[k]);
+                    }
+                    word |= ((uint32_t)f(a) & ((1u << left) - 1u)) << (i - w0);
+                }
+                mask[w0 / 32] = word;
+            }
+        }
+
+        struct cull_planes {
+            floatv x[6], y[6], z[6], w[6];
+
+            explicit cull_planes(const Frustum& f) noexcept {
+                for (int i = 0; i < 6; i++) {
+                    x[i] = setv(f.planes[i].x);
+                    y[i] = setv(f.planes[i].y);
+                    z[i] = setv(f.planes[i].z);
+                    w[i] = setv(f.planes[i].w);
+                }
+            }
+        };
+
+        inline void cull_spheres(const Frustum& f, const float* x, const float* y, const float* z, const float* r,
+                                 uint32_t* mask, size_t n) {
+            const float* in[4] = {x, y, z, r};
+            batch_for(n, [=](size_t b, size_t e) {
+                cull_planes p(f);
+                cull_kernel<4>(in, mask, b, e, [&](const floatv* v) {
+                    // The smallest signed distance of the sphere's surface to any of the planes.
+                    floatv d = maddv(p.z[0], v[2], maddv(p.y[0], v[1], maddv(p.x[0], v[0], p.w[0] + v[3])));
+                    for (int i = 1; i < 6; i++)
+                        d = minv(d, maddv(p.z[i], v[2], maddv(p.y[i], v[1], maddv(p.x[i], v[0], p.w[i] + v[3]))));
+                    return gemaskv(d, setv(0.f));
+                });
+            }, 32);
+        }
+    }
+
+    // Sets bit i of `visible` when sphere i (centers[i], radii[i]) is at least partly inside `f`.
+    inline void cullSpheres(const Frustum& f, const Vec3Stream& centers, const FloatStream& radii, span<uint32_t> visible) {
+        detail::cull_spheres(f, centers.x(), centers.y(), centers.z(), radii.x(), visible.data(), centers.size());
+    }
+
+    // Same as above with the radius of every sphere in w.
+    inline void cullSpheres(const Frustum& f, const Vec4Stream& spheres, span<uint32_t> visible) {
+        detail::cull_spheres(f, spheres.x(), spheres.y(), spheres.z(), spheres.w(), visible.data(), spheres.size());
+    }
+
+    // Sets bit i of `visible` when the box from mins[i] to maxs[i] is at least partly inside `f`.
+    inline void cullAABBs(const Frustum& f, const Vec3Stream& mins, const Vec3Stream& maxs, span<uint32_t> visible) {
+        const float* in[6] = {mins.x(), mins.y(), mins.z(), maxs.x(), maxs.y(), maxs.z()};
+        uint32_t* mask = visible.data();
+        detail::batch_for(mins.size(), [=](size_t b, size_t e) {
+            detail::cull_planes p(f);
+            // Which corner is furthest along each plane's normal only depends on the plane,
+            // so it's picked once here instead of per box.
+            int sx[6], sy[6], sz[6];
+            for (int i = 0; i < 6; i++) {
+                sx[i] = f.planes[i].x >= 0.f ? 3 : 0;
+                sy[i] = f.planes[i].y >= 0.f ? 4 : 1;
+                sz[i] = f.planes[i].z >= 0.f ? 5 : 2;
+            }
+            detail::cull_kernel<6>(in, mask, b, e, [&](const detail::floatv* v) {
+                detail::floatv d = detail::maddv(p.z[0], v[sz[0]], detail::maddv(p.y[0], v[sy[0]], detail::maddv(p.x[0], v[sx[0]], p.w[0])));
+                for (int i = 1; i < 6; i++)
+                    d = detail::minv(d, detail::maddv(p.z[i], v[sz[i]], detail::maddv(p.y[i], v[sy[i]], detail::maddv(p.x[i], v[sx[i]], p.w[i]))));
+                return detail::gemaskv(d, detail::setv(0.f));
+            });
+        }, 32);
+    }
+}
+
+#endif /* LINA_CULL_HPP */
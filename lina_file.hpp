@@ -0,0 +1,507 @@
+#ifndef LINA_FILE_HPP
+#define LINA_FILE_HPP
+
+#include "lina.hpp"
+#include "lina_batch.hpp"
+#include "lina_pack.hpp"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/*
+
+###################
+   Binary Tables
+###################
+A binary file format for big arrays of vectors and matrices (baked animation
+poses, the instance transforms of a level, collision rects), and a reader that
+maps the file into memory and hands out spans that point straight into it.
+Opening a file only reads and checks the header, so it takes the same time
+for 2 million instances as it does for 10. The pages get loaded by the OS the
+first time they're touched.
+
+Writing one, the arrays aren't copied so they have to stay alive until write():
+    TableWriter w;
+    w.add("instances", instance_matrices);          // std::vector<mat4>
+    w.add("colliders", collision_rects);            // std::vector<Rect<float>>
+    w.add("positions", positions, TableEncoding::Half);
+    if (w.write("level.lt") != TableError::None) ...
+
+And reading it back:
+    TableFile f;
+    if (f.open("level.lt") != TableError::None) ...
+    span<const mat4> instances = f.table<mat4>("instances");
+    span<const half3> positions = f.table<half3>("positions");
+
+table<T>() returns an empty span if there's no table with that name or if it
+holds a different type. The spans are valid until the TableFile is closed or
+destroyed, and they're read only (the file is mapped read only too).
+
+These are the types a table can hold:
+    float, vec2, vec3, vec4, quat, mat3, mat4, Rect<float>, Rect<int>
+
+================
+  Half Tables
+================
+TableEncoding::Half stores every float as an IEEE half (see lina_pack.hpp),
+which halves the file size for things that don't need the precision, like
+positions in a small level or baked poses. Rect<int> can't be stored that way.
+A half vec3/vec4 table can be read without a copy as half3/half4, everything
+else has to be converted with read():
+    std::vector<mat4> poses(f.info(f.find("poses")).count);
+    f.read("poses", span<mat4>(poses));
+
+read() works for every table, it just copies the ones that are stored as
+floats. Big tables are converted on multiple threads (see 'Threading' in
+lina_batch.hpp).
+
+================
+  Layout
+================
+Everything is stored the way it is in memory: a 64 byte header, a directory
+with one 64 byte entry per table, then the tables, each starting on a 64 byte
+boundary. Matrices are row major (see 'Matrices' in lina.hpp). The header
+records the byte order, the bit pattern of 1.0f and the size of every element,
+and open() refuses files that don't match the machine that reads them, it
+doesn't try to convert them. A file from a newer version of the format gives
+TableError::NewerVersion.
+
+openMemory() reads a file that's already in memory (embedded in the
+executable, or loaded some other way), it has to start on a 64 byte boundary
+and has to stay alive while the TableFile uses it.
+
+*/
+
+namespace lina {
+    // The numbers are stored in the files, don't change them.
+    enum class TableType : uint32_t { Float = 1, Vec2 = 2, Vec3 = 3, Vec4 = 4, Quat = 5, Mat3 = 6, Mat4 = 7, RectF = 8, RectI = 9 };
+    enum class TableEncoding : uint32_t { Raw = 0, Half = 1 };
+
+    enum class TableError {
+        None,
+        OpenFailed,           // the file doesn't exist or can't be read / mapped
+        WriteFailed,
+        NotATableFile,        // wrong magic number or too small for the header
+        NewerVersion,
+        WrongByteOrder,
+        WrongFloatFormat,
+        Corrupt,              // a table or the directory is outside of the file, or misaligned
+        Misaligned,           // openMemory() with memory that isn't on a 64 byte boundary
+        NameTooLong,          // table names are 31 characters at most
+        DuplicateName,
+        UnsupportedEncoding,  // Half for a table of ints
+        NotFound,
+        WrongType,
+        OutputTooSmall,
+    };
+
+    inline const char* tableErrorString(TableError e) noexcept {
+        switch (e) {
+            case TableError::None: return "no error";
+            case TableError::OpenFailed: return "can't open the file";
+            case TableError::WriteFailed: return "can't write the file";
+            case TableError::NotATableFile: return "not a table file";
+            case TableError::NewerVersion: return "the file is from a newer version of the format";
+            case TableError::WrongByteOrder: return "the file was written on a machine with a different byte order";
+            case TableError::WrongFloatFormat: return "the file was written on a machine with a different float format";
+            case TableError::Corrupt: return "the file is corrupt";
+            case TableError::Misaligned: return "the memory isn't on a 64 byte boundary";
+            case TableError::NameTooLong: return "the table name is too long";
+            case TableError::DuplicateName: return "there already is a table with that name";
+            case TableError::UnsupportedEncoding: return "the table type can't be stored with that encoding";
+            case TableError::NotFound: return "there's no table with that name";
+            case TableError::WrongType: return "the table holds a different type";
+            case TableError::OutputTooSmall: return "the output is smaller than the table";
+        }
+        return "unknown error";
+    }
+
+    struct TableInfo {
+        const char* name;
+        TableType type;
+        TableEncoding encoding;
+        size_t count;
+    };
+
+    namespace detail {
+        enum { table_version = 1, table_alignment = 64, table_name_size = 32 };
+        static const char table_magic[8] = {'L', 'I', 'N', 'A', 'T', 'B', 'L', 0};
+
+        struct table_header {
+            char magic[8];
+            uint32_t byte_order;  // 0x01020304 as written by the machine that wrote it
+            uint32_t version;
+            uint32_t float_one;   // the bits of 1.0f
+            uint32_t table_count;
+            uint64_t file_size;
+            uint32_t reserved[8];
+        };
+
+        struct table_entry {
+            char name[table_name_size];
+            uint32_t type;
+            uint32_t encoding;
+            uint32_t element_size;  // the size of one element in the file
+            uint32_t reserved;
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        static_assert(sizeof(table_header) == 64 && sizeof(table_entry) == 64, "table headers can't have padding");
+
+        // What a table of T holds, and how it's stored. `components` is the number of floats
+        // (or ints) in one element.
+        template <typename T> struct table_traits;
+        template <TableType Ty, int N, bool Float, TableEncoding E = TableEncoding::Raw>
+        struct table_traits_base {
+            static constexpr TableType type = Ty;
+            static constexpr TableEncoding encoding = E;
+            static constexpr int components = N;
+            static constexpr bool floats = Float;
+        };
+        template <> struct table_traits<float> : table_traits_base<TableType::Float, 1, true> {};
+        template <> struct table_traits<vec2> : table_traits_base<TableType::Vec2, 2, true> {};
+        template <> struct table_traits<vec3> : table_traits_base<TableType::Vec3, 3, true> {};
+        template <> struct table_traits<vec4> : table_traits_base<TableType::Vec4, 4, true> {};
+        template <> struct table_traits<quat> : table_traits_base<TableType::Quat, 4, true> {};
+        template <> struct table_traits<mat3> : table_traits_base<TableType::Mat3, 9, true> {};
+        template <> struct table_traits<mat4> : table_traits_base<TableType::Mat4, 16, true> {};
+        template <> struct table_traits<Rect<float>> : table_traits_base<TableType::RectF, 4, true> {};
+        template <> struct table_traits<Rect<int>> : table_traits_base<TableType::RectI, 4, false> {};
+        // The packed types are the half encoding of a table, so they can be read without a copy.
+        template <> struct table_traits<half3> : table_traits_base<TableType::Vec3, 3, true, TableEncoding::Half> {};
+        template <> struct table_traits<half4> : table_traits_base<TableType::Vec4, 4, true, TableEncoding::Half> {};
+
+        template <typename T>
+        inline constexpr uint32_t table_element_size() {
+            return table_traits<T>::encoding == TableEncoding::Half ? table_traits<T>::components * 2 : table_traits<T>::components * 4;
+        }
+
+        inline uint32_t table_float_one() noexcept {
+            float f = 1.f;
+            uint32_t u;
+            memcpy(&u, &f, 4);
+            return u;
+        }
+
+        inline uint64_t table_align(uint64_t n) noexcept { return (n + table_alignment - 1) & ~(uint64_t)(table_alignment - 1); }
+    }
+
+    // Collects the tables and writes them to a file in one go.
+    struct TableWriter {
+        // Adds a table with the contents of `data` (a std::vector, span, ...). Nothing is copied,
+        // the data has to stay alive until write().
+        template <typename C>
+        TableError add(const char* name, const C& data, TableEncoding encoding = TableEncoding::Raw) {
+            typedef typename std::remove_cv<typename std::remove_pointer<decltype(data.data())>::type>::type T;
+            typedef detail::table_traits<T> traits;
+            static_assert(traits::encoding == TableEncoding::Raw, "add the unpacked type, and pass TableEncoding::Half");
+            static_assert(sizeof(T) == traits::components * 4, "table elements can't have padding");
+            if (strlen(name) >= detail::table_name_size) return TableError::NameTooLong;
+            for (const pending& p : tables)
+                if (p.name == name) return TableError::DuplicateName;
+            if (encoding == TableEncoding::Half && !traits::floats) return TableError::UnsupportedEncoding;
+            pending p = {name, traits::type, encoding, traits::components, (const void*)data.data(), (size_t)data.size()};
+            tables.push_back(p);
+            return TableError::None;
+        }
+
+        // The size of the file write() would write.
+        uint64_t fileSize() const noexcept {
+            uint64_t size = detail::table_align(sizeof(detail::table_header) + tables.size() * sizeof(detail::table_entry));
+            for (const pending& p : tables) size = detail::table_align(size + p.count * elementSize(p));
+            return size;
+        }
+
+        TableError write(const char* path) const {
+            FILE* f = fopen(path, "wb");
+            if (!f) return TableError::OpenFailed;
+            bool ok = writeTo(f);
+            ok = fclose(f) == 0 && ok;
+            if (!ok) remove(path);
+            return ok ? TableError::None : TableError::WriteFailed;
+        }
+
+        void clear() noexcept { tables.clear(); }
+
+    private:
+        struct pending {
+            std::string name;
+            TableType type;
+            TableEncoding encoding;
+            uint32_t components;
+            const void* data;
+            size_t count;
+        };
+        std::vector<pending> tables;
+
+        static uint32_t elementSize(const pending& p) noexcept { return p.components * (p.encoding == TableEncoding::Half ? 2 : 4); }
+
+        static bool pad(FILE* f, uint64_t& at, uint64_t to) {
+            static const char zeros[detail::table_alignment] = {};
+            size_t n = (size_t)(to - at);
+            at = to;
+            return n == 0 || fwrite(zeros, 1, n, f) == n;
+        }
+
+        bool writeTo(FILE* f) const {
+            detail::table_header h;
+            memset(&h, 0, sizeof(h));
+            memcpy(h.magic, detail::table_magic, sizeof(h.magic));
+            h.byte_order = 0x01020304u;
+            h.version = detail::table_version;
+            h.float_one = detail::table_float_one();
+            h.table_count = (uint32_t)tables.size();
+            h.file_size = fileSize();
+            if (fwrite(&h, sizeof(h), 1, f) != 1) return false;
+
+            uint64_t offset = detail::table_align(sizeof(h) + tables.size() * sizeof(detail::table_entry));
+            for (const pending& p : tables) {
+                detail::table_entry e;
+                memset(&e, 0, sizeof(e));
+                memcpy(e.name, p.name.c_str(), p.name.size());
+                e.type = (uint32_t)p.type;
+                e.encoding = (uint32_t)p.encoding;
+                e.element_size = elementSize(p);
+                e.offset = offset;
+                e.count = p.count;
+                if (fwrite(&e, sizeof(e), 1, f) != 1) return false;
+                offset = detail::table_align(offset + p.count * e.element_size);
+            }
+
+            uint64_t at = sizeof(h) + tables.size() * sizeof(detail::table_entry);
+            for (const pending& p : tables) {
+                if (!pad(f, at, detail::table_align(at))) return false;
+                size_t floats = p.count * p.components;
+                if (p.encoding == TableEncoding::Raw) {
+                    if (floats && fwrite(p.data, 4, floats, f) != floats) return false;
+                } else {
+                    // Converted in blocks so the halves never need a copy of the whole table.
+                    uint16_t halves[4096];
+                    const float* in = (const float*)p.data;
+                    for (size_t i = 0; i < floats; i += 4096) {
+                        size_t n = floats - i < 4096 ? floats - i : 4096;
+                        detail::floats_to_halves(in + i, halves, n);
+                        if (fwrite(halves, 2, n, f) != n) return false;
+                    }
+                }
+                at += (uint64_t)floats * (p.encoding == TableEncoding::Half ? 2 : 4);
+            }
+            return pad(f, at, detail::table_align(at));
+        }
+    };
+
+    // A table file mapped into memory (or one that's already in memory, see openMemory()).
+    struct TableFile {
+        TableFile() noexcept : base(nullptr), size(0), mapped(false) {}
+        ~TableFile() { close(); }
+        TableFile(const TableFile&) = delete;
+        TableFile& operator=(const TableFile&) = delete;
+        TableFile(TableFile&& o) noexcept : base(o.base), size(o.size), mapped(o.mapped) {
+            o.base = nullptr;
+            o.size = 0;
+            o.mapped = false;
+        }
+        TableFile& operator=(TableFile&& o) noexcept {
+            if (this != &o) {
+                close();
+                base = o.base;
+                size = o.size;
+                mapped = o.mapped;
+                o.base = nullptr;
+                o.size = 0;
+                o.mapped = false;
+            }
+            return *this;
+        }
+
+        // Maps the file and checks the header and the directory, the tables themselves aren't read.
+        TableError open(const char* path) {
+            close();
+            const char* p = nullptr;
+            size_t n = 0;
+        #ifdef _WIN32
+            HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return TableError::OpenFailed;
+            LARGE_INTEGER file_size;
+            HANDLE mapping = nullptr;
+            if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= (LONGLONG)sizeof(detail::table_header) &&
+                (uint64_t)file_size.QuadPart <= (size_t)-1) {
+                n = (size_t)file_size.QuadPart;
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            }
+            if (mapping) {
+                p = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            if (!p) return n ? TableError::OpenFailed : TableError::NotATableFile;
+        #else
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0) return TableError::OpenFailed;
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                return TableError::OpenFailed;
+            }
+            if (st.st_size < (off_t)sizeof(detail::table_header) || (uint64_t)st.st_size > (size_t)-1) {
+                ::close(fd);
+                return TableError::NotATableFile;
+            }
+            n = (size_t)st.st_size;
+            void* m = mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);  // the mapping keeps the file open
+            if (m == MAP_FAILED) return TableError::OpenFailed;
+            p = (const char*)m;
+        #endif
+            base = p;
+            size = n;
+            mapped = true;
+            TableError e = validate();
+            if (e != TableError::None) close();
+            return e;
+        }
+
+        // Uses a file that's already in memory, `data` has to start on a 64 byte boundary and
+        // stay alive until close().
+        TableError openMemory(const void* data, size_t bytes) {
+            close();
+            if ((uintptr_t)data % detail::table_alignment) return TableError::Misaligned;
+            base = (const char*)data;
+            size = bytes;
+            TableError e = validate();
+            if (e != TableError::None) close();
+            return e;
+        }
+
+        void close() noexcept {
+            if (mapped) {
+            #ifdef _WIN32
+                UnmapViewOfFile(base);
+            #else
+                munmap((void*)base, size);
+            #endif
+            }
+            base = nullptr;
+            size = 0;
+            mapped = false;
+        }
+
+        bool isOpen() const noexcept { return base != nullptr; }
+        size_t tableCount() const noexcept { return base ? header()->table_count : 0; }
+
+        TableInfo info(size_t i) const noexcept {
+            const detail::table_entry& e = entries()[i];
+            TableInfo t = {e.name, (TableType)e.type, (TableEncoding)e.encoding, (size_t)e.count};
+            return t;
+        }
+
+        // The index of the table called `name`, or -1.
+        ptrdiff_t find(const char* name) const noexcept {
+            for (size_t i = 0; i < tableCount(); i++)
+                if (strcmp(entries()[i].name, name) == 0) return (ptrdiff_t)i;
+            return -1;
+        }
+
+        // The table called `name` without a copy, or an empty span if it doesn't exist or holds
+        // something else. Ask for half3/half4 to read a half vec3/vec4 table.
+        template <typename T>
+        span<const T> table(const char* name) const noexcept {
+            typedef detail::table_traits<T> traits;
+            const detail::table_entry* e = entry(name);
+            if (!e || e->type != (uint32_t)traits::type || e->encoding != (uint32_t)traits::encoding || e->element_size != sizeof(T))
+                return span<const T>();
+            return span<const T>((const T*)(base + e->offset), (size_t)e->count);
+        }
+
+        // Copies the table called `name` into `out` (which has to be at least as big as the
+        // table), converting halves back to floats.
+        template <typename T>
+        TableError read(const char* name, span<T> out) const {
+            typedef detail::table_traits<T> traits;
+            static_assert(traits::encoding == TableEncoding::Raw, "read into the unpacked type");
+            const detail::table_entry* e = entry(name);
+            if (!e) return TableError::NotFound;
+            if (e->type != (uint32_t)traits::type) return TableError::WrongType;
+            size_t count = (size_t)e->count;
+            if (out.size() < count) return TableError::OutputTooSmall;
+            const char* src = base + e->offset;
+            if (e->encoding == (uint32_t)TableEncoding::Raw) {
+                const T* in = (const T*)src;
+                T* o = out.data();
+                detail::batch_for(count, [=](size_t b, size_t end) { memcpy((void*)(o + b), in + b, (end - b) * sizeof(T)); });
+            } else {
+                const uint16_t* in = (const uint16_t*)src;
+                float* o = (float*)out.data();
+                detail::batch_for(count, [=](size_t b, size_t end) {
+                    detail::halves_to_floats(in + b * traits::components, o + b * traits::components, (end - b) * traits::components);
+                });
+            }
+            return TableError::None;
+        }
+
+    private:
+        const char* base;
+        size_t size;
+        bool mapped;
+
+        const detail::table_header* header() const noexcept { return (const detail::table_header*)base; }
+        const detail::table_entry* entries() const noexcept { return (const detail::table_entry*)(base + sizeof(detail::table_header)); }
+
+        const detail::table_entry* entry(const char* name) const noexcept {
+            ptrdiff_t i = find(name);
+            return i < 0 ? nullptr : entries() + i;
+        }
+
+        TableError validate() const noexcept {
+            if (size < sizeof(detail::table_header)) return TableError::NotATableFile;
+            const detail::table_header* h = header();
+            if (memcmp(h->magic, detail::table_magic, sizeof(h->magic)) != 0) return TableError::NotATableFile;
+            if (h->byte_order != 0x01020304u) return TableError::WrongByteOrder;
+            if (h->version > detail::table_version) return TableError::NewerVersion;
+            if (h->float_one != detail::table_float_one()) return TableError::WrongFloatFormat;
+            if (h->file_size != size) return TableError::Corrupt;
+            if (h->table_count > (size - sizeof(detail::table_header)) / sizeof(detail::table_entry)) return TableError::Corrupt;
+
+            // Where the first table can start, right after the directory.
+            uint64_t data = detail::table_align(sizeof(detail::table_header) + (uint64_t)h->table_count * sizeof(detail::table_entry));
+            const detail::table_entry* e = entries();
+            for (uint32_t i = 0; i < h->table_count; i++) {
+                const detail::table_entry& t = e[i];
+                if (memchr(t.name, 0, sizeof(t.name)) == nullptr) return TableError::Corrupt;
+                if (t.type < (uint32_t)TableType::Float || t.type > (uint32_t)TableType::RectI) return TableError::Corrupt;
+                if (t.encoding > (uint32_t)TableEncoding::Half) return TableError::Corrupt;
+                // elementSize() is 0 for the combinations that don't exist (RectI in halves).
+                if (t.element_size == 0 || t.element_size != elementSize((TableType)t.type, (TableEncoding)t.encoding)) return TableError::Corrupt;
+                if (t.offset % detail::table_alignment || t.offset < data || t.offset > size) return TableError::Corrupt;
+                if (t.count > (size - t.offset) / t.element_size) return TableError::Corrupt;
+            }
+            return TableError::None;
+        }
+
+        static uint32_t elementSize(TableType t, TableEncoding e) noexcept {
+            static const uint32_t components[] = {0, 1, 2, 3, 4, 4, 9, 16, 4, 4};
+            if (t == TableType::RectI && e == TableEncoding::Half) return 0;
+            return components[(uint32_t)t] * (e == TableEncoding::Half ? 2 : 4);
+        }
+    };
+}
+
+#endif /* LINA_FILE_HPP */
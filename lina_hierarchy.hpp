@@ -0,0 +1,237 @@
+#ifndef LINA_HIERARCHY_HPP
+#define LINA_HIERARCHY_HPP
+
+#include "lina.hpp"
+#include "lina_batch.hpp"
+#include "lina_alloc.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+/*
+
+###################
+ Transform Hierarchy
+###################
+A 'TransformHierarchy' holds a tree of nodes (a scene graph), each with a
+local matrix relative to its parent, and works out the world matrix of every
+node:
+    world(node) = world(parent(node)) * local(node)
+
+    TransformHierarchy h;
+    uint32_t body = h.add(CreateRMModelMatrix(position, rotation));
+    uint32_t arm = h.add(mat4::translation({0, 1, 0}), body);
+    ...
+    h.setLocal(body, CreateRMModelMatrix(new_position, rotation));
+    h.update();
+    draw(h.world(arm));
+
+Nodes are identified by the number add() returns, which never changes. The
+world matrices are only valid after update().
+
+================
+  Updates
+================
+Internally the nodes are kept in depth first order, so every node's subtree
+is one contiguous run of the arrays and a parent always comes before its
+children. setLocal() only marks the node as dirty, and update() recomputes
+the subtrees of the dirty nodes, so the cost of a frame depends on how many
+nodes moved (and how many nodes hang below them), not on the size of the
+whole tree.
+
+Adding nodes or changing a parent changes the order, so the next update()
+rebuilds it and recomputes everything once.
+
+When enough nodes need recomputing, update() splits the dirty subtrees into
+independent pieces and runs those on several threads, using the same
+settings as the batch transforms (see 'Threading' in lina_batch.hpp).
+
+*/
+
+namespace lina {
+    struct TransformHierarchy {
+        enum : uint32_t { NoParent = 0xFFFFFFFFu };
+
+        TransformHierarchy() noexcept : restructure(false) {}
+
+        // Adds a node and returns its id, `parent` has to be an existing node or NoParent.
+        uint32_t add(const mat4& local = mat4(), uint32_t parent = NoParent) {
+            uint32_t id = (uint32_t)parents.size();
+            parents.push_back(parent);
+            slots.push_back(id);
+            parent_slots.push_back(parent == NoParent ? NoParent : slots[parent]);
+            sizes.push_back(1);
+            locals.push_back(local);
+            worlds.push_back(local);
+            restructure = true;
+            return id;
+        }
+
+        size_t size() const noexcept { return parents.size(); }
+
+        uint32_t parent(uint32_t id) const noexcept { return parents[id]; }
+
+        // Moves `id` (with its subtree) under `parent`. Throws std::invalid_argument if `parent`
+        // is `id` itself or one of its descendants.
+        void setParent(uint32_t id, uint32_t parent) {
+            for (uint32_t p = parent; p != NoParent; p = parents[p])
+                if (p == id) throw std::invalid_argument("lina::TransformHierarchy::setParent: a node can't be its own ancestor.");
+            parents[id] = parent;
+            restructure = true;
+        }
+
+        const mat4& local(uint32_t id) const noexcept { return locals[slots[id]]; }
+
+        void setLocal(uint32_t id, const mat4& m) {
+            uint32_t s = slots[id];
+            locals[s] = m;
+            dirty_slots.push_back(s);
+        }
+        void setLocal(uint32_t id, vec3 position, quat rotation, vec3 scale = vec3(1.f, 1.f, 1.f)) {
+            setLocal(id, CreateRMModelMatrix(position, rotation, vec4(scale.x, scale.y, scale.z, 1.f)));
+        }
+
+        // Only valid after update().
+        const mat4& world(uint32_t id) const noexcept { return worlds[slots[id]]; }
+
+        // True if update() has something to do.
+        bool dirty() const noexcept { return restructure || !dirty_slots.empty(); }
+
+        // Recomputes the world matrices of every node that moved and everything below them.
+        void update() {
+            if (restructure) {
+                rebuild();
+                dirty_slots.clear();
+                for (uint32_t s = 0; s < (uint32_t)sizes.size(); s += sizes[s]) dirty_slots.push_back(s);
+            }
+            if (dirty_slots.empty()) return;
+
+            // Sorted dirty slots, dropping the ones that are inside the subtree of an earlier one.
+            std::sort(dirty_slots.begin(), dirty_slots.end());
+            size_t total = 0, roots = 0;
+            uint32_t covered = 0;
+            for (uint32_t s : dirty_slots) {
+                if (s < covered) continue;
+                dirty_slots[roots++] = s;
+                covered = s + sizes[s];
+                total += sizes[s];
+            }
+            dirty_slots.resize(roots);
+
+            const detail::batch_settings& bs = detail::batchSettings();
+            size_t grain = bs.threshold ? bs.threshold : 1;
+            if (total < 2 * grain) {
+                for (uint32_t s : dirty_slots) compose(s, s + sizes[s]);
+                dirty_slots.clear();
+                return;
+            }
+
+            // Subtrees bigger than the grain get split: their root is done here, and each child's
+            // subtree becomes its own task. Sibling subtrees don't share anything, so the tasks can
+            // run in any order on any thread.
+            tasks.clear();
+            split(grain);
+            dirty_slots.clear();
+
+            task_offsets.resize(tasks.size() + 1);
+            task_offsets[0] = 0;
+            for (size_t k = 0; k < tasks.size(); k++) task_offsets[k + 1] = task_offsets[k] + sizes[tasks[k]];
+
+            TransformHierarchy* self = this;
+            const uint32_t* t = tasks.data();
+            const size_t* off = task_offsets.data();
+            size_t count = tasks.size();
+            detail::batch_for(task_offsets[count], [=](size_t b, size_t e) {
+                // Every task whose first node falls in [b, e) belongs to this range.
+                size_t k = std::lower_bound(off, off + count, b) - off;
+                for (; k < count && off[k] < e; k++) self->compose(t[k], t[k] + self->sizes[t[k]]);
+            });
+        }
+
+    private:
+        std::vector<uint32_t> parents;       // by id
+        std::vector<uint32_t> slots;         // id -> position in the depth first order
+        std::vector<uint32_t> parent_slots;  // the rest are by position
+        std::vector<uint32_t> sizes;         // number of nodes in the subtree, including the node itself
+        aligned_vector<mat4> locals;  // aligned so every matrix is one cache line
+        aligned_vector<mat4> worlds;
+        std::vector<uint32_t> dirty_slots;
+        std::vector<uint32_t> tasks;
+        std::vector<size_t> task_offsets;
+        bool restructure;
+
+        // Recomputes [begin, end), which has to be whole subtrees with up to date parents.
+        void compose(uint32_t begin, uint32_t end) noexcept {
+            for (uint32_t s = begin; s < end; s++) {
+                uint32_t p = parent_slots[s];
+                if (p == NoParent) worlds[s] = locals[s];
+                else detail::mat4_mul(worlds[p].data(), locals[s].data(), worlds[s].data());
+            }
+        }
+
+        // Splits the dirty subtrees into tasks. It goes down the tree with its own stack instead of
+        // recursing, a long chain (a rope, a bone chain) would overflow the thread's stack.
+        void split(size_t grain) {
+            std::vector<uint32_t> stack;
+            for (uint32_t root : dirty_slots) {
+                stack.push_back(root);
+                while (!stack.empty()) {
+                    uint32_t s = stack.back();
+                    stack.pop_back();
+                    if (sizes[s] <= grain) {
+                        tasks.push_back(s);
+                        continue;
+                    }
+                    compose(s, s + 1);
+                    // Pushed last to first, so the tasks come out in depth first order.
+                    size_t at = stack.size();
+                    for (uint32_t c = s + 1; c < s + sizes[s]; c += sizes[c]) stack.push_back(c);
+                    std::reverse(stack.begin() + at, stack.end());
+                }
+            }
+        }
+
+        // Puts the nodes back in depth first order after nodes were added or moved.
+        void rebuild() {
+            uint32_t n = (uint32_t)parents.size();
+            // Children of every node in id order, as one array with an offset per node.
+            std::vector<uint32_t> first(n + 1, 0), children(n);
+            for (uint32_t id = 0; id < n; id++)
+                if (parents[id] != NoParent) first[parents[id] + 1]++;
+            for (uint32_t id = 0; id < n; id++) first[id + 1] += first[id];
+            std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+            for (uint32_t id = 0; id < n; id++)
+                if (parents[id] != NoParent) children[fill[parents[id]]++] = id;
+
+            std::vector<uint32_t> order;
+            order.reserve(n);
+            std::vector<uint32_t> stack;
+            for (uint32_t root = 0; root < n; root++) {
+                if (parents[root] != NoParent) continue;
+                stack.push_back(root);
+                while (!stack.empty()) {
+                    uint32_t id = stack.back();
+                    stack.pop_back();
+                    order.push_back(id);
+                    for (uint32_t c = first[id + 1]; c > first[id]; c--) stack.push_back(children[c - 1]);
+                }
+            }
+
+            aligned_vector<mat4> new_locals(n);
+            for (uint32_t s = 0; s < n; s++) new_locals[s] = locals[slots[order[s]]];
+            locals.swap(new_locals);
+            for (uint32_t s = 0; s < n; s++) slots[order[s]] = s;
+            for (uint32_t s = 0; s < n; s++) {
+                uint32_t p = parents[order[s]];
+                parent_slots[s] = p == NoParent ? NoParent : slots[p];
+            }
+            for (uint32_t s = n; s-- > 0;) sizes[s] = 1;
+            for (uint32_t s = n; s-- > 0;)
+                if (parent_slots[s] != NoParent) sizes[parent_slots[s]] += sizes[s];
+            restructure = false;
+        }
+    };
+}
+
+#endif /* LINA_HIERARCHY_HPP */
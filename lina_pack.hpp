@@ -0,0 +1,508 @@
+#ifndef LINA_PACK_HPP
+#define LINA_PACK_HPP
+
+#include "lina.hpp"
+#include "lina_batch.hpp"
+#include <stdint.h>
+#include <string.h>
+
+/*
+
+###################
+  Packed Vectors
+###################
+Smaller versions of vec3 and vec4 for storing big arrays (vertices, particles)
+when memory bandwidth matters more than the last few bits of precision:
+
+    type        size      stores                 error after a round trip
+    half3       6 bytes   any vec3 (IEEE half)   relative 2^-11 (4.9e-4) for |x| in [6.1e-5, 65504],
+    half4       8 bytes   any vec4               absolute 2^-25 (3e-8) below that, inf above 65519
+    snorm16x3   6 bytes   vec3 in [-1, 1]        absolute 1.54e-5
+    snorm16x4   8 bytes   vec4 in [-1, 1]        absolute 1.54e-5
+    unorm8x4    4 bytes   vec4 in [0, 1]         absolute 1.97e-3, for colors
+    octnormal   4 bytes   unit vec3              angle 6.6e-5 radians (0.004 degrees)
+
+The snorm and unorm errors are half a step (1/65534 and 1/510) plus the float
+rounding of the scale in both directions. For octnormal half a step of u and v
+turns into up to sqrt(18) times that as an angle, near the middle of each face
+of the octahedron, which is 6.47e-5 plus the rounding. tests/kernels.cpp checks
+all of these bounds.
+
+The half types round to nearest even and keep infinities and NaNs (but not the
+payload of a NaN). The snorm and unorm types clamp to their range first, NaN
+ends up as the bottom of the range. octnormal (octahedral encoding) folds the
+unit sphere onto a square and stores that as 2 snorm16s, so it's a lot more
+accurate than a snorm16x3 for half the size, but the vector you put in has to
+be normalized, and the one you get back always is.
+
+Every type has fromVec3/fromVec4 and toVec3/toVec4:
+    half3 h = half3::fromVec3(position);
+    vec3 p = h.toVec3();
+
+================
+  Bulk
+================
+For whole arrays there's pack(in, out) and unpack(in, out), overloaded for
+every type:
+    std::vector<vec3> normals = ...;
+    std::vector<octnormal> packed(normals.size());
+    pack(normals, packed);
+    unpack(packed, normals);
+
+They convert 4 or 8 vectors at a time (see 'SIMD' in lina.hpp). The half types
+use the F16C instructions when the compiler has them (-mf16c, or any -march
+from Haswell on) and a bit trick on plain SSE2 otherwise, which is slower but
+gives the same results. NEON uses the conversion instructions on AArch64.
+'out' needs to be at least as big as 'in', big arrays are split across threads
+like the batch transforms (see 'Threading' in lina_batch.hpp).
+
+*/
+
+#if LINA_SIMD_X86 && (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__)))
+    #define LINA_F16C 1
+#else
+    #define LINA_F16C 0
+#endif
+
+namespace lina {
+    namespace detail {
+        inline uint32_t float_bits(float f) noexcept {
+            uint32_t u;
+            memcpy(&u, &f, 4);
+            return u;
+        }
+
+        inline float bits_float(uint32_t u) noexcept {
+            float f;
+            memcpy(&f, &u, 4);
+            return f;
+        }
+
+        // Round to nearest even, subnormals included.
+        inline uint16_t float_to_half(float f) noexcept {
+            uint32_t u = float_bits(f);
+            uint32_t sign = u & 0x80000000u;
+            u ^= sign;
+            uint16_t h;
+            if (u >= 0x47800000u) {  // too big for a half, infinity or NaN
+                h = u > 0x7F800000u ? 0x7E00 : 0x7C00;
+            } else if (u < 0x38800000u) {  // subnormal half or zero, the float add does the rounding
+                const uint32_t magic = ((127 - 15) + (23 - 10) + 1) << 23;
+                h = (uint16_t)(float_bits(bits_float(u) + bits_float(magic)) - magic);
+            } else {
+                uint32_t odd = (u >> 13) & 1u;
+                u += ((uint32_t)(15 - 127) << 23) + 0xFFFu + odd;
+                h = (uint16_t)(u >> 13);
+            }
+            return (uint16_t)(h | (sign >> 16));
+        }
+
+        inline float half_to_float(uint16_t h) noexcept {
+            uint32_t em = h & 0x7FFFu;
+            // Shifting the exponent and mantissa into place and scaling by 2^112 fixes the
+            // exponent bias and turns subnormal halves into normal floats.
+            uint32_t u = float_bits(bits_float(em << 13) * bits_float(0x77800000u));
+            if (em >= 0x7C00u) u |= 0x7F800000u;
+            return bits_float(u | (uint32_t)(h & 0x8000u) << 16);
+        }
+
+        // Rounds to nearest even like the SIMD conversions. The magic number trick would do the
+        // same, but the compiler is allowed to fuse its multiply and add.
+        inline int32_t round_even(float f) noexcept {
+        #if LINA_SIMD_X86
+            return _mm_cvtss_si32(_mm_set_ss(f));
+        #elif LINA_SIMD == LINA_SIMD_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+            return vcvtns_s32_f32(f);
+        #else
+            return (int32_t)lrintf(f);
+        #endif
+        }
+
+        inline int16_t float_to_snorm16(float f) noexcept {
+            f = f > -1.f ? f : -1.f;
+            f = f < 1.f ? f : 1.f;
+            return (int16_t)round_even(f * 32767.f);
+        }
+
+        inline float snorm16_to_float(int16_t s) noexcept {
+            float f = (float)s * (1.f / 32767.f);
+            return f > -1.f ? f : -1.f;
+        }
+
+        inline uint8_t float_to_unorm8(float f) noexcept {
+            f = f > 0.f ? f : 0.f;
+            f = f < 1.f ? f : 1.f;
+            return (uint8_t)round_even(f * 255.f);
+        }
+
+        inline float unorm8_to_float(uint8_t u) noexcept {
+            return (float)u * (1.f / 255.f);
+        }
+
+    #if LINA_SIMD == LINA_SIMD_NEON
+        inline int32x4_t neon_round_even(float32x4_t f) noexcept {
+        #if defined(__aarch64__) || defined(_M_ARM64)
+            return vcvtnq_s32_f32(f);
+        #else
+            // ARMv7 only converts towards zero, adding and subtracting 1.5 * 2^23 rounds first.
+            const float32x4_t magic = vdupq_n_f32(12582912.f);
+            return vcvtq_s32_f32(vsubq_f32(vaddq_f32(f, magic), magic));
+        #endif
+        }
+    #endif
+
+        // The flat kernels below convert n floats, the vector types are just arrays of their
+        // components so a vec3 array is 3n floats and a half3 array 3n halves.
+        inline void floats_to_halves(const float* in, uint16_t* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_F16C && LINA_SIMD >= LINA_SIMD_AVX
+            for (; n - i >= 8; i += 8)
+                _mm_storeu_si128((__m128i*)(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+        #elif LINA_F16C
+            for (; n - i >= 4; i += 4)
+                _mm_storel_epi64((__m128i*)(out + i), _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+        #elif LINA_SIMD_X86
+            // The same steps as float_to_half, with both paths computed and then selected.
+            const __m128i subnormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+            const __m128i normal_bias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+            for (; n - i >= 4; i += 4) {
+                __m128 f = _mm_loadu_ps(in + i);
+                __m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.f));
+                __m128 absf = _mm_xor_ps(f, sign);
+                __m128i u = _mm_castps_si128(absf);
+                __m128i nan = _mm_and_si128(_mm_castps_si128(_mm_cmpunord_ps(absf, absf)), _mm_set1_epi32(0x200));
+                __m128i inf_or_nan = _mm_or_si128(nan, _mm_set1_epi32(0x7C00));
+                __m128i regular = _mm_cmpgt_epi32(_mm_set1_epi32(0x47800000), u);
+                __m128i subnormal = _mm_cmpgt_epi32(_mm_set1_epi32(0x38800000), u);
+
+                __m128i sub = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnormal_magic))), subnormal_magic);
+                __m128i odd = _mm_srai_epi32(_mm_slli_epi32(u, 31 - 13), 31);
+                __m128i norm = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(u, normal_bias), odd), 13);
+
+                __m128i h = _mm_or_si128(_mm_and_si128(subnormal, sub), _mm_andnot_si128(subnormal, norm));
+                h = _mm_or_si128(_mm_and_si128(regular, h), _mm_andnot_si128(regular, inf_or_nan));
+                h = _mm_or_si128(h, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+                // Sign extending first keeps packs from saturating the halves with the top bit set.
+                h = _mm_srai_epi32(_mm_slli_epi32(h, 16), 16);
+                _mm_storel_epi64((__m128i*)(out + i), _mm_packs_epi32(h, h));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+            for (; n - i >= 4; i += 4)
+                vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+        #endif
+            // The rest one at a time. Walking the pointers instead of indexing keeps GCC -O3 from
+            // warning about the loop.
+            for (in += i, out += i; i < n; i++) *out++ = float_to_half(*in++);
+        }
+
+        inline void halves_to_floats(const uint16_t* in, float* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_F16C && LINA_SIMD >= LINA_SIMD_AVX
+            for (; n - i >= 8; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(in + i))));
+        #elif LINA_F16C
+            for (; n - i >= 4; i += 4)
+                _mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(in + i))));
+        #elif LINA_SIMD_X86
+            for (; n - i >= 4; i += 4) {
+                __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(in + i)), _mm_setzero_si128());
+                __m128i em = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+                __m128 f = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(em, 13)), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+                __m128i infnan = _mm_and_si128(_mm_cmpgt_epi32(em, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(0x7F800000));
+                __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, em), 16);
+                _mm_storeu_ps(out + i, _mm_or_ps(f, _mm_castsi128_ps(_mm_or_si128(sign, infnan))));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+            for (; n - i >= 4; i += 4)
+                vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+        #endif
+            for (in += i, out += i; i < n; i++) *out++ = half_to_float(*in++);
+        }
+
+        inline void floats_to_snorm16(const float* in, int16_t* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; n - i >= 8; i += 8) {
+                __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+                __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+                __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(32767.f)));
+                __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, _mm_set1_ps(32767.f)));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(ia, ib));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; n - i >= 4; i += 4) {
+                float32x4_t f = vminq_f32(vmaxq_f32(vld1q_f32(in + i), vdupq_n_f32(-1.f)), vdupq_n_f32(1.f));
+                vst1_s16(out + i, vmovn_s32(neon_round_even(vmulq_f32(f, vdupq_n_f32(32767.f)))));
+            }
+        #endif
+            for (in += i, out += i; i < n; i++) *out++ = float_to_snorm16(*in++);
+        }
+
+        inline void snorm16_to_floats(const int16_t* in, float* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; n - i >= 8; i += 8) {
+                __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+                const __m128 scale = _mm_set1_ps(1.f / 32767.f);
+                _mm_storeu_ps(out + i, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), _mm_set1_ps(-1.f)));
+                _mm_storeu_ps(out + i + 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), _mm_set1_ps(-1.f)));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; n - i >= 4; i += 4) {
+                float32x4_t f = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(in + i))), vdupq_n_f32(1.f / 32767.f));
+                vst1q_f32(out + i, vmaxq_f32(f, vdupq_n_f32(-1.f)));
+            }
+        #endif
+            for (in += i, out += i; i < n; i++) *out++ = snorm16_to_float(*in++);
+        }
+
+        inline void floats_to_unorm8(const float* in, uint8_t* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; n - i >= 8; i += 8) {
+                __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), _mm_setzero_ps()), _mm_set1_ps(1.f));
+                __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), _mm_setzero_ps()), _mm_set1_ps(1.f));
+                __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(255.f)));
+                __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, _mm_set1_ps(255.f)));
+                __m128i s = _mm_packs_epi32(ia, ib);
+                _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(s, s));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; n - i >= 8; i += 8) {
+                float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(in + i), vdupq_n_f32(0.f)), vdupq_n_f32(1.f));
+                float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(in + i + 4), vdupq_n_f32(0.f)), vdupq_n_f32(1.f));
+                int32x4_t ia = neon_round_even(vmulq_f32(a, vdupq_n_f32(255.f)));
+                int32x4_t ib = neon_round_even(vmulq_f32(b, vdupq_n_f32(255.f)));
+                uint16x8_t s = vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(ia)), vmovn_u32(vreinterpretq_u32_s32(ib)));
+                vst1_u8(out + i, vmovn_u16(s));
+            }
+        #endif
+            for (in += i, out += i; i < n; i++) *out++ = float_to_unorm8(*in++);
+        }
+
+        inline void unorm8_to_floats(const uint8_t* in, float* out, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; n - i >= 8; i += 8) {
+                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(in + i)), _mm_setzero_si128());
+                const __m128 scale = _mm_set1_ps(1.f / 255.f);
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(s, _mm_setzero_si128())), scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(s, _mm_setzero_si128())), scale));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; n - i >= 8; i += 8) {
+                uint16x8_t s = vmovl_u8(vld1_u8(in + i));
+                const float32x4_t scale = vdupq_n_f32(1.f / 255.f);
+                vst1q_f32(out + i, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(s))), scale));
+                vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(s))), scale));
+            }
+        #endif
+            for (in += i, out += i; i < n; i++) *out++ = unorm8_to_float(*in++);
+        }
+
+        // Octahedral encoding: project onto the octahedron |x| + |y| + |z| = 1, and fold the
+        // lower half (z < 0) over the edges of the square. For z < 0 the folded coordinate
+        // copysign(1 - |v|, u) is the same as u + copysign(|z|, u), so the fold is branchless.
+        inline void oct_encode(floatv x, floatv y, floatv z, floatv& u, floatv& v) noexcept {
+            floatv inv = setv(1.f) / (absv(x) + absv(y) + absv(z));
+            u = x * inv;
+            v = y * inv;
+            floatv t = maxv(setv(0.f) - z * inv, setv(0.f));
+            u = u + copysignv(t, u);
+            v = v + copysignv(t, v);
+        }
+
+        inline void oct_decode(floatv u, floatv v, floatv& x, floatv& y, floatv& z) noexcept {
+            z = setv(1.f) - absv(u) - absv(v);
+            floatv t = maxv(setv(0.f) - z, setv(0.f));
+            x = u - copysignv(t, u);
+            y = v - copysignv(t, v);
+            floatv l = sqrtv(x * x + y * y + z * z);
+            x = x / l;
+            y = y / l;
+            z = z / l;
+        }
+
+        // Converts up to floatv_width vec3s at a time, through a stack copy of the uv pairs so the
+        // quantization can use the flat kernel.
+        inline void vec3s_to_oct(const float* in, int16_t* out, size_t n) noexcept {
+            for (size_t i = 0; i < n; i += floatv_width) {
+                size_t count = n - i < (size_t)floatv_width ? n - i : (size_t)floatv_width;
+                float x[floatv_width] = {}, y[floatv_width] = {}, z[floatv_width], uv[2 * floatv_width];
+                for (size_t j = 0; j < floatv_width; j++) z[j] = 1.f;
+                for (size_t j = 0; j < count; j++) {
+                    x[j] = in[(i + j) * 3 + 0];
+                    y[j] = in[(i + j) * 3 + 1];
+                    z[j] = in[(i + j) * 3 + 2];
+                }
+                floatv u, v;
+                oct_encode(loadv(x), loadv(y), loadv(z), u, v);
+                storev(x, u);
+                storev(y, v);
+                for (size_t j = 0; j < count; j++) {
+                    uv[2 * j] = x[j];
+                    uv[2 * j + 1] = y[j];
+                }
+                floats_to_snorm16(uv, out + 2 * i, 2 * count);
+            }
+        }
+
+        inline void oct_to_vec3s(const int16_t* in, float* out, size_t n) noexcept {
+            for (size_t i = 0; i < n; i += floatv_width) {
+                size_t count = n - i < (size_t)floatv_width ? n - i : (size_t)floatv_width;
+                float uv[2 * floatv_width], u[floatv_width] = {}, v[floatv_width] = {}, z[floatv_width];
+                snorm16_to_floats(in + 2 * i, uv, 2 * count);
+                for (size_t j = 0; j < count; j++) {
+                    u[j] = uv[2 * j];
+                    v[j] = uv[2 * j + 1];
+                }
+                floatv x, y, zv;
+                oct_decode(loadv(u), loadv(v), x, y, zv);
+                storev(u, x);
+                storev(v, y);
+                storev(z, zv);
+                for (size_t j = 0; j < count; j++) {
+                    out[(i + j) * 3 + 0] = u[j];
+                    out[(i + j) * 3 + 1] = v[j];
+                    out[(i + j) * 3 + 2] = z[j];
+                }
+            }
+        }
+
+        // Runs a flat kernel over the components of every vector, split across threads.
+        template <typename I, typename O, typename K>
+        inline void pack_for(span<const I> in, span<O> out, K kernel) {
+            typedef typename std::remove_reference<decltype(in.data()->x)>::type CI;
+            typedef typename std::remove_reference<decltype(out.data()->x)>::type CO;
+            const size_t n = sizeof(I) / sizeof(CI);
+            const CI* i = reinterpret_cast<const CI*>(in.data());
+            CO* o = reinterpret_cast<CO*>(out.data());
+            batch_for(in.size(), [=](size_t b, size_t e) { kernel(i + b * n, o + b * n, (e - b) * n); });
+        }
+    }
+
+    struct half3 {
+        uint16_t x, y, z;
+
+        inline static half3 fromVec3(vec3 v) noexcept {
+            return {detail::float_to_half(v.x), detail::float_to_half(v.y), detail::float_to_half(v.z)};
+        }
+        inline vec3 toVec3() const noexcept {
+            return vec3(detail::half_to_float(x), detail::half_to_float(y), detail::half_to_float(z));
+        }
+    };
+
+    struct half4 {
+        uint16_t x, y, z, w;
+
+        inline static half4 fromVec4(vec4 v) noexcept {
+            return {detail::float_to_half(v.x), detail::float_to_half(v.y), detail::float_to_half(v.z), detail::float_to_half(v.w)};
+        }
+        inline vec4 toVec4() const noexcept {
+            return vec4(detail::half_to_float(x), detail::half_to_float(y), detail::half_to_float(z), detail::half_to_float(w));
+        }
+    };
+
+    struct snorm16x3 {
+        int16_t x, y, z;
+
+        inline static snorm16x3 fromVec3(vec3 v) noexcept {
+            return {detail::float_to_snorm16(v.x), detail::float_to_snorm16(v.y), detail::float_to_snorm16(v.z)};
+        }
+        inline vec3 toVec3() const noexcept {
+            return vec3(detail::snorm16_to_float(x), detail::snorm16_to_float(y), detail::snorm16_to_float(z));
+        }
+    };
+
+    struct snorm16x4 {
+        int16_t x, y, z, w;
+
+        inline static snorm16x4 fromVec4(vec4 v) noexcept {
+            return {detail::float_to_snorm16(v.x), detail::float_to_snorm16(v.y), detail::float_to_snorm16(v.z), detail::float_to_snorm16(v.w)};
+        }
+        inline vec4 toVec4() const noexcept {
+            return vec4(detail::snorm16_to_float(x), detail::snorm16_to_float(y), detail::snorm16_to_float(z), detail::snorm16_to_float(w));
+        }
+    };
+
+    struct unorm8x4 {
+        uint8_t x, y, z, w;
+
+        inline static unorm8x4 fromVec4(vec4 v) noexcept {
+            return {detail::float_to_unorm8(v.x), detail::float_to_unorm8(v.y), detail::float_to_unorm8(v.z), detail::float_to_unorm8(v.w)};
+        }
+        inline vec4 toVec4() const noexcept {
+            return vec4(detail::unorm8_to_float(x), detail::unorm8_to_float(y), detail::unorm8_to_float(z), detail::unorm8_to_float(w));
+        }
+    };
+
+    struct octnormal {
+        int16_t u, v;
+
+        // `n` has to be normalized.
+        inline static octnormal fromVec3(vec3 n) noexcept {
+            octnormal o;
+            detail::vec3s_to_oct(&n.x, &o.u, 1);
+            return o;
+        }
+        // Always returns a unit vector.
+        inline vec3 toVec3() const noexcept {
+            vec3 n;
+            detail::oct_to_vec3s(&u, &n.x, 1);
+            return n;
+        }
+    };
+
+    static_assert(sizeof(vec3) == 3 * sizeof(float) && sizeof(vec4) == 4 * sizeof(float), "the bulk conversions treat vectors as arrays of floats");
+    static_assert(sizeof(half3) == 6 && sizeof(half4) == 8 && sizeof(snorm16x3) == 6 && sizeof(snorm16x4) == 8 && sizeof(unorm8x4) == 4 && sizeof(octnormal) == 4,
+                  "packed vectors can't have padding");
+
+    inline void pack(span<const vec3> in, span<half3> out) {
+        detail::pack_for(in, out, detail::floats_to_halves);
+    }
+    inline void unpack(span<const half3> in, span<vec3> out) {
+        detail::pack_for(in, out, detail::halves_to_floats);
+    }
+    inline void pack(span<const vec4> in, span<half4> out) {
+        detail::pack_for(in, out, detail::floats_to_halves);
+    }
+    inline void unpack(span<const half4> in, span<vec4> out) {
+        detail::pack_for(in, out, detail::halves_to_floats);
+    }
+
+    inline void pack(span<const vec3> in, span<snorm16x3> out) {
+        detail::pack_for(in, out, detail::floats_to_snorm16);
+    }
+    inline void unpack(span<const snorm16x3> in, span<vec3> out) {
+        detail::pack_for(in, out, detail::snorm16_to_floats);
+    }
+    inline void pack(span<const vec4> in, span<snorm16x4> out) {
+        detail::pack_for(in, out, detail::floats_to_snorm16);
+    }
+    inline void unpack(span<const snorm16x4> in, span<vec4> out) {
+        detail::pack_for(in, out, detail::snorm16_to_floats);
+    }
+
+    inline void pack(span<const vec4> in, span<unorm8x4> out) {
+        detail::pack_for(in, out, detail::floats_to_unorm8);
+    }
+    inline void unpack(span<const unorm8x4> in, span<vec4> out) {
+        detail::pack_for(in, out, detail::unorm8_to_floats);
+    }
+
+    // The vectors have to be normalized.
+    inline void pack(span<const vec3> in, span<octnormal> out) {
+        const float* i = reinterpret_cast<const float*>(in.data());
+        int16_t* o = reinterpret_cast<int16_t*>(out.data());
+        detail::batch_for(in.size(), [=](size_t b, size_t e) { detail::vec3s_to_oct(i + b * 3, o + b * 2, e - b); });
+    }
+    inline void unpack(span<const octnormal> in, span<vec3> out) {
+        const int16_t* i = reinterpret_cast<const int16_t*>(in.data());
+        float* o = reinterpret_cast<float*>(out.data());
+        detail::batch_for(in.size(), [=](size_t b, size_t e) { detail::oct_to_vec3s(i + b * 2, o + b * 3, e - b); });
+    }
+}
+
+#endif /* LINA_PACK_HPP */
@@ -0,0 +1,313 @@
+#ifndef LINA_SKIN_HPP
+#define LINA_SKIN_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_batch.hpp"
+#include "lina_alloc.hpp"
+#include "lina_hierarchy.hpp"
+#include <stdint.h>
+
+/*
+
+###################
+     Skinning
+###################
+Linear blend skinning: every vertex is moved by up to 4 or 8 bones, and ends
+up at the weighted sum of where each of those bones would put it:
+    p' = sum(weight[k] * palette[bone[k]] * p)
+
+'SkinPalette' holds the matrix of every bone, which is the bone's world matrix
+times its inverse bind matrix. buildSkinPalette computes it for every bone at
+once, either from an array of world matrices or straight from the nodes of a
+TransformHierarchy:
+    SkinPalette palette;
+    buildSkinPalette(hierarchy, bone_nodes, inverse_binds, palette);
+
+'SkinWeights<K>' (SkinWeights4 and SkinWeights8) holds the bone indices and
+weights of every vertex in structure-of-arrays form. Influences a vertex
+doesn't need should have a weight of 0, their bone index still has to be a
+valid bone, so just use 0. The weights of a vertex should add up to 1.
+
+skinVertices does the skinning. The positions (and optionally the normals)
+come in as a Vec3Stream, and go out either as arrays of vec3 or as
+Vec3Streams:
+    skinVertices(palette, weights, bind_positions, bind_normals, span<vec3>(positions), span<vec3>(normals));
+
+Normals are transformed by the blended matrix without the translation and
+normalized afterwards. That's only exact for bones without non-uniform
+scaling, which is the same trade-off every linear blend skinning makes.
+
+Only the first 3 rows of the palette matrices are used, so they have to be
+affine (the bottom row 0 0 0 1), which any product of model matrices is.
+
+================
+  Performance
+================
+Every vertex blends its K matrices with 4 wide SIMD instructions (a column
+of the matrix per instruction, see 'SIMD' in lina.hpp), the palette is kept
+column by column and aligned so every bone is one cache line. Big meshes are
+split across threads like the batch transforms (see 'Threading' in
+lina_batch.hpp).
+
+The FMA paths can differ from the scalar reference (detail::skin_vertex_scalar)
+by a few ULP, the others give the exact same results.
+
+*/
+
+namespace lina {
+    // The skinning matrix of every bone, see 'Skinning'.
+    struct SkinPalette {
+        SkinPalette() noexcept {}
+        explicit SkinPalette(size_t bones) { resize(bones); }
+
+        size_t size() const noexcept { return cols.size() / 16; }
+        void resize(size_t bones) { cols.resize(bones * 16); }
+
+        // Stored transposed, so every column of the matrix is 4 floats next to each other.
+        void set(size_t bone, const mat4& m) noexcept { detail::mat4_transpose(m.data(), data(bone)); }
+        mat4 get(size_t bone) const noexcept {
+            mat4 m;
+            detail::mat4_transpose(data(bone), m.data());
+            return m;
+        }
+
+        float* data(size_t bone) noexcept { return cols.data() + bone * 16; }
+        const float* data(size_t bone) const noexcept { return cols.data() + bone * 16; }
+
+    private:
+        aligned_vector<float> cols;
+    };
+
+    // The bone indices and weights of every vertex, K has to be 4 or 8 (see 'Skinning').
+    template <int K>
+    struct SkinWeights {
+        static_assert(K == 4 || K == 8, "lina::SkinWeights has 4 or 8 influences per vertex.");
+        enum { influences = K };
+
+        SkinWeights() noexcept : count(0) {}
+        explicit SkinWeights(size_t n) : count(0) { resize(n); }
+
+        size_t size() const noexcept { return count; }
+        void resize(size_t n) {
+            for (int k = 0; k < K; k++) {
+                bone_arrays[k].resize(n);
+                weight_arrays[k].resize(n);
+            }
+            count = n;
+        }
+
+        // Sets the K bones and weights of vertex `v`.
+        void set(size_t v, const uint16_t* bones, const float* weights) noexcept {
+            for (int k = 0; k < K; k++) {
+                bone_arrays[k][v] = bones[k];
+                weight_arrays[k][v] = weights[k];
+            }
+        }
+
+        // Influence k of every vertex.
+        uint16_t* bones(int k) noexcept { return bone_arrays[k].data(); }
+        const uint16_t* bones(int k) const noexcept { return bone_arrays[k].data(); }
+        float* weights(int k) noexcept { return weight_arrays[k].data(); }
+        const float* weights(int k) const noexcept { return weight_arrays[k].data(); }
+
+    private:
+        aligned_vector<uint16_t> bone_arrays[K];
+        aligned_vector<float> weight_arrays[K];
+        size_t count;
+    };
+
+    typedef SkinWeights<4> SkinWeights4;
+    typedef SkinWeights<8> SkinWeights8;
+
+    namespace detail {
+        // The influences of a whole mesh, as arrays of K pointers.
+        template <int K>
+        struct skin_influences {
+            const uint16_t* bone[K];
+            const float* weight[K];
+
+            explicit skin_influences(const SkinWeights<K>& w) noexcept {
+                for (int k = 0; k < K; k++) {
+                    bone[k] = w.bones(k);
+                    weight[k] = w.weights(k);
+                }
+            }
+        };
+
+        // Skins vertex `i`, `n` and `rn` can be null when there's no normal. The normal isn't
+        // normalized yet. `palette` is the transposed matrices, 16 floats per bone.
+        template <int K>
+        inline void skin_vertex_scalar(const float* palette, const skin_influences<K>& inf, size_t i,
+                                       const float* p, const float* n, float* rp, float* rn) noexcept {
+            float c[16];
+            const float* m = palette + 16 * (size_t)inf.bone[0][i];
+            float w = inf.weight[0][i];
+            for (int j = 0; j < 16; j++) c[j] = m[j] * w;
+            for (int k = 1; k < K; k++) {
+                m = palette + 16 * (size_t)inf.bone[k][i];
+                w = inf.weight[k][i];
+                for (int j = 0; j < 16; j++) c[j] = m[j] * w + c[j];
+            }
+            for (int r = 0; r < 3; r++) {
+                rp[r] = c[8 + r] * p[2] + (c[4 + r] * p[1] + (c[r] * p[0] + c[12 + r]));
+                if (n) rn[r] = c[8 + r] * n[2] + (c[4 + r] * n[1] + c[r] * n[0]);
+            }
+        }
+
+    #if LINA_SIMD != LINA_SIMD_SCALAR
+    #if LINA_SIMD == LINA_SIMD_NEON
+        inline f128 skin_load(const float* p) noexcept { return vld1q_f32(p); }
+        inline f128 skin_set(float f) noexcept { return vdupq_n_f32(f); }
+        inline f128 skin_mul(f128 a, f128 b) noexcept { return vmulq_f32(a, b); }
+        inline void skin_store(float* p, f128 v) noexcept { vst1q_f32(p, v); }
+    #else
+        // The palette is 64 byte aligned and every bone is 64 bytes, so the loads can be aligned.
+        inline f128 skin_load(const float* p) noexcept { return _mm_load_ps(p); }
+        inline f128 skin_set(float f) noexcept { return _mm_set1_ps(f); }
+        inline f128 skin_mul(f128 a, f128 b) noexcept { return _mm_mul_ps(a, b); }
+        inline void skin_store(float* p, f128 v) noexcept { _mm_storeu_ps(p, v); }
+    #endif
+
+        // Same as skin_vertex_scalar, but rp and rn need room for 4 floats.
+        template <int K>
+        inline void skin_vertex(const float* palette, const skin_influences<K>& inf, size_t i,
+                                const float* p, const float* n, float* rp, float* rn) noexcept {
+            const float* m = palette + 16 * (size_t)inf.bone[0][i];
+            f128 w = skin_set(inf.weight[0][i]);
+            f128 c0 = skin_mul(skin_load(m), w), c1 = skin_mul(skin_load(m + 4), w);
+            f128 c2 = skin_mul(skin_load(m + 8), w), c3 = skin_mul(skin_load(m + 12), w);
+            for (int k = 1; k < K; k++) {
+                m = palette + 16 * (size_t)inf.bone[k][i];
+                w = skin_set(inf.weight[k][i]);
+                c0 = madd(skin_load(m), w, c0);
+                c1 = madd(skin_load(m + 4), w, c1);
+                c2 = madd(skin_load(m + 8), w, c2);
+                c3 = madd(skin_load(m + 12), w, c3);
+            }
+            skin_store(rp, madd(c2, skin_set(p[2]), madd(c1, skin_set(p[1]), madd(c0, skin_set(p[0]), c3))));
+            if (n) skin_store(rn, madd(c2, skin_set(n[2]), madd(c1, skin_set(n[1]), skin_mul(c0, skin_set(n[0])))));
+        }
+    #else
+        template <int K>
+        inline void skin_vertex(const float* palette, const skin_influences<K>& inf, size_t i,
+                                const float* p, const float* n, float* rp, float* rn) noexcept {
+            skin_vertex_scalar<K>(palette, inf, i, p, n, rp, rn);
+        }
+    #endif
+
+        // Skins every vertex of `pos` (and `nrm` if it isn't null) and hands the results to
+        // out(i, position, normal), split across threads.
+        template <int K, typename Out>
+        inline void skin_vertices(const SkinPalette& palette, const SkinWeights<K>& weights,
+                                  const Vec3Stream& pos, const Vec3Stream* nrm, Out out) {
+            skin_influences<K> inf(weights);
+            const float* pal = palette.size() ? palette.data(0) : nullptr;
+            const float *px = pos.x(), *py = pos.y(), *pz = pos.z();
+            const float *nx = nrm ? nrm->x() : nullptr, *ny = nrm ? nrm->y() : nullptr, *nz = nrm ? nrm->z() : nullptr;
+            batch_for(pos.size(), [=](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++) {
+                    float p[3] = {px[i], py[i], pz[i]};
+                    float rp[4], rn[4] = {};
+                    if (nx) {
+                        float n[3] = {nx[i], ny[i], nz[i]};
+                        skin_vertex<K>(pal, inf, i, p, n, rp, rn);
+                        float l = sqrtf(rn[0] * rn[0] + rn[1] * rn[1] + rn[2] * rn[2]);
+                        rn[0] /= l;
+                        rn[1] /= l;
+                        rn[2] /= l;
+                    } else {
+                        skin_vertex<K>(pal, inf, i, p, nullptr, rp, nullptr);
+                    }
+                    out(i, rp, rn);
+                }
+            });
+        }
+    }
+
+    // palette[i] = worlds[i] * inverse_binds[i] for every bone.
+    inline void buildSkinPalette(span<const mat4> worlds, span<const mat4> inverse_binds, SkinPalette& palette) {
+        palette.resize(worlds.size());
+        const mat4* w = worlds.data();
+        const mat4* ib = inverse_binds.data();
+        SkinPalette* out = &palette;
+        detail::batch_for(worlds.size(), [=](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                float m[16];
+                detail::mat4_mul(w[i].data(), ib[i].data(), m);
+                detail::mat4_transpose(m, out->data(i));
+            }
+        });
+    }
+
+    // Same as above with the world matrices of `nodes` in `h`, which has to be up to date (see
+    // TransformHierarchy::update).
+    inline void buildSkinPalette(const TransformHierarchy& h, span<const uint32_t> nodes, span<const mat4> inverse_binds, SkinPalette& palette) {
+        palette.resize(nodes.size());
+        const TransformHierarchy* th = &h;
+        const uint32_t* nd = nodes.data();
+        const mat4* ib = inverse_binds.data();
+        SkinPalette* out = &palette;
+        detail::batch_for(nodes.size(), [=](size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) {
+                float m[16];
+                detail::mat4_mul(th->world(nd[i]).data(), ib[i].data(), m);
+                detail::mat4_transpose(m, out->data(i));
+            }
+        });
+    }
+
+    // Skins `positions` into `out_positions`, which needs room for positions.size() vectors.
+    template <int K>
+    inline void skinVertices(const SkinPalette& palette, const SkinWeights<K>& weights, const Vec3Stream& positions,
+                             span<vec3> out_positions) {
+        vec3* op = out_positions.data();
+        detail::skin_vertices<K>(palette, weights, positions, nullptr, [=](size_t i, const float* p, const float*) {
+            op[i] = vec3(p[0], p[1], p[2]);
+        });
+    }
+
+    // Skins positions and normals, the normals come out normalized.
+    template <int K>
+    inline void skinVertices(const SkinPalette& palette, const SkinWeights<K>& weights, const Vec3Stream& positions,
+                             const Vec3Stream& normals, span<vec3> out_positions, span<vec3> out_normals) {
+        vec3* op = out_positions.data();
+        vec3* on = out_normals.data();
+        detail::skin_vertices<K>(palette, weights, positions, &normals, [=](size_t i, const float* p, const float* n) {
+            op[i] = vec3(p[0], p[1], p[2]);
+            on[i] = vec3(n[0], n[1], n[2]);
+        });
+    }
+
+    // The same with streams as the output, they get resized to positions.size().
+    template <int K>
+    inline void skinVertices(const SkinPalette& palette, const SkinWeights<K>& weights, const Vec3Stream& positions,
+                             Vec3Stream& out_positions) {
+        out_positions.resize(positions.size());
+        float *x = out_positions.x(), *y = out_positions.y(), *z = out_positions.z();
+        detail::skin_vertices<K>(palette, weights, positions, nullptr, [=](size_t i, const float* p, const float*) {
+            x[i] = p[0];
+            y[i] = p[1];
+            z[i] = p[2];
+        });
+    }
+
+    template <int K>
+    inline void skinVertices(const SkinPalette& palette, const SkinWeights<K>& weights, const Vec3Stream& positions,
+                             const Vec3Stream& normals, Vec3Stream& out_positions, Vec3Stream& out_normals) {
+        out_positions.resize(positions.size());
+        out_normals.resize(positions.size());
+        float *x = out_positions.x(), *y = out_positions.y(), *z = out_positions.z();
+        float *nx = out_normals.x(), *ny = out_normals.y(), *nz = out_normals.z();
+        detail::skin_vertices<K>(palette, weights, positions, &normals, [=](size_t i, const float* p, const float* n) {
+            x[i] = p[0];
+            y[i] = p[1];
+            z[i] = p[2];
+            nx[i] = n[0];
+            ny[i] = n[1];
+            nz[i] = n[2];
+        });
+    }
+}
+
+#endif /* LINA_SKIN_HPP */
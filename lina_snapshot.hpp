@@ -0,0 +1,199 @@
+#ifndef LINA_SNAPSHOT_HPP
+#define LINA_SNAPSHOT_HPP
+
+#include "lina.hpp"
+#include "lina_alloc.hpp"
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+/*
+
+###################
+ Transform Snapshots
+###################
+A 'TransformStore' hands an array of world matrices from one thread to
+another (the simulation thread to the render thread) without a lock and
+without copying the whole array every frame:
+
+    TransformStore store(instance_count);
+
+    // simulation thread
+    store.set(i, world);                 // or write(first, n) for a range
+    store.publish();
+
+    // render thread
+    span<const mat4> worlds = store.acquire();
+    draw(worlds);
+
+It keeps 3 copies of the array. The writer fills the back one, publish()
+swaps it with the middle one, and acquire() swaps the middle one with the
+front one if there's anything new in it. Both swaps are one atomic exchange,
+so neither thread ever waits for the other: the writer can publish as often
+as it wants, and the reader always gets the latest published frame (older
+ones that it never acquired are skipped).
+
+The span acquire() returns is only touched by the reader, so it stays valid
+(and doesn't change) until the next acquire(). If nothing was published since
+the last acquire() it's the same frame again, hasNew() tells you beforehand.
+
+================
+  Dirty Ranges
+================
+The back buffer the writer gets after publish() is a few frames old, so it
+has to be brought up to date before it's written to. Instead of copying the
+whole array, the store remembers which blocks of 64 matrices (4KB) each copy
+is missing, and publish() copies only those from the frame it just
+published. set() and write() mark their blocks, so a frame where 1% of the
+instances moved copies about 1% of the array.
+
+A few things to keep in mind:
+    - One thread writes and publishes, one thread acquires. For more writer
+      threads, have them write disjoint ranges and publish from one of them
+      once they're all done.
+    - back() and write() return the back buffer, only change the elements
+      you marked (write() marks the range it returns).
+    - resize() isn't thread safe, call it while nobody else uses the store.
+
+*/
+
+namespace lina {
+    struct TransformStore {
+        enum { BlockSize = 64 };
+
+        explicit TransformStore(size_t count = 0, const mat4& value = mat4()) : middle(1), back_index(0), front_index(2) {
+            resize(count, value);
+        }
+        TransformStore(const TransformStore&) = delete;
+        TransformStore& operator=(const TransformStore&) = delete;
+
+        // Sets every copy to `value` and forgets all dirty ranges.
+        void resize(size_t count, const mat4& value = mat4()) {
+            size_t blocks = (count + BlockSize - 1) / BlockSize;
+            for (int b = 0; b < 3; b++) {
+                buffers[b].assign(count, value);
+                frames[b] = 0;
+                missing[b].assign((blocks + 63) / 64, 0);
+            }
+            written = 0;
+            read_frame = 0;
+            middle.store(1, std::memory_order_relaxed);
+            back_index = 0;
+            front_index = 2;
+        }
+
+        size_t size() const noexcept { return buffers[0].size(); }
+
+        /*
+            Writer side
+        */
+        void set(size_t i, const mat4& m) noexcept {
+            mark(i, i + 1);
+            buffers[back_index][i] = m;
+        }
+
+        // Marks [first, first + n) as changed and returns it, to be filled in before publish().
+        span<mat4> write(size_t first, size_t n) noexcept {
+            mark(first, first + n);
+            return span<mat4>(buffers[back_index].data() + first, n);
+        }
+
+        // The whole back buffer, for reading what the writer wrote last. Changes have to be
+        // marked with write() or set().
+        span<mat4> back() noexcept { return span<mat4>(buffers[back_index]); }
+
+        // Makes everything written so far visible to acquire(), and brings the next back
+        // buffer up to date.
+        void publish() noexcept {
+            unsigned published = back_index;
+            frames[published] = ++written;
+            back_index = middle.exchange(published | fresh, std::memory_order_acq_rel) & index_mask;
+
+            // Only the writer changes buffers, so reading the published one while the
+            // reader reads it too is fine.
+            std::vector<uint64_t>& m = missing[back_index];
+            const mat4* from = buffers[published].data();
+            mat4* to = buffers[back_index].data();
+            size_t count = size();
+            for (size_t w = 0; w < m.size(); w++) {
+                for (uint64_t bits = m[w]; bits; bits &= bits - 1) {
+                    size_t block = w * 64 + lowest_bit(bits);
+                    size_t first = block * BlockSize;
+                    size_t n = count - first < (size_t)BlockSize ? count - first : (size_t)BlockSize;
+                    memcpy((void*)(to + first), from + first, n * sizeof(mat4));
+                }
+                m[w] = 0;
+            }
+        }
+
+        // The number of publish() calls so far.
+        uint64_t publishedFrames() const noexcept { return written; }
+
+        /*
+            Reader side
+        */
+        bool hasNew() const noexcept { return (middle.load(std::memory_order_relaxed) & fresh) != 0; }
+
+        // The latest published frame, valid until the next acquire().
+        span<const mat4> acquire() noexcept {
+            if (hasNew()) front_index = middle.exchange(front_index, std::memory_order_acq_rel) & index_mask;
+            read_frame = frames[front_index];
+            return span<const mat4>(buffers[front_index]);
+        }
+
+        // The number of the frame the last acquire() returned (what publishedFrames() was when
+        // it was published), 0 before anything was published.
+        uint64_t acquiredFrame() const noexcept { return read_frame; }
+
+    private:
+        enum : unsigned { index_mask = 3, fresh = 4 };
+
+        static unsigned lowest_bit(uint64_t v) noexcept {
+        #if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long i;
+            _BitScanForward64(&i, v);
+            return (unsigned)i;
+        #elif defined(_MSC_VER) && !defined(__clang__)
+            unsigned long i;
+            if (_BitScanForward(&i, (unsigned long)v)) return (unsigned)i;
+            _BitScanForward(&i, (unsigned long)(v >> 32));
+            return (unsigned)i + 32;
+        #else
+            return (unsigned)__builtin_ctzll(v);
+        #endif
+        }
+
+        // The other two copies are missing these blocks now.
+        void mark(size_t first, size_t end) noexcept {
+            if (first >= end) return;
+            size_t b = first / BlockSize, last = (end - 1) / BlockSize;
+            for (int i = 0; i < 3; i++) {
+                if (i == (int)back_index) continue;
+                std::vector<uint64_t>& m = missing[i];
+                for (size_t k = b; k <= last; k++) m[k / 64] |= (uint64_t)1 << (k % 64);
+            }
+        }
+
+        aligned_vector<mat4> buffers[3];
+        // The shared state gets its own cache line, away from what only one side touches.
+        char pad0[64];
+        std::atomic<unsigned> middle;  // the index of the middle buffer, | fresh if the reader hasn't seen it
+        char pad1[64];
+        // Writer
+        unsigned back_index;
+        uint64_t written;
+        uint64_t frames[3];
+        std::vector<uint64_t> missing[3];
+        char pad2[64];
+        // Reader
+        unsigned front_index;
+        uint64_t read_frame;
+    };
+}
+
+#endif /* LINA_SNAPSHOT_HPP */
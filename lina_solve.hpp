@@ -0,0 +1,478 @@
+#ifndef LINA_SOLVE_HPP
+#define LINA_SOLVE_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_task.hpp"
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+
+###################
+  Batched Solvers
+###################
+Determinants, inverses and linear solves for thousands of small matrices at
+once (constraint solvers, IK), with one matrix per SIMD lane so 4 or 8 of
+them are done per instruction (see 'SIMD' in lina.hpp).
+
+The matrices go in a 'Mat3Stream' or 'Mat4Stream', which is a vector stream
+(see 'Vector Streams' in lina_stream.hpp) with one array per element of the
+matrix: component(r, c) is the array of every matrix's element at row r,
+column c. Whole matrices go in and out with push_back(), get() and set().
+
+    Mat3Stream a;
+    Vec3Stream b, x;
+    for (...) { a.push_back(jacobian); b.push_back(rhs); }
+    std::vector<uint32_t> singular(solveMaskSize(a.size()));
+    solve(a, b, x, singular);    // a[i] * x[i] = b[i]
+
+    determinant:    the determinant of every matrix, into a FloatStream.
+    inverse:        the inverse of every matrix.
+    solve:          x[i] = a[i].inverse() * b[i], without building the inverse.
+    eigenSymmetric: the eigenvalues and eigenvectors of symmetric mat3s.
+    polarDecompose: a rotation and a stretch for every mat3.
+
+The outputs are resized to the size of the matrix stream, like with the
+stream operations. Big batches are split across threads (see 'Threading' in
+lina_batch.hpp).
+
+================
+  Singular Matrices
+================
+inverse and solve check every matrix before dividing by its determinant.
+One is near singular when
+    |determinant| < tolerance * |row 0| * |row 1| * ...
+The right side is the biggest the determinant can be for rows of those
+lengths, so this doesn't depend on the scale of the matrix, and a tolerance
+of 1e-6 (the default) catches the rows that are parallel to within about
+1e-6 radians. Matrices with inf or nan in them count as singular too.
+
+For those the result is all zeros instead of inf/nan, and bit (i % 32) of
+singular[i / 32] is set. 'singular' needs at least solveMaskSize(n) words (the
+bits after the last matrix are cleared). Leave it out if you don't care which
+ones they were.
+
+================
+  Eigen Decomposition
+================
+eigenSymmetric(a, values, vectors) finds the eigenvalues and eigenvectors of
+every symmetric matrix in a Mat3Stream (covariance matrices for fitting
+oriented boxes, inertia tensors), so that
+    a[i] = vectors[i] * diagonal(values[i]) * vectors[i].transposed()
+The eigenvectors are the columns of vectors[i], they're unit length and
+perpendicular to each other. The eigenvalues aren't sorted. Only the upper
+triangle of a[i] is read.
+
+It uses cyclic Jacobi rotations, each sweep zeroes the 3 elements above the
+diagonal once. The number of sweeps is fixed (the last argument, 4 by
+default, which gets float precision for anything but nearly equal
+eigenvalues), so every matrix costs the same.
+
+================
+  Polar Decomposition
+================
+polarDecompose(a, rotation, stretch) splits every matrix into a rotation and
+a symmetric stretch (shape matching for soft bodies, pulling the rotation out
+of a deformation gradient):
+    a[i] = rotation[i] * stretch[i]
+
+It runs a fixed number of scaled Newton iterations (8 by default), which is
+enough for stretches of 100000 to 1 in float precision. When a[i] is
+a reflection (a negative determinant), rotation[i] is still a rotation and
+the reflection ends up in stretch[i]. Near singular matrices (flattened to
+a plane or a line) don't have a rotation that's any better than another, they
+get zeros and a bit in 'singular' like with inverse and solve.
+
+*/
+
+namespace lina {
+    // A structure-of-arrays container of NxN matrices (see 'Batched Solvers').
+    template <int N>
+    struct MatStream {
+        static_assert(N == 3 || N == 4, "lina::MatStream is only for mat3 and mat4.");
+        typedef typename std::conditional<N == 3, mat3, mat4>::type value_type;
+
+        size_t size() const noexcept { return rows[0].size(); }
+        bool empty() const noexcept { return size() == 0; }
+
+        void reserve(size_t n) {
+            for (int r = 0; r < N; r++) rows[r].reserve(n);
+        }
+        // New matrices are zeroed.
+        void resize(size_t n) {
+            for (int r = 0; r < N; r++) rows[r].resize(n);
+        }
+        void clear() noexcept {
+            for (int r = 0; r < N; r++) rows[r].clear();
+        }
+
+        void push_back(const value_type& m) {
+            resize(size() + 1);
+            set(size() - 1, m);
+        }
+
+        value_type get(size_t i) const noexcept {
+            value_type m;
+            float* p = m.data();
+            for (int r = 0; r < N; r++)
+                for (int c = 0; c < N; c++) p[r * N + c] = rows[r].component(c)[i];
+            return m;
+        }
+
+        void set(size_t i, const value_type& m) noexcept {
+            const float* p = m.data();
+            for (int r = 0; r < N; r++)
+                for (int c = 0; c < N; c++) rows[r].component(c)[i] = p[r * N + c];
+        }
+
+        float* component(int r, int c) noexcept { return rows[r].component(c); }
+        const float* component(int r, int c) const noexcept { return rows[r].component(c); }
+
+        // Row r of every matrix as a vector stream.
+        VecStream<N>& row(int r) noexcept { return rows[r]; }
+        const VecStream<N>& row(int r) const noexcept { return rows[r]; }
+
+    private:
+        VecStream<N> rows[N];
+    };
+
+    typedef MatStream<3> Mat3Stream;
+    typedef MatStream<4> Mat4Stream;
+
+    inline constexpr size_t solveMaskSize(size_t n) noexcept {
+        return (n + 31) / 32;
+    }
+
+    namespace detail {
+        // Like stream_kernel, but f also returns a bitmask of the lanes that are singular. Their
+        // outputs are zeroed and their bits go into mask (when it isn't null), which gets whole
+        // words from begin to end.
+        template <int NI, int NO, typename F>
+        inline void solve_kernel(const float* const* in, float* const* out, uint32_t* mask, size_t begin, size_t end, F f) noexcept {
+            for (size_t w0 = begin; w0 < end; w0 += 32) {
+                size_t we = end - w0 < 32 ? end : w0 + 32;
+                uint32_t word = 0;
+                for (size_t i = w0; i < we; i += floatv_width) {
+                    size_t left = we - i < (size_t)floatv_width ? we - i : (size_t)floatv_width;
+                    floatv a[NI], r[NO];
+                    unsigned bad;
+                    if (left == (size_t)floatv_width) {
+                        for (int k = 0; k < NI; k++) a[k] = loadv(in[k] + i);
+                        bad = f(a, r);
+                        for (int k = 0; k < NO; k++) storev(out[k] + i, r[k]);
+                    } else {
+                        float tmp[NI > NO ? NI : NO][floatv_width];
+                        for (int k = 0; k < NI; k++) {
+                            for (size_t j = 0; j < (size_t)floatv_width; j++) tmp[k][j] = j < left ? in[k][i + j] : 1.f;
+                            a[k] = loadv(tmp[k]);
+                        }
+                        bad = f(a, r) & ((1u << left) - 1u);
+                        for (int k = 0; k < NO; k++) {
+                            storev(tmp[k], r[k]);
+                            memcpy(out[k] + i, tmp[k], left * sizeof(float));
+                        }
+                    }
+                    for (unsigned b = bad; b; b &= b - 1) {
+                        size_t lane = i;
+                        for (unsigned t = b; !(t & 1u); t >>= 1) lane++;
+                        for (int k = 0; k < NO; k++) out[k][lane] = 0.f;
+                    }
+                    word |= (uint32_t)bad << (i - w0);
+                }
+                if (mask) mask[w0 / 32] = word;
+            }
+        }
+
+        // The lanes where |det| < tolerance * (product of the row lengths), or that aren't finite.
+        template <int N>
+        inline unsigned singular_lanes(const floatv* m, floatv det, floatv tolerance) noexcept {
+            floatv bound = tolerance;
+            for (int r = 0; r < N; r++) {
+                const floatv* row = m + r * N;
+                floatv len2 = row[0] * row[0];
+                for (int c = 1; c < N; c++) len2 = maddv(row[c], row[c], len2);
+                bound = bound * sqrtv(len2);
+            }
+            floatv a = absv(det);
+            const unsigned all = (1u << floatv_width) - 1u;
+            return ~(gemaskv(a, bound) & gemaskv(a, setv(FLT_MIN)) & gemaskv(setv(FLT_MAX), a)) & all;
+        }
+
+        // The cofactors of a 3x3 matrix, c[r * 3 + k] belongs to element (r, k), and its determinant.
+        inline floatv cofactors3(const floatv* m, floatv* c) noexcept {
+            c[0] = m[4] * m[8] - m[5] * m[7];
+            c[1] = m[5] * m[6] - m[3] * m[8];
+            c[2] = m[3] * m[7] - m[4] * m[6];
+            c[3] = m[7] * m[2] - m[8] * m[1];
+            c[4] = m[8] * m[0] - m[6] * m[2];
+            c[5] = m[6] * m[1] - m[7] * m[0];
+            c[6] = m[1] * m[5] - m[2] * m[4];
+            c[7] = m[2] * m[3] - m[0] * m[5];
+            c[8] = m[0] * m[4] - m[1] * m[3];
+            return maddv(m[2], c[2], maddv(m[1], c[1], m[0] * c[0]));
+        }
+
+        // The adjugate of a 4x4 matrix (the inverse times the determinant), same formulas as
+        // mat4_inverse_scalar, and the determinant.
+        inline floatv adjugate4(const floatv* m, floatv* t) noexcept {
+            floatv s0 = m[0] * m[5] - m[4] * m[1];
+            floatv s1 = m[0] * m[6] - m[4] * m[2];
+            floatv s2 = m[0] * m[7] - m[4] * m[3];
+            floatv s3 = m[1] * m[6] - m[5] * m[2];
+            floatv s4 = m[1] * m[7] - m[5] * m[3];
+            floatv s5 = m[2] * m[7] - m[6] * m[3];
+            floatv c5 = m[10] * m[15] - m[14] * m[11];
+            floatv c4 = m[9] * m[15] - m[13] * m[11];
+            floatv c3 = m[9] * m[14] - m[13] * m[10];
+            floatv c2 = m[8] * m[15] - m[12] * m[11];
+            floatv c1 = m[8] * m[14] - m[12] * m[10];
+            floatv c0 = m[8] * m[13] - m[12] * m[9];
+            if (t) {
+                t[0] = m[5] * c5 - m[6] * c4 + m[7] * c3;
+                t[1] = m[2] * c4 - m[1] * c5 - m[3] * c3;
+                t[2] = m[13] * s5 - m[14] * s4 + m[15] * s3;
+                t[3] = m[10] * s4 - m[9] * s5 - m[11] * s3;
+                t[4] = m[6] * c2 - m[4] * c5 - m[7] * c1;
+                t[5] = m[0] * c5 - m[2] * c2 + m[3] * c1;
+                t[6] = m[14] * s2 - m[12] * s5 - m[15] * s1;
+                t[7] = m[8] * s5 - m[10] * s2 + m[11] * s1;
+                t[8] = m[4] * c4 - m[5] * c2 + m[7] * c0;
+                t[9] = m[1] * c2 - m[0] * c4 - m[3] * c0;
+                t[10] = m[12] * s4 - m[13] * s2 + m[15] * s0;
+                t[11] = m[9] * s2 - m[8] * s4 - m[11] * s0;
+                t[12] = m[5] * c1 - m[4] * c3 - m[6] * c0;
+                t[13] = m[0] * c3 - m[1] * c1 + m[2] * c0;
+                t[14] = m[13] * s1 - m[12] * s3 - m[14] * s0;
+                t[15] = m[8] * s3 - m[9] * s1 + m[10] * s0;
+            }
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        }
+
+        template <int N>
+        inline void mat_stream_inputs(const MatStream<N>& m, const float** in) noexcept {
+            for (int r = 0; r < N; r++)
+                for (int c = 0; c < N; c++) in[r * N + c] = m.component(r, c);
+        }
+
+        // One Jacobi rotation of the symmetric matrix a (a[p][q] in apq and so on) in the (p, q)
+        // plane that zeroes a[p][q], r is the third row/column. v gets the rotation too.
+        inline void jacobi_rotate(floatv& app, floatv& aqq, floatv& apq, floatv& arp, floatv& arq, floatv* v, int p, int q) noexcept {
+            // Rounds away what's below the precision of the diagonal. Left alone, apq keeps shrinking
+            // once it has converged, into denormals, and those make every sweep after that several
+            // times slower.
+            floatv scale = absv(app) + absv(aqq);
+            apq = (apq + scale) - scale;
+            // t = tan of the rotation angle, written without dividing by apq so apq == 0 gives t = 0.
+            floatv tau = aqq - app;
+            floatv t = copysignv(setv(2.f), tau) * apq / (absv(tau) + sqrtv(maddv(tau, tau, setv(4.f) * apq * apq)) + setv(FLT_MIN));
+            floatv c = setv(1.f) / sqrtv(maddv(t, t, setv(1.f)));
+            floatv sn = t * c;
+            app = app - t * apq;
+            aqq = maddv(t, apq, aqq);
+            apq = setv(0.f);
+            floatv rp = arp, rq = arq;
+            arp = c * rp - sn * rq;
+            arq = maddv(sn, rp, c * rq);
+            for (int r = 0; r < 3; r++) {
+                floatv vp = v[r * 3 + p], vq = v[r * 3 + q];
+                v[r * 3 + p] = c * vp - sn * vq;
+                v[r * 3 + q] = maddv(sn, vp, c * vq);
+            }
+        }
+
+        // a is the upper triangle (00, 01, 02, 11, 12, 22), the eigenvalues go in d and the
+        // eigenvectors in the columns of v.
+        inline void eigen_symmetric3(const floatv* a, floatv* d, floatv* v, int sweeps) noexcept {
+            floatv a00 = a[0], a01 = a[1], a02 = a[2], a11 = a[3], a12 = a[4], a22 = a[5];
+            for (int i = 0; i < 9; i++) v[i] = setv(i % 4 == 0 ? 1.f : 0.f);
+            for (int s = 0; s < sweeps; s++) {
+                jacobi_rotate(a00, a11, a01, a02, a12, v, 0, 1);
+                jacobi_rotate(a00, a22, a02, a01, a12, v, 0, 2);
+                jacobi_rotate(a11, a22, a12, a01, a02, v, 1, 2);
+            }
+            d[0] = a00;
+            d[1] = a11;
+            d[2] = a22;
+        }
+
+        // Scaled Newton iterations, r = (g * r + r^-T / g) / 2, starting from a with the sign of its
+        // determinant so that r ends up a rotation. s = r^T a.
+        inline floatv polar3(const floatv* a, floatv* r, floatv* s, int iterations) noexcept {
+            floatv c[9];
+            floatv det = cofactors3(a, c);
+            floatv sign = copysignv(setv(1.f), det);
+            for (int i = 0; i < 9; i++) r[i] = a[i] * sign;
+            for (int it = 0; it < iterations; it++) {
+                floatv inv = setv(1.f) / cofactors3(r, c);
+                floatv nr = r[0] * r[0], nc = c[0] * c[0];
+                for (int i = 1; i < 9; i++) {
+                    nr = maddv(r[i], r[i], nr);
+                    nc = maddv(c[i], c[i], nc);
+                }
+                // g = sqrt(|r^-1| / |r|) with Frobenius norms, |r^-1| = |c| * |inv|.
+                floatv g = sqrtv(sqrtv(nc * inv * inv / nr));
+                floatv h = setv(0.5f) * inv / g, gh = setv(0.5f) * g;
+                for (int i = 0; i < 9; i++) r[i] = maddv(gh, r[i], h * c[i]);
+            }
+            for (int i = 0; i < 3; i++)
+                for (int k = 0; k < 3; k++)
+                    s[i * 3 + k] = maddv(r[6 + i], a[6 + k], maddv(r[3 + i], a[3 + k], r[i] * a[k]));
+            // Symmetric up to rounding, this makes it exactly symmetric.
+            for (int i = 0; i < 3; i++)
+                for (int k = i + 1; k < 3; k++) s[i * 3 + k] = s[k * 3 + i] = setv(0.5f) * (s[i * 3 + k] + s[k * 3 + i]);
+            return det;
+        }
+
+        template <int NI, int NO, typename F>
+        inline void solve_for(size_t n, const float* const* in, float* const* out, span<uint32_t> singular, F f) {
+            uint32_t* mask = singular.empty() ? nullptr : singular.data();
+            // Whole words of the mask per task.
+            batch_for(n, [=](size_t b, size_t e) { solve_kernel<NI, NO>(in, out, mask, b, e, f); }, 32);
+        }
+    }
+
+    // out[i] = m[i].determinant()
+    inline void determinant(const Mat3Stream& m, FloatStream& out) {
+        out.resize(m.size());
+        const float* in[9];
+        detail::mat_stream_inputs(m, in);
+        float* ox = out.x();
+        detail::batch_for(m.size(), [&](size_t b, size_t e) {
+            const float* ib[9];
+            for (int k = 0; k < 9; k++) ib[k] = in[k] + b;
+            float* o[1] = {ox + b};
+            detail::stream_kernel<9, 1>(ib, o, e - b, [](const detail::floatv* v, detail::floatv* r) {
+                detail::floatv c[9];
+                r[0] = detail::cofactors3(v, c);
+            });
+        }, detail::stream_task_align);
+    }
+
+    inline void determinant(const Mat4Stream& m, FloatStream& out) {
+        out.resize(m.size());
+        const float* in[16];
+        detail::mat_stream_inputs(m, in);
+        float* ox = out.x();
+        detail::batch_for(m.size(), [&](size_t b, size_t e) {
+            const float* ib[16];
+            for (int k = 0; k < 16; k++) ib[k] = in[k] + b;
+            float* o[1] = {ox + b};
+            detail::stream_kernel<16, 1>(ib, o, e - b, [](const detail::floatv* v, detail::floatv* r) {
+                r[0] = detail::adjugate4(v, nullptr);
+            });
+        }, detail::stream_task_align);
+    }
+
+    // out[i] = m[i].inverse(), zeros for the near singular ones (see 'Singular Matrices').
+    inline void inverse(const Mat3Stream& m, Mat3Stream& out, span<uint32_t> singular = span<uint32_t>(), float tolerance = 1e-6f) {
+        out.resize(m.size());
+        const float* in[9];
+        float* o[9];
+        detail::mat_stream_inputs(m, in);
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 3; c++) o[r * 3 + c] = out.component(r, c);
+        detail::solve_for<9, 9>(m.size(), in, o, singular, [=](const detail::floatv* v, detail::floatv* r) {
+            detail::floatv c[9];
+            detail::floatv det = detail::cofactors3(v, c);
+            detail::floatv inv = detail::setv(1.f) / det;
+            // The inverse is the transposed cofactor matrix over the determinant.
+            for (int i = 0; i < 3; i++)
+                for (int k = 0; k < 3; k++) r[i * 3 + k] = c[k * 3 + i] * inv;
+            return detail::singular_lanes<3>(v, det, detail::setv(tolerance));
+        });
+    }
+
+    inline void inverse(const Mat4Stream& m, Mat4Stream& out, span<uint32_t> singular = span<uint32_t>(), float tolerance = 1e-6f) {
+        out.resize(m.size());
+        const float* in[16];
+        float* o[16];
+        detail::mat_stream_inputs(m, in);
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++) o[r * 4 + c] = out.component(r, c);
+        detail::solve_for<16, 16>(m.size(), in, o, singular, [=](const detail::floatv* v, detail::floatv* r) {
+            detail::floatv det = detail::adjugate4(v, r);
+            detail::floatv inv = detail::setv(1.f) / det;
+            for (int i = 0; i < 16; i++) r[i] = r[i] * inv;
+            return detail::singular_lanes<4>(v, det, detail::setv(tolerance));
+        });
+    }
+
+    // a[i] * x[i] = b[i], zeros for the near singular ones (see 'Singular Matrices').
+    inline void solve(const Mat3Stream& a, const Vec3Stream& b, Vec3Stream& x, span<uint32_t> singular = span<uint32_t>(), float tolerance = 1e-6f) {
+        x.resize(a.size());
+        const float* in[12];
+        detail::mat_stream_inputs(a, in);
+        for (int k = 0; k < 3; k++) in[9 + k] = b.component(k);
+        float* o[3] = {x.x(), x.y(), x.z()};
+        detail::solve_for<12, 3>(a.size(), in, o, singular, [=](const detail::floatv* v, detail::floatv* r) {
+            detail::floatv c[9];
+            detail::floatv det = detail::cofactors3(v, c);
+            detail::floatv inv = detail::setv(1.f) / det;
+            const detail::floatv* rhs = v + 9;
+            for (int i = 0; i < 3; i++)
+                r[i] = detail::maddv(c[6 + i], rhs[2], detail::maddv(c[3 + i], rhs[1], c[i] * rhs[0])) * inv;
+            return detail::singular_lanes<3>(v, det, detail::setv(tolerance));
+        });
+    }
+
+    inline void solve(const Mat4Stream& a, const Vec4Stream& b, Vec4Stream& x, span<uint32_t> singular = span<uint32_t>(), float tolerance = 1e-6f) {
+        x.resize(a.size());
+        const float* in[20];
+        detail::mat_stream_inputs(a, in);
+        for (int k = 0; k < 4; k++) in[16 + k] = b.component(k);
+        float* o[4] = {x.x(), x.y(), x.z(), x.w()};
+        detail::solve_for<20, 4>(a.size(), in, o, singular, [=](const detail::floatv* v, detail::floatv* r) {
+            detail::floatv t[16];
+            detail::floatv det = detail::adjugate4(v, t);
+            detail::floatv inv = detail::setv(1.f) / det;
+            const detail::floatv* rhs = v + 16;
+            for (int i = 0; i < 4; i++)
+                r[i] = detail::maddv(t[i * 4 + 3], rhs[3], detail::maddv(t[i * 4 + 2], rhs[2],
+                       detail::maddv(t[i * 4 + 1], rhs[1], t[i * 4] * rhs[0]))) * inv;
+            return detail::singular_lanes<4>(v, det, detail::setv(tolerance));
+        });
+    }
+
+    // a[i] = vectors[i] * diagonal(values[i]) * vectors[i].transposed() for symmetric a[i], see
+    // 'Eigen Decomposition'.
+    inline void eigenSymmetric(const Mat3Stream& a, Vec3Stream& values, Mat3Stream& vectors, int sweeps = 4) {
+        values.resize(a.size());
+        vectors.resize(a.size());
+        const float* in[6] = {a.component(0, 0), a.component(0, 1), a.component(0, 2), a.component(1, 1), a.component(1, 2), a.component(2, 2)};
+        float* out[12] = {values.x(), values.y(), values.z()};
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 3; c++) out[3 + r * 3 + c] = vectors.component(r, c);
+        detail::batch_for(a.size(), [&](size_t b, size_t e) {
+            const float* ib[6];
+            float* ob[12];
+            for (int k = 0; k < 6; k++) ib[k] = in[k] + b;
+            for (int k = 0; k < 12; k++) ob[k] = out[k] + b;
+            detail::stream_kernel<6, 12>(ib, ob, e - b, [=](const detail::floatv* v, detail::floatv* r) {
+                detail::eigen_symmetric3(v, r, r + 3, sweeps);
+            });
+        }, detail::stream_task_align);
+    }
+
+    // a[i] = rotation[i] * stretch[i], see 'Polar Decomposition'.
+    inline void polarDecompose(const Mat3Stream& a, Mat3Stream& rotation, Mat3Stream& stretch, span<uint32_t> singular = span<uint32_t>(),
+                               int iterations = 8, float tolerance = 1e-6f) {
+        rotation.resize(a.size());
+        stretch.resize(a.size());
+        const float* in[9];
+        float* o[18];
+        detail::mat_stream_inputs(a, in);
+        for (int r = 0; r < 3; r++)
+            for (int c = 0; c < 3; c++) {
+                o[r * 3 + c] = rotation.component(r, c);
+                o[9 + r * 3 + c] = stretch.component(r, c);
+            }
+        detail::solve_for<9, 18>(a.size(), in, o, singular, [=](const detail::floatv* v, detail::floatv* r) {
+            detail::floatv det = detail::polar3(v, r, r + 9, iterations);
+            return detail::singular_lanes<3>(v, det, detail::setv(tolerance));
+        });
+    }
+}
+
+#endif /* LINA_SOLVE_HPP */
@@ -0,0 +1,691 @@
+#ifndef LINA_STREAM_HPP
+#define LINA_STREAM_HPP
+
+#include "lina.hpp"
+#include "lina_task.hpp"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+/*
+
+###################
+  Vector Streams
+###################
+A vector stream holds a lot of vectors in structure-of-arrays form, so instead
+of storing x, y, z, x, y, z, ... like an array of vec3 does, it stores every x
+in one array, every y in another array and every z in a third one. That way a
+single SIMD instruction can work on 4 or 8 vectors at once, which is what you
+want when you're going through a million particles.
+
+There are 4 stream types:
+    FloatStream: just floats, the output of 'dot' and 'length'.
+    Vec2Stream:  x and y arrays.
+    Vec3Stream:  x, y and z arrays.
+    Vec4Stream:  x, y, z and w arrays.
+
+Every component array starts on a LINA_STREAM_ALIGNMENT (64 by default) byte
+boundary. You can get at the arrays directly with x(), y(), z() and w(), or
+read and write whole vectors with get() and set().
+
+To go from an array of Vector2/3/4 to a stream and back use 'gather' and
+'scatter', they work with every Vector type and convert to and from float.
+
+================
+  Operations
+================
+All the bulk operations are free functions that write into an output stream,
+the output is resized to the size of the first input and it's fine for it to
+be one of the inputs. Both inputs should be the same size. Big streams are
+split across threads like the batch transforms (see 'Threading' in
+lina_batch.hpp).
+    add, sub, mul, div: component-wise with another stream or with a scalar.
+    dot:                the dot product of every pair of vectors, into a FloatStream.
+    cross:              the cross product of every pair of vectors (Vec3Stream only).
+    length:             the length of every vector, into a FloatStream.
+    normalize:          every vector divided by its length.
+    lerp:               a + (b - a) * t for every pair of vectors.
+
+div, length and normalize take a precision policy, normalize<fast>(a, out)
+(see 'Precision Policies' in lina.hpp).
+
+================
+  Expression Templates
+================
+With LINA_EXPR defined (see 'Expression Templates' in lina.hpp) the streams
+also get +, -, * and /, which work with other streams of the same type, floats
+and single vectors (which get applied to every element):
+    Vec3Stream r = a * 2.f + b * 3.f - a * b + vec3(0, 1, 0);
+All of that is done in one pass over the arrays, 4 or 8 elements at a time,
+without the temporary streams you'd need with the functions above, so it only
+reads a and b once and writes r once. The output is resized like with the
+functions above and can be one of the inputs.
+
+*/
+
+#ifndef LINA_STREAM_ALIGNMENT
+    #define LINA_STREAM_ALIGNMENT 64
+#endif
+
+namespace lina {
+    namespace detail {
+        inline void* aligned_malloc(size_t size, size_t alignment) {
+        #if defined(_MSC_VER)
+            void* p = _aligned_malloc(size, alignment);
+        #else
+            void* p = nullptr;
+            if (posix_memalign(&p, alignment, size) != 0) p = nullptr;
+        #endif
+            if (!p) throw std::bad_alloc();
+            return p;
+        }
+
+        inline void aligned_free(void* p) noexcept {
+        #if defined(_MSC_VER)
+            _aligned_free(p);
+        #else
+            free(p);
+        #endif
+        }
+
+        // Runs `f` over `n` elements of NI input arrays and NO output arrays, floatv_width elements
+        // at a time. The elements that don't fill a whole floatv go through a zero padded copy.
+        template <int NI, int NO, typename F>
+        inline void stream_kernel(const float* const* in, float* const* out, size_t n, F f) noexcept {
+            size_t i = 0;
+            for (; i + floatv_width <= n; i += floatv_width) {
+                floatv a[NI], r[NO];
+                for (int k = 0; k < NI; k++) a[k] = loadv(in[k] + i);
+                f(a, r);
+                for (int k = 0; k < NO; k++) storev(out[k] + i, r[k]);
+            }
+            if (i < n) {
+                size_t rest = n - i;
+                float ta[NI][floatv_width] = {}, tr[NO][floatv_width];
+                floatv a[NI], r[NO];
+                for (int k = 0; k < NI; k++) {
+                    memcpy(ta[k], in[k] + i, rest * sizeof(float));
+                    a[k] = loadv(ta[k]);
+                }
+                f(a, r);
+                for (int k = 0; k < NO; k++) {
+                    storev(tr[k], r[k]);
+                    memcpy(out[k] + i, tr[k], rest * sizeof(float));
+                }
+            }
+        }
+
+        template <int N> struct stream_value;
+        template <> struct stream_value<1> { typedef float type; };
+        template <> struct stream_value<2> { typedef vec2 type; };
+        template <> struct stream_value<3> { typedef vec3 type; };
+        template <> struct stream_value<4> { typedef vec4 type; };
+
+        inline void deinterleave3(const float* src, float* x, float* y, float* z, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; i + 4 <= n; i += 4) {
+                __m128 v0 = _mm_loadu_ps(src + i*3);     // x0 y0 z0 x1
+                __m128 v1 = _mm_loadu_ps(src + i*3 + 4); // y1 z1 x2 y2
+                __m128 v2 = _mm_loadu_ps(src + i*3 + 8); // z2 x3 y3 z3
+                __m128 tx = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 1, 0, 2));
+                __m128 ty0 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 0, 1));
+                __m128 ty1 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 2, 0, 3));
+                __m128 tz0 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 1, 0, 2));
+                __m128 tz1 = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(0, 3, 0, 0));
+                _mm_storeu_ps(x + i, _mm_shuffle_ps(v0, tx, _MM_SHUFFLE(2, 0, 3, 0)));
+                _mm_storeu_ps(y + i, _mm_shuffle_ps(ty0, ty1, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(z + i, _mm_shuffle_ps(tz0, tz1, _MM_SHUFFLE(2, 0, 2, 0)));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; i + 4 <= n; i += 4) {
+                float32x4x3_t v = vld3q_f32(src + i*3);
+                vst1q_f32(x + i, v.val[0]);
+                vst1q_f32(y + i, v.val[1]);
+                vst1q_f32(z + i, v.val[2]);
+            }
+        #endif
+            for (; i < n; i++) {
+                x[i] = src[i*3]; y[i] = src[i*3 + 1]; z[i] = src[i*3 + 2];
+            }
+        }
+
+        inline void interleave3(const float* x, const float* y, const float* z, float* dst, size_t n) noexcept {
+            size_t i = 0;
+        #if LINA_SIMD_X86
+            for (; i + 4 <= n; i += 4) {
+                __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+                __m128 a0 = _mm_shuffle_ps(vx, vy, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 b0 = _mm_shuffle_ps(vz, vx, _MM_SHUFFLE(1, 1, 0, 0));
+                __m128 a1 = _mm_shuffle_ps(vy, vz, _MM_SHUFFLE(1, 1, 1, 1));
+                __m128 b1 = _mm_shuffle_ps(vx, vy, _MM_SHUFFLE(2, 2, 2, 2));
+                __m128 a2 = _mm_shuffle_ps(vz, vx, _MM_SHUFFLE(3, 3, 2, 2));
+                __m128 b2 = _mm_shuffle_ps(vy, vz, _MM_SHUFFLE(3, 3, 3, 3));
+                _mm_storeu_ps(dst + i*3,     _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(dst + i*3 + 4, _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(dst + i*3 + 8, _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0)));
+            }
+        #elif LINA_SIMD == LINA_SIMD_NEON
+            for (; i + 4 <= n; i += 4) {
+                float32x4x3_t v;
+                v.val[0] = vld1q_f32(x + i); v.val[1] = vld1q_f32(y + i); v.val[2] = vld1q_f32(z + i);
+                vst3q_f32(dst + i*3, v);
+            }
+        #endif
+            for (; i < n; i++) {
+                dst[i*3] = x[i]; dst[i*3 + 1] = y[i]; dst[i*3 + 2] = z[i];
+            }
+        }
+    }
+
+#ifdef LINA_EXPR
+    namespace expr {
+        // Every stream expression node derives from this.
+        struct stream_tag {};
+        template <typename E>
+        struct is_stream_node : std::is_base_of<stream_tag, E> {};
+    }
+#endif
+
+    // A structure-of-arrays container of N component float vectors (see 'Vector Streams').
+    template <int N>
+    struct VecStream {
+        static_assert(N >= 1 && N <= 4, "lina::VecStream only has 1 to 4 components.");
+        typedef typename detail::stream_value<N>::type value_type;
+
+        VecStream() noexcept : block(nullptr), count(0), cap(0) {
+            for (int k = 0; k < N; k++) comp[k] = nullptr;
+        }
+        explicit VecStream(size_t n) : VecStream() {
+            resize(n);
+        }
+        VecStream(const VecStream& o) : VecStream() {
+            *this = o;
+        }
+        VecStream(VecStream&& o) noexcept : VecStream() {
+            swap(o);
+        }
+        ~VecStream() {
+            detail::aligned_free(block);
+        }
+
+        VecStream& operator=(const VecStream& o) {
+            if (this != &o) {
+                resize(o.count);
+                for (int k = 0; k < N; k++)
+                    if (count) memcpy(comp[k], o.comp[k], count * sizeof(float));
+            }
+            return *this;
+        }
+        VecStream& operator=(VecStream&& o) noexcept {
+            swap(o);
+            return *this;
+        }
+
+    #ifdef LINA_EXPR
+        // Evaluates a stream expression in one pass (see 'Expression Templates' below).
+        template <typename E, typename = typename std::enable_if<expr::is_stream_node<E>::value>::type>
+        VecStream(const E& e) : VecStream() {
+            *this = e;
+        }
+        template <typename E, typename = typename std::enable_if<expr::is_stream_node<E>::value>::type>
+        VecStream& operator=(const E& e) {
+            static_assert(E::size == N, "lina: the expression doesn't have as many components as the stream.");
+            size_t n = e.count();
+            resize(n);
+            for (int k = 0; k < N; k++) {
+                float* o = comp[k];
+                size_t i = 0;
+                for (; i + detail::floatv_width <= n; i += detail::floatv_width) detail::storev(o + i, e.load(k, i));
+                if (i < n) {
+                    float t[detail::floatv_width];
+                    detail::storev(t, e.load(k, i, n - i));
+                    memcpy(o + i, t, (n - i) * sizeof(float));
+                }
+            }
+            return *this;
+        }
+    #endif
+
+        void swap(VecStream& o) noexcept {
+            void* b = block; block = o.block; o.block = b;
+            size_t c = count; count = o.count; o.count = c;
+            c = cap; cap = o.cap; o.cap = c;
+            for (int k = 0; k < N; k++) {
+                float* p = comp[k]; comp[k] = o.comp[k]; o.comp[k] = p;
+            }
+        }
+
+        size_t size() const noexcept { return count; }
+        size_t capacity() const noexcept { return cap; }
+        bool empty() const noexcept { return count == 0; }
+
+        // Makes room for at least `n` vectors without changing the size.
+        void reserve(size_t n) {
+            if (n <= cap) return;
+            const size_t per_line = LINA_STREAM_ALIGNMENT / sizeof(float);
+            size_t stride = (n + per_line - 1) / per_line * per_line;
+            void* nb = detail::aligned_malloc(stride * N * sizeof(float), LINA_STREAM_ALIGNMENT);
+            float* base = (float*)nb;
+            for (int k = 0; k < N; k++) {
+                if (count) memcpy(base + stride*k, comp[k], count * sizeof(float));
+                comp[k] = base + stride*k;
+            }
+            detail::aligned_free(block);
+            block = nb;
+            cap = stride;
+        }
+
+        // Changes the size to `n` vectors, new vectors are zeroed.
+        void resize(size_t n) {
+            reserve(n);
+            if (n > count)
+                for (int k = 0; k < N; k++) memset(comp[k] + count, 0, (n - count) * sizeof(float));
+            count = n;
+        }
+
+        void clear() noexcept { count = 0; }
+
+        void push_back(value_type v) {
+            if (count == cap) reserve(cap ? cap * 2 : LINA_STREAM_ALIGNMENT / sizeof(float));
+            count++;
+            set(count - 1, v);
+        }
+
+        float* component(int k) noexcept { return comp[k]; }
+        const float* component(int k) const noexcept { return comp[k]; }
+
+        float* x() noexcept { return comp[0]; }
+        const float* x() const noexcept { return comp[0]; }
+        float* y() noexcept { static_assert(N >= 2, "this stream has no y component."); return comp[1]; }
+        const float* y() const noexcept { static_assert(N >= 2, "this stream has no y component."); return comp[1]; }
+        float* z() noexcept { static_assert(N >= 3, "this stream has no z component."); return comp[2]; }
+        const float* z() const noexcept { static_assert(N >= 3, "this stream has no z component."); return comp[2]; }
+        float* w() noexcept { static_assert(N >= 4, "this stream has no w component."); return comp[3]; }
+        const float* w() const noexcept { static_assert(N >= 4, "this stream has no w component."); return comp[3]; }
+
+        value_type get(size_t i) const noexcept {
+            value_type v;
+            float* p = (float*)&v;
+            for (int k = 0; k < N; k++) p[k] = comp[k][i];
+            return v;
+        }
+
+        void set(size_t i, value_type v) noexcept {
+            const float* p = (const float*)&v;
+            for (int k = 0; k < N; k++) comp[k][i] = p[k];
+        }
+
+        // Copies `n` vectors from an array of Vector2/3/4 into this stream, the stream is resized to `n`.
+        template <typename T>
+        void gather(const Vector2<T>* src, size_t n) {
+            static_assert(N == 2, "gather from Vector2 needs a Vec2Stream.");
+            resize(n);
+            for (size_t i = 0; i < n; i++) {
+                comp[0][i] = (float)src[i].x; comp[1][i] = (float)src[i].y;
+            }
+        }
+        template <typename T>
+        void gather(const Vector3<T>* src, size_t n) {
+            static_assert(N == 3, "gather from Vector3 needs a Vec3Stream.");
+            resize(n);
+            if (std::is_same<T, float>::value) {
+                detail::deinterleave3((const float*)src, comp[0], comp[1], comp[2], n);
+                return;
+            }
+            for (size_t i = 0; i < n; i++) {
+                comp[0][i] = (float)src[i].x; comp[1][i] = (float)src[i].y; comp[2][i] = (float)src[i].z;
+            }
+        }
+        template <typename T>
+        void gather(const Vector4<T>* src, size_t n) {
+            static_assert(N == 4, "gather from Vector4 needs a Vec4Stream.");
+            resize(n);
+            for (size_t i = 0; i < n; i++) {
+                comp[0][i] = (float)src[i].x; comp[1][i] = (float)src[i].y;
+                comp[2][i] = (float)src[i].z; comp[3][i] = (float)src[i].w;
+            }
+        }
+
+        // Copies every vector in this stream into `dst`, which needs room for size() vectors.
+        template <typename T>
+        void scatter(Vector2<T>* dst) const {
+            static_assert(N == 2, "scatter to Vector2 needs a Vec2Stream.");
+            for (size_t i = 0; i < count; i++) {
+                dst[i].x = (T)comp[0][i]; dst[i].y = (T)comp[1][i];
+            }
+        }
+        template <typename T>
+        void scatter(Vector3<T>* dst) const {
+            static_assert(N == 3, "scatter to Vector3 needs a Vec3Stream.");
+            if (std::is_same<T, float>::value) {
+                detail::interleave3(comp[0], comp[1], comp[2], (float*)dst, count);
+                return;
+            }
+            for (size_t i = 0; i < count; i++) {
+                dst[i].x = (T)comp[0][i]; dst[i].y = (T)comp[1][i]; dst[i].z = (T)comp[2][i];
+            }
+        }
+        template <typename T>
+        void scatter(Vector4<T>* dst) const {
+            static_assert(N == 4, "scatter to Vector4 needs a Vec4Stream.");
+            for (size_t i = 0; i < count; i++) {
+                dst[i].x = (T)comp[0][i]; dst[i].y = (T)comp[1][i];
+                dst[i].z = (T)comp[2][i]; dst[i].w = (T)comp[3][i];
+            }
+        }
+
+    private:
+        void* block;
+        float* comp[N];
+        size_t count, cap;
+    };
+
+    typedef VecStream<1> FloatStream;
+    typedef VecStream<2> Vec2Stream;
+    typedef VecStream<3> Vec3Stream;
+    typedef VecStream<4> Vec4Stream;
+
+    namespace detail {
+        // Big streams are split across threads (see 'Threading' in lina_batch.hpp) in ranges that
+        // start on a cache line.
+        enum { stream_task_align = LINA_STREAM_ALIGNMENT / sizeof(float) };
+
+        // Component-wise a (op) b over every component of two streams.
+        template <int N, typename Op>
+        inline void stream_binary(const VecStream<N>& a, const VecStream<N>& b, VecStream<N>& out, Op op) {
+            out.resize(a.size());
+            const VecStream<N>* pa = &a;
+            const VecStream<N>* pb = &b;
+            VecStream<N>* po = &out;
+            batch_for(a.size(), [=](size_t begin, size_t end) {
+                for (int k = 0; k < N; k++) {
+                    const float* in[2] = {pa->component(k) + begin, pb->component(k) + begin};
+                    float* o[1] = {po->component(k) + begin};
+                    stream_kernel<2, 1>(in, o, end - begin, [&](const floatv* v, floatv* r) { r[0] = op(v[0], v[1]); });
+                }
+            }, stream_task_align);
+        }
+
+        template <int N, typename Op>
+        inline void stream_scalar(const VecStream<N>& a, float s, VecStream<N>& out, Op op) {
+            out.resize(a.size());
+            const VecStream<N>* pa = &a;
+            VecStream<N>* po = &out;
+            batch_for(a.size(), [=](size_t begin, size_t end) {
+                floatv sv = setv(s);
+                for (int k = 0; k < N; k++) {
+                    const float* in[1] = {pa->component(k) + begin};
+                    float* o[1] = {po->component(k) + begin};
+                    stream_kernel<1, 1>(in, o, end - begin, [&](const floatv* v, floatv* r) { r[0] = op(v[0], sv); });
+                }
+            }, stream_task_align);
+        }
+
+        template <int N>
+        inline floatv stream_dot(const floatv* a, const floatv* b) noexcept {
+            floatv d = a[0] * b[0];
+            for (int k = 1; k < N; k++) d = maddv(a[k], b[k], d);
+            return d;
+        }
+
+        // v / sqrt(d) for the precise policy, v * rsqrt(d) for the fast one.
+        inline void stream_normalize(precise, const floatv* v, floatv d, floatv* r, int n) noexcept {
+            floatv len = sqrtv(d);
+            for (int k = 0; k < n; k++) r[k] = v[k] / len;
+        }
+        inline void stream_normalize(fast, const floatv* v, floatv d, floatv* r, int n) noexcept {
+            floatv inv = fast::rsqrt(d);
+            for (int k = 0; k < n; k++) r[k] = v[k] * inv;
+        }
+
+        struct stream_add { floatv operator()(floatv a, floatv b) const noexcept { return a + b; } };
+        struct stream_sub { floatv operator()(floatv a, floatv b) const noexcept { return a - b; } };
+        struct stream_mul { floatv operator()(floatv a, floatv b) const noexcept { return a * b; } };
+        template <typename P = precise>
+        struct stream_div { floatv operator()(floatv a, floatv b) const noexcept { return P::div(a, b); } };
+    }
+
+#ifdef LINA_EXPR
+    namespace expr {
+        // A stream used in an expression, only holds a reference to it.
+        template <int N>
+        struct stream_leaf : stream_tag {
+            static constexpr int size = N;
+            const VecStream<N>& s;
+
+            explicit stream_leaf(const VecStream<N>& s) noexcept : s(s) {}
+            size_t count() const noexcept { return s.size(); }
+            detail::floatv load(int k, size_t i) const noexcept { return detail::loadv(s.component(k) + i); }
+            // The last `rest` elements, through a zero padded copy.
+            detail::floatv load(int k, size_t i, size_t rest) const noexcept {
+                float t[detail::floatv_width] = {};
+                memcpy(t, s.component(k) + i, rest * sizeof(float));
+                return detail::loadv(t);
+            }
+        };
+
+        // A scalar (N = 0) or a single Vector2/3/4 used in a stream expression, it's the same for
+        // every element.
+        template <int N>
+        struct stream_uniform : stream_tag {
+            static constexpr int size = N;
+            detail::floatv v[N ? N : 1];
+
+            size_t count() const noexcept { return 0; }
+            detail::floatv load(int k, size_t) const noexcept { return v[N ? k : 0]; }
+            detail::floatv load(int k, size_t, size_t) const noexcept { return v[N ? k : 0]; }
+        };
+
+        template <typename Op, typename L, typename R>
+        struct stream_binary : stream_tag {
+            static constexpr int size = L::size != 0 ? L::size : R::size;
+            static_assert(L::size == 0 || R::size == 0 || L::size == R::size, "lina: can't mix streams of different sizes in one expression.");
+            L l;
+            R r;
+
+            stream_binary(const L& l, const R& r) noexcept : l(l), r(r) {}
+            size_t count() const noexcept { return l.count() ? l.count() : r.count(); }
+            detail::floatv load(int k, size_t i) const noexcept { return Op()(l.load(k, i), r.load(k, i)); }
+            detail::floatv load(int k, size_t i, size_t rest) const noexcept { return Op()(l.load(k, i, rest), r.load(k, i, rest)); }
+        };
+
+        template <typename E>
+        struct stream_negate : stream_tag {
+            static constexpr int size = E::size;
+            E e;
+
+            explicit stream_negate(const E& e) noexcept : e(e) {}
+            size_t count() const noexcept { return e.count(); }
+            // -0 - x flips the sign of zeros too.
+            detail::floatv load(int k, size_t i) const noexcept { return detail::setv(-0.f) - e.load(k, i); }
+            detail::floatv load(int k, size_t i, size_t rest) const noexcept { return detail::setv(-0.f) - e.load(k, i, rest); }
+        };
+
+        template <typename X>
+        struct is_stream_operand : std::false_type {};
+        template <int N>
+        struct is_stream_operand<VecStream<N>> : std::true_type {};
+
+        // Turns one side of an operator into a stream node.
+        template <typename X, typename = void>
+        struct stream_operand {};
+        template <int N>
+        struct stream_operand<VecStream<N>> {
+            typedef stream_leaf<N> type;
+            static type make(const VecStream<N>& s) noexcept { return type(s); }
+        };
+        template <typename X>
+        struct stream_operand<X, typename std::enable_if<is_stream_node<X>::value>::type> {
+            typedef X type;
+            static const X& make(const X& x) noexcept { return x; }
+        };
+        template <typename X>
+        struct stream_operand<X, typename std::enable_if<std::is_arithmetic<X>::value>::type> {
+            typedef stream_uniform<0> type;
+            static type make(X x) noexcept {
+                type u;
+                u.v[0] = detail::setv((float)x);
+                return u;
+            }
+        };
+        template <typename X>
+        struct stream_operand<X, typename std::enable_if<(vec_traits<X>::size > 0)>::type> {
+            typedef stream_uniform<vec_traits<X>::size> type;
+            static type make(const X& x) noexcept {
+                type u;
+                fill(u, x, std::integral_constant<int, type::size>());
+                return u;
+            }
+
+        private:
+            template <int I>
+            static void fill(type& u, const X& x, std::integral_constant<int, I>) noexcept {
+                u.v[I - 1] = detail::setv((float)component<I - 1>::get(x));
+                fill(u, x, std::integral_constant<int, I - 1>());
+            }
+            static void fill(type&, const X&, std::integral_constant<int, 0>) noexcept {}
+        };
+
+        // A stream or stream expression on at least one side, a stream, stream expression, scalar
+        // or Vector2/3/4 on the other.
+        template <typename X>
+        struct is_stream_side : std::integral_constant<bool, is_stream_operand<X>::value || is_stream_node<X>::value> {};
+        template <typename X>
+        struct is_stream_other : std::integral_constant<bool, is_stream_side<X>::value || std::is_arithmetic<X>::value || (vec_traits<X>::size > 0)> {};
+
+        template <typename Op, typename L, typename R, bool =
+            (is_stream_side<L>::value && is_stream_other<R>::value) || (is_stream_other<L>::value && is_stream_side<R>::value)>
+        struct stream_result {};
+        template <typename Op, typename L, typename R>
+        struct stream_result<Op, L, R, true> {
+            typedef stream_binary<Op, typename stream_operand<L>::type, typename stream_operand<R>::type> type;
+        };
+
+    #define LINA_STREAM_OPERATOR(op, name) \
+        template <typename L, typename R> \
+        inline typename stream_result<name, L, R>::type operator op(const L& l, const R& r) noexcept { \
+            return typename stream_result<name, L, R>::type(stream_operand<L>::make(l), stream_operand<R>::make(r)); \
+        }
+        LINA_STREAM_OPERATOR(+, detail::stream_add)
+        LINA_STREAM_OPERATOR(-, detail::stream_sub)
+        LINA_STREAM_OPERATOR(*, detail::stream_mul)
+        LINA_STREAM_OPERATOR(/, detail::stream_div<>)
+    #undef LINA_STREAM_OPERATOR
+
+        template <typename E, typename = typename std::enable_if<is_stream_side<E>::value>::type>
+        inline stream_negate<typename stream_operand<E>::type> operator-(const E& e) noexcept {
+            return stream_negate<typename stream_operand<E>::type>(stream_operand<E>::make(e));
+        }
+    }
+    using expr::operator+;
+    using expr::operator-;
+    using expr::operator*;
+    using expr::operator/;
+#endif
+
+    template <int N>
+    inline void add(const VecStream<N>& a, const VecStream<N>& b, VecStream<N>& out) { detail::stream_binary(a, b, out, detail::stream_add()); }
+    template <int N>
+    inline void sub(const VecStream<N>& a, const VecStream<N>& b, VecStream<N>& out) { detail::stream_binary(a, b, out, detail::stream_sub()); }
+    template <int N>
+    inline void mul(const VecStream<N>& a, const VecStream<N>& b, VecStream<N>& out) { detail::stream_binary(a, b, out, detail::stream_mul()); }
+    template <typename P = precise, int N>
+    inline void div(const VecStream<N>& a, const VecStream<N>& b, VecStream<N>& out) { detail::stream_binary(a, b, out, detail::stream_div<P>()); }
+
+    template <int N>
+    inline void add(const VecStream<N>& a, float s, VecStream<N>& out) { detail::stream_scalar(a, s, out, detail::stream_add()); }
+    template <int N>
+    inline void sub(const VecStream<N>& a, float s, VecStream<N>& out) { detail::stream_scalar(a, s, out, detail::stream_sub()); }
+    template <int N>
+    inline void mul(const VecStream<N>& a, float s, VecStream<N>& out) { detail::stream_scalar(a, s, out, detail::stream_mul()); }
+    template <typename P = precise, int N>
+    inline void div(const VecStream<N>& a, float s, VecStream<N>& out) { detail::stream_scalar(a, s, out, detail::stream_div<P>()); }
+
+    // out[i] = dot(a[i], b[i])
+    template <int N>
+    inline void dot(const VecStream<N>& a, const VecStream<N>& b, FloatStream& out) {
+        out.resize(a.size());
+        const VecStream<N>* pa = &a;
+        const VecStream<N>* pb = &b;
+        float* ox = out.x();
+        detail::batch_for(a.size(), [=](size_t begin, size_t end) {
+            const float* in[2*N];
+            for (int k = 0; k < N; k++) { in[k] = pa->component(k) + begin; in[N + k] = pb->component(k) + begin; }
+            float* o[1] = {ox + begin};
+            detail::stream_kernel<2*N, 1>(in, o, end - begin, [](const detail::floatv* v, detail::floatv* r) {
+                r[0] = detail::stream_dot<N>(v, v + N);
+            });
+        }, detail::stream_task_align);
+    }
+
+    // out[i] = cross(a[i], b[i])
+    inline void cross(const Vec3Stream& a, const Vec3Stream& b, Vec3Stream& out) {
+        out.resize(a.size());
+        const float *ax = a.x(), *ay = a.y(), *az = a.z(), *bx = b.x(), *by = b.y(), *bz = b.z();
+        float *ox = out.x(), *oy = out.y(), *oz = out.z();
+        detail::batch_for(a.size(), [=](size_t begin, size_t end) {
+            const float* in[6] = {ax + begin, ay + begin, az + begin, bx + begin, by + begin, bz + begin};
+            float* o[3] = {ox + begin, oy + begin, oz + begin};
+            detail::stream_kernel<6, 3>(in, o, end - begin, [](const detail::floatv* v, detail::floatv* r) {
+                r[0] = v[1] * v[5] - v[2] * v[4];
+                r[1] = v[2] * v[3] - v[0] * v[5];
+                r[2] = v[0] * v[4] - v[1] * v[3];
+            });
+        }, detail::stream_task_align);
+    }
+
+    // out[i] = a[i].length()
+    template <typename P = precise, int N>
+    inline void length(const VecStream<N>& a, FloatStream& out) {
+        out.resize(a.size());
+        const VecStream<N>* pa = &a;
+        float* ox = out.x();
+        detail::batch_for(a.size(), [=](size_t begin, size_t end) {
+            const float* in[N];
+            for (int k = 0; k < N; k++) in[k] = pa->component(k) + begin;
+            float* o[1] = {ox + begin};
+            detail::stream_kernel<N, 1>(in, o, end - begin, [](const detail::floatv* v, detail::floatv* r) {
+                r[0] = P::sqrt(detail::stream_dot<N>(v, v));
+            });
+        }, detail::stream_task_align);
+    }
+
+    // out[i] = a[i].normalized()
+    template <typename P = precise, int N>
+    inline void normalize(const VecStream<N>& a, VecStream<N>& out) {
+        out.resize(a.size());
+        const VecStream<N>* pa = &a;
+        VecStream<N>* po = &out;
+        detail::batch_for(a.size(), [=](size_t begin, size_t end) {
+            const float* in[N];
+            float* o[N];
+            for (int k = 0; k < N; k++) { in[k] = pa->component(k) + begin; o[k] = po->component(k) + begin; }
+            detail::stream_kernel<N, N>(in, o, end - begin, [](const detail::floatv* v, detail::floatv* r) {
+                detail::stream_normalize(P(), v, detail::stream_dot<N>(v, v), r, N);
+            });
+        }, detail::stream_task_align);
+    }
+
+    // out[i] = a[i] + (b[i] - a[i]) * t
+    template <int N>
+    inline void lerp(const VecStream<N>& a, const VecStream<N>& b, float t, VecStream<N>& out) {
+        out.resize(a.size());
+        const VecStream<N>* pa = &a;
+        const VecStream<N>* pb = &b;
+        VecStream<N>* po = &out;
+        detail::batch_for(a.size(), [=](size_t begin, size_t end) {
+            detail::floatv tv = detail::setv(t);
+            for (int k = 0; k < N; k++) {
+                const float* in[2] = {pa->component(k) + begin, pb->component(k) + begin};
+                float* o[1] = {po->component(k) + begin};
+                detail::stream_kernel<2, 1>(in, o, end - begin, [&](const detail::floatv* v, detail::floatv* r) {
+                    r[0] = detail::maddv(v[1] - v[0], tv, v[0]);
+                });
+            }
+        }, detail::stream_task_align);
+    }
+}
+
+#endif /* LINA_STREAM_HPP */
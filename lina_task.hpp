@@ -0,0 +1,413 @@
+#ifndef LINA_TASK_HPP
+#define LINA_TASK_HPP
+
+#include "lina.hpp"
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+
+###################
+      Tasks
+###################
+Every bulk function in lina (the batch transforms, culling, skinning, the
+stream operations, packing, ...) splits big arrays across threads with the
+task scheduler in here, and so can you:
+
+    parallel_for(particles.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) update(particles[i]);
+    });
+
+    float total = parallel_reduce(masses.size(), 0.f,
+        [&](size_t begin, size_t end) { float s = 0.f; for (size_t i = begin; i < end; i++) s += masses[i]; return s; },
+        [](float a, float b) { return a + b; });
+
+[0, n) is cut into tasks of `grain` elements (the last argument of both, or
+picked from n when it's 0) and f(begin, end) is called once per task. The
+calling thread works on the tasks too, and the call returns once they're all
+done. When there's only one task f is called directly.
+
+parallel_reduce calls f for every task and then combines the results in task
+order on the calling thread: combine(combine(identity, r0), r1), ... The tasks
+only depend on n and the grain, not on the number of threads, so the result is
+the same on every machine and every run, even for floats.
+
+================
+  The Scheduler
+================
+'TaskScheduler' keeps a pool of worker threads that sleep while there's
+nothing to do, so a parallel_for costs a wake up instead of creating threads.
+Each thread (the caller included) starts with an equal slice of the tasks
+and takes them from the front of its own slice. A thread that runs out steals
+the back half of the slice of another thread, so one slow task (or a thread
+that got descheduled) doesn't hold up the rest.
+
+The tasks are always a run of consecutive indices, so instead of a work
+stealing deque of tasks every thread has one [begin, end) range behind its
+own mutex. That's all a deque would hold, and a thief takes half of it with
+one lock instead of one task at a time.
+
+The default scheduler uses one thread per hardware thread, change that with
+setBatchThreadCount() (see 'Threading' in lina_batch.hpp). The workers are
+only started the first time there's something to run.
+
+One parallel_for runs at a time. Calling one from inside a task, or from
+another thread while one is running, just runs it on the calling thread.
+
+If a task throws, the tasks that haven't started yet are dropped, and once
+the ones that are still running are done the first exception is rethrown on
+the calling thread. So f can throw, but then there's no telling which of the
+other ranges it was called for.
+
+================
+  Executors
+================
+If you already have a job system, implement 'Executor' and hand it to
+setExecutor(), and every lina function will run its tasks on it:
+
+    struct MyExecutor : lina::Executor {
+        unsigned concurrency() const noexcept override { return jobs.threadCount(); }
+        void run(size_t count, void (*task)(void*, size_t), void* context) override {
+            jobs.forEach(count, [=](size_t i) { task(context, i); });  // and wait for all of them
+        }
+    };
+
+run() has to call task(context, i) once for every i in [0, count), in any
+order on any thread, and return once they're all done. setExecutor(nullptr)
+goes back to the default scheduler. Don't change it while anything is running.
+
+*/
+
+namespace lina {
+    struct Executor {
+        virtual ~Executor() {}
+        // How many threads run tasks at the same time, the calling thread included.
+        virtual unsigned concurrency() const noexcept = 0;
+        // Calls task(context, i) for every i in [0, count) and returns once they're all done.
+        virtual void run(size_t count, void (*task)(void*, size_t), void* context) = 0;
+    };
+
+    namespace detail {
+        // hardware_concurrency() can be a system call, so it's only asked once.
+        inline unsigned hardware_threads() noexcept {
+            static const unsigned n = std::thread::hardware_concurrency();
+            return n ? n : 1;
+        }
+
+        // Set on the worker threads, so a parallel_for inside a task doesn't wait for itself.
+        inline bool& in_task() noexcept {
+            static thread_local bool t = false;
+            return t;
+        }
+    }
+
+    struct TaskScheduler : Executor {
+        // `threads` counts the calling thread, 0 means one per hardware thread.
+        explicit TaskScheduler(unsigned threads = 0) : thread_count(threads ? threads : detail::hardware_threads()), current(nullptr),
+                                                       generation(0), active(0), stop(false) {}
+        ~TaskScheduler() { stopWorkers(); }
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        unsigned concurrency() const noexcept override { return thread_count; }
+
+        // Not while anything is running.
+        void setThreadCount(unsigned threads) {
+            unsigned n = threads ? threads : detail::hardware_threads();
+            if (n == thread_count) return;
+            stopWorkers();
+            thread_count = n;
+        }
+
+        void run(size_t count, void (*task)(void*, size_t), void* context) override {
+            if (count == 0) return;
+            std::unique_lock<std::mutex> running(busy, std::try_to_lock);
+            if (!running.owns_lock() || count == 1 || thread_count < 2 || detail::in_task()) {
+                for (size_t i = 0; i < count; i++) task(context, i);
+                return;
+            }
+            startWorkers();
+            if (workers.empty()) {
+                for (size_t i = 0; i < count; i++) task(context, i);
+                return;
+            }
+
+            // Every thread gets an equal slice of the tasks to start with.
+            size_t threads = workers.size() + 1;
+            size_t per = count / threads, extra = count % threads, begin = 0;
+            for (size_t s = 0; s < threads; s++) {
+                size_t end = begin + per + (s < extra ? 1 : 0);
+                std::lock_guard<std::mutex> l(slots[s].lock);
+                slots[s].begin = begin;
+                slots[s].end = end;
+                begin = end;
+            }
+            job j;
+            j.task = task;
+            j.context = context;
+            j.remaining.store(count, std::memory_order_relaxed);
+            j.error = nullptr;
+            {
+                std::lock_guard<std::mutex> l(lock);
+                current = &j;
+                generation++;
+            }
+            wake.notify_all();
+
+            detail::in_task() = true;
+            work(0, j);
+            detail::in_task() = false;
+
+            // Wait for the tasks the workers are still running, and then for the workers to
+            // let go of the job, it lives on this stack.
+            std::unique_lock<std::mutex> l(lock);
+            done.wait(l, [&] { return j.remaining.load(std::memory_order_acquire) == 0; });
+            current = nullptr;
+            done.wait(l, [&] { return active == 0; });
+            if (j.error) std::rethrow_exception(j.error);
+        }
+
+    private:
+        struct job {
+            void (*task)(void*, size_t);
+            void* context;
+            std::atomic<size_t> remaining;
+            std::exception_ptr error;  // the first exception a task threw, guarded by `lock`
+        };
+
+        // The tasks [begin, end) a thread still has to run, the owner takes them from the front
+        // and thieves from the back.
+        struct slot {
+            std::mutex lock;
+            size_t begin = 0, end = 0;
+            char pad[64];
+        };
+
+        unsigned thread_count;
+        std::vector<std::thread> workers;
+        std::unique_ptr<slot[]> slots;
+        std::mutex busy;  // held while a run() uses the workers
+        std::mutex lock;  // guards everything below
+        std::condition_variable wake, done;
+        job* current;
+        size_t generation;
+        unsigned active;  // workers that are working on `current`
+        bool stop;
+
+        void startWorkers() {
+            if (!workers.empty() || thread_count < 2) return;
+            slots.reset(new slot[thread_count]);
+            stop = false;
+            try {
+                for (unsigned i = 1; i < thread_count; i++) workers.emplace_back(&TaskScheduler::loop, this, i);
+            } catch (...) {
+                // Whatever threads could be started are enough, the others' slots just stay empty.
+            }
+        }
+
+        void stopWorkers() {
+            {
+                std::lock_guard<std::mutex> l(lock);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers) t.join();
+            workers.clear();
+            slots.reset();
+        }
+
+        void loop(unsigned index) {
+            detail::in_task() = true;
+            size_t seen = 0;
+            for (;;) {
+                std::unique_lock<std::mutex> l(lock);
+                wake.wait(l, [&] { return stop || (current && generation != seen); });
+                if (stop) return;
+                seen = generation;
+                job* j = current;
+                active++;
+                l.unlock();
+
+                work(index, *j);
+
+                l.lock();
+                if (--active == 0) done.notify_all();
+            }
+        }
+
+        bool pop(size_t self, size_t& task) {
+            slot& s = slots[self];
+            std::lock_guard<std::mutex> l(s.lock);
+            if (s.begin == s.end) return false;
+            task = s.begin++;
+            return true;
+        }
+
+        // Takes the back half of another thread's tasks, runs the first one of them and keeps
+        // the rest in its own slot.
+        bool steal(size_t self, size_t& task) {
+            size_t threads = workers.size() + 1;
+            for (size_t k = 1; k < threads; k++) {
+                slot& victim = slots[(self + k) % threads];
+                size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> l(victim.lock);
+                    if (victim.begin == victim.end) continue;
+                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                    end = victim.end;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> l(slots[self].lock);
+                slots[self].begin = begin + 1;
+                slots[self].end = end;
+                task = begin;
+                return true;
+            }
+            return false;
+        }
+
+        // Keeps the first exception for run() to rethrow, and drops the tasks nobody has started.
+        void fail(job& j) {
+            {
+                std::lock_guard<std::mutex> l(lock);
+                if (!j.error) j.error = std::current_exception();
+            }
+            size_t dropped = 0;
+            for (size_t s = 0; s < workers.size() + 1; s++) {
+                std::lock_guard<std::mutex> l(slots[s].lock);
+                dropped += slots[s].end - slots[s].begin;
+                slots[s].begin = slots[s].end;
+            }
+            // The failed task itself still counts down in work(), so this never reaches 0.
+            j.remaining.fetch_sub(dropped, std::memory_order_acq_rel);
+        }
+
+        // Runs tasks until there are none left, exceptions never leave it, so the job (which
+        // lives on run()'s stack) is only gone once every thread is out of here.
+        void work(size_t self, job& j) {
+            size_t task;
+            while (pop(self, task) || steal(self, task)) {
+                try {
+                    j.task(j.context, task);
+                } catch (...) {
+                    fail(j);
+                }
+                if (j.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> l(lock);
+                    done.notify_all();
+                }
+            }
+        }
+    };
+
+    namespace detail {
+        struct batch_settings {
+            unsigned threads = 0;
+            size_t threshold = 1 << 15;
+        };
+
+        inline batch_settings& batchSettings() noexcept {
+            static batch_settings s;
+            return s;
+        }
+
+        inline TaskScheduler& default_scheduler() {
+            static TaskScheduler s(batchSettings().threads);
+            return s;
+        }
+
+        inline Executor*& custom_executor() noexcept {
+            static Executor* e = nullptr;
+            return e;
+        }
+    }
+
+    // Runs every lina bulk function (and parallel_for) on `e`, nullptr goes back to the default scheduler.
+    inline void setExecutor(Executor* e) noexcept {
+        detail::custom_executor() = e;
+    }
+    inline Executor& executor() {
+        Executor* e = detail::custom_executor();
+        return e ? *e : detail::default_scheduler();
+    }
+
+    namespace detail {
+        template <typename F>
+        struct for_context {
+            F* f;
+            size_t n, grain;
+            static void run(void* c, size_t i) {
+                for_context* self = (for_context*)c;
+                size_t b = i * self->grain;
+                size_t e = self->n - b < self->grain ? self->n : b + self->grain;
+                (*self->f)(b, e);
+            }
+        };
+
+        // Only depends on n, so parallel_reduce gives the same result everywhere.
+        inline size_t auto_grain(size_t n) noexcept {
+            size_t g = n / 256;
+            return g < 1024 ? 1024 : g;
+        }
+
+        // Calls f(begin, end) for [0, n) in tasks of `grain` elements.
+        template <typename F>
+        inline void run_tasks(size_t n, size_t grain, F& f) {
+            size_t tasks = (n + grain - 1) / grain;
+            if (tasks < 2) {
+                if (n) f((size_t)0, n);
+                return;
+            }
+            for_context<F> c = {&f, n, grain};
+            executor().run(tasks, &for_context<F>::run, &c);
+        }
+
+        // The ranges the bulk functions split their arrays into. Nothing under twice the batch
+        // threshold gets split, and every range starts on a multiple of `align`.
+        template <typename F>
+        inline void batch_for(size_t n, F f, size_t align = 1) {
+            const batch_settings& s = batchSettings();
+            size_t threshold = s.threshold ? s.threshold : 1;
+            if (n < 2 * threshold) {
+                f((size_t)0, n);
+                return;
+            }
+            // A few tasks per thread, so stealing has something to even out.
+            size_t grain = n / ((size_t)executor().concurrency() * 4);
+            if (grain < threshold) grain = threshold;
+            grain = (grain + align - 1) / align * align;
+            run_tasks(n, grain, f);
+        }
+    }
+
+    // Calls f(begin, end) for every `grain` elements of [0, n), on every thread of the executor.
+    template <typename F>
+    inline void parallel_for(size_t n, F f, size_t grain = 0) {
+        detail::run_tasks(n, grain ? grain : detail::auto_grain(n), f);
+    }
+
+    // combine(...combine(combine(identity, f(0, g)), f(g, 2g))..., f(.., n)), with the f calls on
+    // every thread of the executor and the combines in order on the calling one.
+    template <typename T, typename F, typename C>
+    inline T parallel_reduce(size_t n, const T& identity, F f, C combine, size_t grain = 0) {
+        if (!grain) grain = detail::auto_grain(n);
+        size_t tasks = (n + grain - 1) / grain;
+        if (tasks < 2) return n ? combine(identity, f((size_t)0, n)) : identity;
+        std::vector<T> partial(tasks, identity);
+        T* p = partial.data();
+        size_t g = grain;
+        auto each = [&](size_t b, size_t e) { p[b / g] = f(b, e); };
+        detail::run_tasks(n, grain, each);
+        T r = identity;
+        for (const T& v : partial) r = combine(r, v);
+        return r;
+    }
+}
+
+#endif /* LINA_TASK_HPP */
@@ -0,0 +1,366 @@
+#ifndef LINA_VIEW_HPP
+#define LINA_VIEW_HPP
+
+#include "lina.hpp"
+#include "lina_stream.hpp"
+#include "lina_batch.hpp"
+#include <stdint.h>
+#include <iterator>
+#include <type_traits>
+
+/*
+
+###################
+   Strided Views
+###################
+A 'strided_view' shows memory you already have (a vertex buffer from a mesh
+loader, a network packet, ...) as an array of lina types without copying it.
+It's a pointer, a count and a stride in bytes, so it works for tightly packed
+arrays and for interleaved ones, where every vertex has a position, a normal,
+uvs and so on next to each other:
+
+    // 32 byte vertices: position (3 floats), normal (3 floats), uv (2 floats)
+    float* vertices = load_mesh(...);
+    vec3_view positions(vertices, count, 32);
+    vec3_view normals(vertices + 3, count, 32);
+    transformPoints(model, positions);        // in place, straight in the buffer
+    positions[0] += vec3(0, 1, 0);
+
+There are typedefs for the common types: vec2_view, vec3_view, vec4_view,
+quat_view, mat3_view and mat4_view, and const_vec3_view and so on for read only
+memory. A view converts to its const version, and a span converts to a view.
+The views don't own anything, so the memory has to outlive them. The elements
+have to be 4 byte aligned (true for anything made of floats), and the stride can
+be anything that keeps them that way, including 0 (every element is the same one).
+
+================
+  Operations
+================
+The batch transforms (transformPoints / transformDirections with a mat4 or an
+affine3, see lina_batch.hpp) and the stream operations (add, sub, mul,
+lerp, dot, length, normalize, see lina_stream.hpp) all have view versions:
+    add(a, b, out);                 // out[i] = a[i] + b[i]
+    mul(a, 2.f, out);               // out[i] = a[i] * 2
+    normalize<lina::fast>(normals, normals);
+    dot(a, b, lengths);             // into a view of floats
+
+They copy a block of elements at a time into structure-of-arrays form in a
+small buffer on the stack, run the same SIMD code as the streams and copy the
+results back, so they're close to the span and stream versions without an
+extra array. The output can be the same memory as an input, but it can't
+partly overlap with one. 'out' needs to have at least as many elements as the
+first input. Big views are split across threads like the batch transforms (see
+'Threading' in lina_batch.hpp).
+
+gather(view, stream) and scatter(stream, view) copy between a view and a
+VecStream, for when you want to keep the data in SoA form.
+
+*/
+
+namespace lina {
+    template <typename T>
+    struct strided_view {
+        typedef typename std::conditional<std::is_const<T>::value, const char, char>::type byte_type;
+        typedef typename std::conditional<std::is_const<T>::value, const void, void>::type void_type;
+
+        byte_type* ptr;
+        size_t count;
+        size_t stride;  // in bytes
+
+        strided_view() noexcept : ptr(nullptr), count(0), stride(sizeof(T)) {}
+        strided_view(T* p, size_t n, size_t stride = sizeof(T)) noexcept : ptr((byte_type*)p), count(n), stride(stride) {}
+        // Any other pointer (float*, uint8_t*, ...), the first element starts at `p`.
+        strided_view(void_type* p, size_t n, size_t stride = sizeof(T)) noexcept : ptr((byte_type*)p), count(n), stride(stride) {}
+        template <typename U, typename = typename std::enable_if<std::is_convertible<U*, T*>::value && sizeof(U) == sizeof(T)>::type>
+        strided_view(span<U> s) noexcept : ptr((byte_type*)s.data()), count(s.size()), stride(sizeof(T)) {}
+        // A view can always be turned into a read only one.
+        template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+        strided_view(const strided_view<U>& o) noexcept : ptr(o.ptr), count(o.count), stride(o.stride) {}
+
+        size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+        // true if the elements are right next to each other, like in an array.
+        bool contiguous() const noexcept { return stride == sizeof(T); }
+        T& operator[](size_t i) const noexcept { return *(T*)(ptr + i * stride); }
+
+        strided_view subview(size_t offset, size_t n) const noexcept {
+            return strided_view((void_type*)(ptr + offset * stride), n, stride);
+        }
+
+        struct iterator {
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef typename std::remove_const<T>::type value_type;
+            typedef ptrdiff_t difference_type;
+            typedef T* pointer;
+            typedef T& reference;
+
+            byte_type* p;
+            size_t stride;
+
+            T& operator*() const noexcept { return *(T*)p; }
+            T* operator->() const noexcept { return (T*)p; }
+            T& operator[](ptrdiff_t i) const noexcept { return *(T*)(p + i * (ptrdiff_t)stride); }
+            iterator& operator++() noexcept { p += stride; return *this; }
+            iterator operator++(int) noexcept { iterator r = *this; p += stride; return r; }
+            iterator& operator--() noexcept { p -= stride; return *this; }
+            iterator operator--(int) noexcept { iterator r = *this; p -= stride; return r; }
+            iterator& operator+=(ptrdiff_t i) noexcept { p += i * (ptrdiff_t)stride; return *this; }
+            iterator& operator-=(ptrdiff_t i) noexcept { p -= i * (ptrdiff_t)stride; return *this; }
+            iterator operator+(ptrdiff_t i) const noexcept { iterator r = *this; return r += i; }
+            iterator operator-(ptrdiff_t i) const noexcept { iterator r = *this; return r -= i; }
+            // A stride of 0 would divide by 0, every element is the same one so they're all 0 apart.
+            ptrdiff_t operator-(const iterator& o) const noexcept { return stride ? (p - o.p) / (ptrdiff_t)stride : 0; }
+            bool operator==(const iterator& o) const noexcept { return p == o.p; }
+            bool operator!=(const iterator& o) const noexcept { return p != o.p; }
+            bool operator<(const iterator& o) const noexcept { return p < o.p; }
+            bool operator>(const iterator& o) const noexcept { return p > o.p; }
+            bool operator<=(const iterator& o) const noexcept { return p <= o.p; }
+            bool operator>=(const iterator& o) const noexcept { return p >= o.p; }
+        };
+
+        iterator begin() const noexcept { return iterator{ptr, stride}; }
+        // With a stride of 0 begin() == end() for any count, so loop over the indices for those.
+        iterator end() const noexcept { return iterator{ptr + count * stride, stride}; }
+    };
+
+    typedef strided_view<vec2> vec2_view;
+    typedef strided_view<vec3> vec3_view;
+    typedef strided_view<vec4> vec4_view;
+    typedef strided_view<quat> quat_view;
+    typedef strided_view<mat3> mat3_view;
+    typedef strided_view<mat4> mat4_view;
+    typedef strided_view<const vec2> const_vec2_view;
+    typedef strided_view<const vec3> const_vec3_view;
+    typedef strided_view<const vec4> const_vec4_view;
+    typedef strided_view<const quat> const_quat_view;
+    typedef strided_view<const mat3> const_mat3_view;
+    typedef strided_view<const mat4> const_mat4_view;
+
+    namespace detail {
+        template <typename T> struct view_components;
+        template <> struct view_components<float> { enum { size = 1 }; };
+        template <> struct view_components<vec2> { enum { size = 2 }; };
+        template <> struct view_components<vec3> { enum { size = 3 }; };
+        template <> struct view_components<vec4> { enum { size = 4 }; };
+
+        // Lets the view functions take a view and its const version, V only gets deduced from the output.
+        template <typename V>
+        struct const_view { typedef strided_view<const V> type; };
+
+        // Copies elements [i, i + n) of a view with N components into N arrays.
+        template <int N, typename T>
+        inline void view_gather(const strided_view<T>& v, size_t i, size_t n, float* const* comp) noexcept {
+            const char* p = v.ptr + i * v.stride;
+            if (N == 3 && v.stride == 3 * sizeof(float)) {
+                deinterleave3((const float*)p, comp[0], comp[1], comp[2], n);
+                return;
+            }
+            for (size_t j = 0; j < n; j++, p += v.stride) {
+                const float* f = (const float*)p;
+                for (int k = 0; k < N; k++) comp[k][j] = f[k];
+            }
+        }
+
+        template <int N, typename T>
+        inline void view_scatter(const float* const* comp, size_t i, size_t n, const strided_view<T>& v) noexcept {
+            char* p = v.ptr + i * v.stride;
+            if (N == 3 && v.stride == 3 * sizeof(float)) {
+                interleave3(comp[0], comp[1], comp[2], (float*)p, n);
+                return;
+            }
+            for (size_t j = 0; j < n; j++, p += v.stride) {
+                float* f = (float*)p;
+                for (int k = 0; k < N; k++) f[k] = comp[k][j];
+            }
+        }
+
+        // Runs `f` (see stream_kernel) over one or two input views with NA and NB components and
+        // an output view with NO components, batch_block elements at a time through SoA copies.
+        // NB is 0 when there's no second input.
+        template <int NA, int NB, int NO, typename A, typename B, typename O, typename F>
+        inline void view_map(const strided_view<A>& a, const strided_view<B>& b, const strided_view<O>& out, F f) {
+            batch_for(a.size(), [&](size_t begin, size_t end) {
+                float buf[NA + NB + NO][batch_block];
+                float* src[NA + NB + 1];
+                float* dst[NO];
+                for (int k = 0; k < NA + NB; k++) src[k] = buf[k];
+                for (int k = 0; k < NO; k++) dst[k] = buf[NA + NB + k];
+                for (size_t i = begin; i < end; i += batch_block) {
+                    size_t c = end - i < (size_t)batch_block ? end - i : (size_t)batch_block;
+                    view_gather<NA>(a, i, c, src);
+                    if (NB) view_gather<NB>(b, i, c, src + NA);
+                    stream_kernel<NA + NB, NO>(src, dst, c, f);
+                    view_scatter<NO>(dst, i, c, out);
+                }
+            });
+        }
+
+        template <int NA, int NO, typename A, typename O, typename F>
+        inline void view_map(const strided_view<A>& a, const strided_view<O>& out, F f) {
+            view_map<NA, 0, NO>(a, a, out, f);
+        }
+
+        inline void view_transform3(const float* m, bool point, const_vec3_view in, vec3_view out) {
+            floatv m00 = setv(m[0]), m01 = setv(m[1]), m02 = setv(m[2]), m03 = setv(point ? m[3] : 0.f);
+            floatv m10 = setv(m[4]), m11 = setv(m[5]), m12 = setv(m[6]), m13 = setv(point ? m[7] : 0.f);
+            floatv m20 = setv(m[8]), m21 = setv(m[9]), m22 = setv(m[10]), m23 = setv(point ? m[11] : 0.f);
+            view_map<3, 3>(in, out, [&](const floatv* v, floatv* r) {
+                r[0] = maddv(m02, v[2], maddv(m01, v[1], m00 * v[0])) + m03;
+                r[1] = maddv(m12, v[2], maddv(m11, v[1], m10 * v[0])) + m13;
+                r[2] = maddv(m22, v[2], maddv(m21, v[1], m20 * v[0])) + m23;
+            });
+        }
+    }
+
+    // The batch transforms, see lina_batch.hpp.
+    // out[i] = m * vec4(in[i], 1)
+    inline void transformPoints(const mat4& m, const_vec3_view in, vec3_view out) {
+        detail::view_transform3(m.data(), true, in, out);
+    }
+    inline void transformPoints(const mat4& m, vec3_view points) {
+        detail::view_transform3(m.data(), true, points, points);
+    }
+
+    // out[i] = m * vec4(in[i], 0)
+    inline void transformDirections(const mat4& m, const_vec3_view in, vec3_view out) {
+        detail::view_transform3(m.data(), false, in, out);
+    }
+    inline void transformDirections(const mat4& m, vec3_view directions) {
+        detail::view_transform3(m.data(), false, directions, directions);
+    }
+
+    inline void transformPoints(const affine3& m, const_vec3_view in, vec3_view out) {
+        detail::view_transform3(m.data(), true, in, out);
+    }
+    inline void transformPoints(const affine3& m, vec3_view points) {
+        detail::view_transform3(m.data(), true, points, points);
+    }
+
+    inline void transformDirections(const affine3& m, const_vec3_view in, vec3_view out) {
+        detail::view_transform3(m.data(), false, in, out);
+    }
+    inline void transformDirections(const affine3& m, vec3_view directions) {
+        detail::view_transform3(m.data(), false, directions, directions);
+    }
+
+    // out[i] = m * in[i]
+    inline void transformPoints(const mat4& m, const_vec4_view in, vec4_view out) {
+        detail::floatv mv[16];
+        for (int k = 0; k < 16; k++) mv[k] = detail::setv(m.data()[k]);
+        detail::view_map<4, 4>(in, out, [&](const detail::floatv* v, detail::floatv* r) {
+            for (int row = 0; row < 4; row++) {
+                const detail::floatv* mr = mv + row*4;
+                r[row] = detail::maddv(mr[3], v[3], detail::maddv(mr[2], v[2], detail::maddv(mr[1], v[1], mr[0] * v[0])));
+            }
+        });
+    }
+    inline void transformPoints(const mat4& m, vec4_view points) {
+        transformPoints(m, const_vec4_view(points), points);
+    }
+
+    // The stream operations, see lina_stream.hpp. V is float, vec2, vec3 or vec4.
+    template <typename V>
+    inline void add(typename detail::const_view<V>::type a, typename detail::const_view<V>::type b, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::view_map<N, N, N>(a, b, out, [](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] + v[N + k];
+        });
+    }
+    template <typename V>
+    inline void sub(typename detail::const_view<V>::type a, typename detail::const_view<V>::type b, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::view_map<N, N, N>(a, b, out, [](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] - v[N + k];
+        });
+    }
+    template <typename V>
+    inline void mul(typename detail::const_view<V>::type a, typename detail::const_view<V>::type b, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::view_map<N, N, N>(a, b, out, [](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] * v[N + k];
+        });
+    }
+
+    template <typename V>
+    inline void add(typename detail::const_view<V>::type a, float s, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::floatv sv = detail::setv(s);
+        detail::view_map<N, N>(a, out, [&](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] + sv;
+        });
+    }
+    template <typename V>
+    inline void sub(typename detail::const_view<V>::type a, float s, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::floatv sv = detail::setv(s);
+        detail::view_map<N, N>(a, out, [&](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] - sv;
+        });
+    }
+    template <typename V>
+    inline void mul(typename detail::const_view<V>::type a, float s, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::floatv sv = detail::setv(s);
+        detail::view_map<N, N>(a, out, [&](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = v[k] * sv;
+        });
+    }
+
+    // out[i] = a[i] + (b[i] - a[i]) * t
+    template <typename V>
+    inline void lerp(typename detail::const_view<V>::type a, typename detail::const_view<V>::type b, float t, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::floatv tv = detail::setv(t);
+        detail::view_map<N, N, N>(a, b, out, [&](const detail::floatv* v, detail::floatv* r) {
+            for (int k = 0; k < N; k++) r[k] = detail::maddv(v[N + k] - v[k], tv, v[k]);
+        });
+    }
+
+    // out[i] = dot(a[i], b[i])
+    template <typename A, typename B>
+    inline void dot(const strided_view<A>& a, const strided_view<B>& b, strided_view<float> out) {
+        static_assert(std::is_same<typename std::remove_const<A>::type, typename std::remove_const<B>::type>::value,
+            "lina::dot: both views need the same type.");
+        enum { N = detail::view_components<typename std::remove_const<A>::type>::size };
+        detail::view_map<N, N, 1>(a, b, out, [](const detail::floatv* v, detail::floatv* r) {
+            r[0] = detail::stream_dot<N>(v, v + N);
+        });
+    }
+
+    // out[i] = a[i].length()
+    template <typename P = precise, typename V>
+    inline void length(const strided_view<V>& a, strided_view<float> out) {
+        enum { N = detail::view_components<typename std::remove_const<V>::type>::size };
+        detail::view_map<N, 1>(a, out, [](const detail::floatv* v, detail::floatv* r) {
+            r[0] = P::sqrt(detail::stream_dot<N>(v, v));
+        });
+    }
+
+    // out[i] = a[i].normalized()
+    template <typename P = precise, typename V>
+    inline void normalize(typename detail::const_view<V>::type a, strided_view<V> out) {
+        enum { N = detail::view_components<V>::size };
+        detail::view_map<N, N>(a, out, [](const detail::floatv* v, detail::floatv* r) {
+            detail::stream_normalize(P(), v, detail::stream_dot<N>(v, v), r, N);
+        });
+    }
+
+    // Copies a view into a stream, `out` is resized to the size of the view.
+    template <int N>
+    inline void gather(typename detail::const_view<typename VecStream<N>::value_type>::type in, VecStream<N>& out) {
+        out.resize(in.size());
+        float* comp[N];
+        for (int k = 0; k < N; k++) comp[k] = out.component(k);
+        detail::view_gather<N>(in, 0, in.size(), comp);
+    }
+
+    // Copies a stream into a view, which needs to hold at least in.size() elements.
+    template <int N>
+    inline void scatter(const VecStream<N>& in, strided_view<typename VecStream<N>::value_type> out) {
+        const float* comp[N];
+        for (int k = 0; k < N; k++) comp[k] = in.component(k);
+        detail::view_scatter<N>(comp, 0, in.size(), out);
+    }
+}
+
+#endif /* LINA_VIEW_HPP */
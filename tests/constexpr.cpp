@@ -0,0 +1,146 @@
+/*
+
+###################
+    constexpr.cpp
+###################
+Everything 'Constexpr' in lina.hpp promises, as static_asserts, so if this
+file compiles the promise holds. CMake builds it once per C++ standard
+(constexpr_cxx11, constexpr_cxx14, ...), since what's constexpr depends on it:
+    C++11: everything that doesn't modify its operands.
+    C++14: the in-place operators and members too.
+    C++14 with std::is_constant_evaluated or the builtin
+    (LINA_HAS_CONSTEXPR_SIMD): the matrix products and transposes.
+
+*/
+
+#include "lina.hpp"
+
+using namespace lina;
+
+/*
+    Vectors and Rect
+*/
+constexpr vec2 a2(1, 2), b2(3, 4);
+static_assert(a2 + b2 == vec2(4, 6) && a2 - b2 == vec2(-2, -2), "");
+static_assert(a2 * b2 == vec2(3, 8) && b2 / vec2(1, 2) == vec2(3, 2), "");
+static_assert(a2 + 1.f == vec2(2, 3) && a2 * 2.f == vec2(2, 4) && b2 / 2.f == vec2(1.5f, 2), "");
+static_assert(-a2 == vec2(-1, -2) && a2.dot(b2) == 11.f && vec2::dot(a2, b2) == 11.f, "");
+static_assert(ivec2(vec2(1.5f, 2.5f)) == ivec2(1, 2), "");
+
+constexpr vec3 a3(1, 2, 3), b3(4, 5, 6);
+static_assert(a3 + b3 == vec3(5, 7, 9) && a3 - b3 == vec3(-3, -3, -3), "");
+static_assert(a3 * b3 == vec3(4, 10, 18) && b3 / vec3(2, 5, 3) == vec3(2, 1, 2), "");
+static_assert(a3 - 1.f == vec3(0, 1, 2) && a3 * 2.f == vec3(2, 4, 6) && b3 / 2.f == vec3(2, 2.5f, 3), "");
+static_assert(-a3 == vec3(-1, -2, -3) && a3.dot(b3) == 32.f && vec3::dot(a3, b3) == 32.f, "");
+static_assert(a3.cross(b3) == vec3(-3, 6, -3) && vec3::cross(a3, b3) == vec3(-3, 6, -3), "");
+
+constexpr vec4 a4(1, 2, 3, 4), b4(5, 6, 7, 8);
+static_assert(a4 + b4 == vec4(6, 8, 10, 12) && a4 - b4 == vec4(-4, -4, -4, -4), "");
+static_assert(a4 * b4 == vec4(5, 12, 21, 32) && b4 / vec4(5, 3, 7, 2) == vec4(1, 2, 1, 4), "");
+static_assert(a4 + 1.f == vec4(2, 3, 4, 5) && a4 * 2.f == vec4(2, 4, 6, 8) && b4 / 2.f == vec4(2.5f, 3, 3.5f, 4), "");
+static_assert(-a4 == vec4(-1, -2, -3, -4) && a4.dot(b4) == 70.f && vec4::dot(a4, b4) == 70.f, "");
+static_assert(vec4(a3, 0.f).w == 0.f, "");
+
+static_assert(Rect<int>(1, 2, 3, 4) == Rect<int>(1, 2, 3, 4) && !(Rect<int>() == Rect<int>(1, 2, 3, 4)), "");
+static_assert(Rect<int>(Rect<float>(1.5f, 2.5f, 3.f, 4.f)) == Rect<int>(1, 2, 3, 4), "");
+
+static_assert(dtor(180.f) > 3.14159f && dtor(180.f) < 3.1416f && rtod(dtor(90.f)) > 89.99f, "");
+
+/*
+    Matrices
+*/
+constexpr mat4 T = mat4::translation({1, 2, 3});
+constexpr mat4 S = mat4::scalation({2, 3, 4, 1});
+static_assert(mat4::identity().isIdentity() && mat4::zeroed().isZeroed() && mat4() == mat4::identity(), "");
+static_assert(T._03 == 1.f && T._13 == 2.f && T._23 == 3.f && S._00 == 2.f && S._22 == 4.f, "");
+// Adding a vector to a matrix adds it to the first column.
+static_assert((T + S)._00 == 3.f && (T - S)._03 == 1.f && (T + vec4(1, 1, 1, 1))._00 == 2.f && (T - vec4(1, 1, 1, 1))._30 == -1.f, "");
+static_assert(T == T && !(T == S), "");
+
+constexpr mat3 T3 = mat3::translation({1, 2});
+constexpr mat3 S3 = mat3::scalation({2, 3, 1});
+static_assert(mat3::identity() == mat3() && mat3::zeroed()._00 == 0.f, "");
+static_assert(T3._02 == 1.f && T3._12 == 2.f && S3._11 == 3.f, "");
+static_assert((T3 + S3)._00 == 3.f && (T3 - S3)._02 == 1.f && (T3 + vec3(1, 1, 1))._20 == 1.f && (T3 - vec3(1, 1, 1))._00 == 0.f, "");
+static_assert(mat3(1, 2, 3, 4, 5, 6, 7, 8, 9)._21 == 8.f, "");
+
+constexpr mat2 M2(1, 2, 3, 4);
+static_assert(mat2()._00 == 1.f && mat2()._01 == 0.f && M2.determinant() == -2.f, "");
+static_assert(M2.inverse()._00 == -2.f && M2.inverse()._01 == 1.f && M2.inverse()._10 == 1.5f && M2.inverse()._11 == -0.5f, "");
+
+/*
+    Builders
+*/
+constexpr mat4 V = CreateRMCameraViewMatrix({1, 2, 3}, {1, 0, 0}, {0, 1, 0}, {0, 0, -1});
+constexpr mat4 VC = CreateCMCameraViewMatrix({1, 2, 3}, {1, 0, 0}, {0, 1, 0}, {0, 0, -1});
+static_assert(V._03 == -1.f && V._13 == -2.f && V._23 == -3.f && V._22 == 1.f, "");
+static_assert(VC._30 == V._03 && VC._31 == V._13 && VC._32 == V._23, "");
+
+// The identity rotation, scaled by 2 and moved to (1, 2, 3).
+constexpr mat4 M = CreateRMModelMatrix({1, 2, 3}, quat(), {2, 2, 2, 1});
+constexpr mat4 MC = CreateCMModelMatrix({1, 2, 3}, quat(), {2, 2, 2, 1});
+static_assert(M._00 == 2.f && M._11 == 2.f && M._03 == 1.f && M._23 == 3.f && M._33 == 1.f, "");
+static_assert(MC._30 == 1.f && MC._32 == 3.f && MC._00 == 2.f, "");
+
+/*
+    In-place operations, C++14
+*/
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+constexpr vec3 updated() {
+    vec3 v(1, 1, 1);
+    v += vec3(1, 2, 3);
+    v *= 2.f;
+    v -= 1.f;
+    v /= vec3(1, 1, 3);
+    return v;
+}
+static_assert(updated() == vec3(3, 5, 2.33333333f), "");
+
+constexpr vec4 updated4() {
+    vec4 v(1, 2, 3, 4);
+    v += 1.f;
+    v -= vec4(1, 1, 1, 1);
+    v.nullify();
+    return v;
+}
+static_assert(updated4() == vec4(0, 0, 0, 0), "");
+
+constexpr mat4 moved() {
+    mat4 m;
+    m += vec4(1, 0, 0, 0);
+    m -= mat4::identity();
+    return m;
+}
+static_assert(moved()._00 == 1.f && moved()._11 == 0.f, "");
+#endif
+
+/*
+    Products and transposes, with LINA_HAS_CONSTEXPR_SIMD
+*/
+#if LINA_HAS_CONSTEXPR_SIMD
+constexpr mat4 TS = T * S;
+static_assert(TS._00 == 2.f && TS._03 == 1.f && TS._23 == 3.f, "");
+static_assert(T * vec4(1, 1, 1, 1) == vec4(2, 3, 4, 1), "");
+static_assert(T.transposed()._30 == 1.f && T.transposed().transposed() == T, "");
+
+constexpr mat4 transformed() {
+    mat4 m;
+    m.translate({1, 0, 0});
+    m.scale({2, 2, 2, 1});
+    m *= mat4::translation({0, 1, 0});
+    m.transpose();
+    return m;
+}
+static_assert(transformed()._30 == 1.f && transformed()._31 == 2.f && transformed()._00 == 2.f, "");
+
+constexpr mat3 TS3 = T3 * S3;
+static_assert(TS3 * vec3(1, 1, 1) == vec3(3, 5, 1) && TS3.transposed()._20 == 1.f, "");
+
+// A table of matrices, all done by the compiler.
+constexpr mat4 table[3] = {T, T * S, T * S * V};
+static_assert(table[1]._11 == 3.f && table[2]._33 == 1.f, "");
+#endif
+
+int main() {
+    return 0;
+}
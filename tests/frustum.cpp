@@ -0,0 +1,96 @@
+/*
+
+###################
+    frustum.cpp
+###################
+Builds frustums from the camera builders (the RM and CM perspective and
+view matrices, 1920x1080, 90 degrees, near 0.1, far 100) and checks which
+depths in front of the camera are visible, through the single object tests
+and through cullSpheres and cullAABBs. CMake builds it once per LINA_SIMD
+level like kernels.cpp. Every failed check gets printed and the exit code is 1,
+or 77 (skipped) when the CPU can't run the level it was built for.
+
+*/
+
+#include "lina_cull.hpp"
+#include <stdio.h>
+#include <vector>
+
+using namespace lina;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            failures++; \
+            printf("%s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+// Distances along the camera's forward direction, and whether they're in between the near and far plane.
+static const float depths[] = {0.2f, 1.f, 50.f, 99.f, 0.05f, 200.f, -1.f};
+static const bool inside[] = {true, true, true, true, false, false, false};
+static const int depth_count = sizeof(depths) / sizeof(depths[0]);
+
+static void check_camera(const char* name, const Frustum& f, vec3 position, vec3 forward) {
+    // Small objects, so they don't reach over the near or far plane.
+    const float r = 0.01f;
+    Vec3Stream centers, mins, maxs;
+    FloatStream radii;
+    for (int i = 0; i < depth_count; i++) {
+        vec3 p(position.x + forward.x * depths[i], position.y + forward.y * depths[i], position.z + forward.z * depths[i]);
+        CHECK(f.containsPoint(p) == inside[i], "%s: containsPoint at depth %g is %d", name, depths[i], (int)!inside[i]);
+        CHECK(f.intersectsSphere(p, r) == inside[i], "%s: intersectsSphere at depth %g is %d", name, depths[i], (int)!inside[i]);
+        vec3 lo(p.x - r, p.y - r, p.z - r), hi(p.x + r, p.y + r, p.z + r);
+        CHECK(f.intersectsAABB(lo, hi) == inside[i], "%s: intersectsAABB at depth %g is %d", name, depths[i], (int)!inside[i]);
+        centers.push_back(p);
+        radii.push_back(r);
+        mins.push_back(lo);
+        maxs.push_back(hi);
+    }
+
+    std::vector<uint32_t> spheres(cullMaskSize(depth_count)), boxes(cullMaskSize(depth_count));
+    cullSpheres(f, centers, radii, spheres);
+    cullAABBs(f, mins, maxs, boxes);
+    for (int i = 0; i < depth_count; i++) {
+        CHECK(((spheres[0] >> i) & 1) == (uint32_t)inside[i], "%s: cullSpheres at depth %g is %d", name, depths[i], (int)!inside[i]);
+        CHECK(((boxes[0] >> i) & 1) == (uint32_t)inside[i], "%s: cullAABBs at depth %g is %d", name, depths[i], (int)!inside[i]);
+    }
+}
+
+static void test_camera(vec3 position, vec3 right, vec3 up, vec3 forward) {
+    const ivec2 screen(1920, 1080);
+    mat4 p = CreateRMCameraPerspectiveMatrix(screen, 90.f, 0.1f, 100.f);
+    mat4 v = CreateRMCameraViewMatrix(position, right, up, forward);
+    check_camera("fromRM(projection, view)", Frustum::fromRM(p, v), position, forward);
+    check_camera("fromRM(projection^T * view)", Frustum::fromRM(p.transposed() * v), position, forward);
+
+    mat4 pc = CreateCMCameraPerspectiveMatrix(screen, 90.f, 0.1f, 100.f);
+    mat4 vc = CreateCMCameraViewMatrix(position, right, up, forward);
+    check_camera("fromCM(projection, view)", Frustum::fromCM(pc, vc), position, forward);
+}
+
+static bool cpu_supported() {
+#if LINA_SIMD_X86 && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (LINA_SIMD >= LINA_SIMD_AVX && !__builtin_cpu_supports("avx")) return false;
+    if (LINA_SIMD >= LINA_SIMD_AVX2 && !(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))) return false;
+#endif
+    return true;
+}
+
+int main() {
+    if (!cpu_supported()) {
+        printf("skipped, the CPU can't run LINA_SIMD %d\n", LINA_SIMD);
+        return 77;
+    }
+
+    // At the origin looking down -z, and somewhere else looking down +x.
+    test_camera(vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, -1));
+    test_camera(vec3(5, 2, 30), vec3(0, 0, 1), vec3(0, 1, 0), vec3(1, 0, 0));
+
+    printf("LINA_SIMD %d: %d failed\n", LINA_SIMD, failures);
+    return failures ? 1 : 0;
+}
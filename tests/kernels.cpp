@@ -0,0 +1,698 @@
+/*
+
+###################
+    kernels.cpp
+###################
+Checks the SIMD kernels against the scalar reference kernels (the
+detail::*_scalar functions, see 'SIMD' in lina.hpp) on random inputs, with the
+bounds 'Precision' promises:
+    - the paths without FMA give the same values as the scalar code,
+    - the FMA paths are within 2 * n * 2^-24 * (sum of |term|) of it, for a
+      sum of n terms, which is the documented 8 * 2^-24 * (...) for the
+      4 term dot products,
+    - transposes are exact,
+    - inverses are within a few ULP of the largest element, for well
+      conditioned matrices.
+The packed vectors get a round trip through both the single conversions and
+the bulk ones, against the errors in the table of lina_pack.hpp. The batched
+solvers have to flag exactly the near singular matrices, and get small
+residuals for the rest, and so do the eigen and polar decompositions.
+
+CMake builds it once per LINA_SIMD level (kernels_scalar, kernels_sse2,
+kernels_avx, ...). Every failed check gets printed and the exit code is 1, or
+77 (skipped) when the CPU can't run the level it was built for.
+
+*/
+
+#include "lina.hpp"
+#include "lina_batch.hpp"
+#include "lina_skin.hpp"
+#include "lina_pack.hpp"
+#include "lina_solve.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+using namespace lina;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            failures++; \
+            printf("%s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+// Every run checks the same inputs.
+static uint32_t rng_state = 0x12345678u;
+static float rnd(float lo = -4.f, float hi = 4.f) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (hi - lo) * (float)(rng_state >> 8) * (1.f / 16777216.f);
+}
+static void fill(float* p, int n) {
+    for (int i = 0; i < n; i++) p[i] = rnd();
+}
+
+static const double ulp = 1.0 / 16777216.0;
+
+// How far a sum of `terms` terms whose absolute values add up to `mag` can be from the scalar result.
+static double sum_bound(int terms, double mag) {
+    return LINA_SIMD_FMA ? 2.0 * terms * ulp * mag : 0.0;
+}
+
+static bool close(float a, float b, double bound) {
+    return fabs((double)a - (double)b) <= bound;
+}
+
+/*
+    Products
+*/
+static void test_products() {
+    for (int it = 0; it < 1000; it++) {
+        float a[16], b[16], v[4], r[16], s[16];
+        fill(a, 16); fill(b, 16); fill(v, 4);
+
+        detail::mat4_mul(a, b, r);
+        detail::mat4_mul_scalar(a, b, s);
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++) {
+                double mag = 0;
+                for (int k = 0; k < 4; k++) mag += fabs((double)a[i*4+k] * b[k*4+j]);
+                CHECK(close(r[i*4+j], s[i*4+j], sum_bound(4, mag)), "mat4_mul [%d][%d]: %.9g vs %.9g", i, j, r[i*4+j], s[i*4+j]);
+            }
+
+        detail::mat4_mul_vec4(a, v, r);
+        detail::mat4_mul_vec4_scalar(a, v, s);
+        for (int i = 0; i < 4; i++) {
+            double mag = 0;
+            for (int k = 0; k < 4; k++) mag += fabs((double)a[i*4+k] * v[k]);
+            CHECK(close(r[i], s[i], sum_bound(4, mag)), "mat4_mul_vec4 [%d]: %.9g vs %.9g", i, r[i], s[i]);
+        }
+
+        detail::mat3_mul(a, b, r);
+        detail::mat3_mul_scalar(a, b, s);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                double mag = 0;
+                for (int k = 0; k < 3; k++) mag += fabs((double)a[i*3+k] * b[k*3+j]);
+                CHECK(close(r[i*3+j], s[i*3+j], sum_bound(3, mag)), "mat3_mul [%d][%d]: %.9g vs %.9g", i, j, r[i*3+j], s[i*3+j]);
+            }
+
+        detail::mat3_mul_vec3(a, v, r);
+        detail::mat3_mul_vec3_scalar(a, v, s);
+        for (int i = 0; i < 3; i++) {
+            double mag = 0;
+            for (int k = 0; k < 3; k++) mag += fabs((double)a[i*3+k] * v[k]);
+            CHECK(close(r[i], s[i], sum_bound(3, mag)), "mat3_mul_vec3 [%d]: %.9g vs %.9g", i, r[i], s[i]);
+        }
+
+        detail::affine3_mul(a, b, r);
+        detail::affine3_mul_scalar(a, b, s);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 4; j++) {
+                double mag = j == 3 ? fabs(a[i*4+3]) : 0.0;
+                for (int k = 0; k < 3; k++) mag += fabs((double)a[i*4+k] * b[k*4+j]);
+                CHECK(close(r[i*4+j], s[i*4+j], sum_bound(4, mag)), "affine3_mul [%d][%d]: %.9g vs %.9g", i, j, r[i*4+j], s[i*4+j]);
+            }
+    }
+}
+
+/*
+    Quaternions
+*/
+static void test_quaternions() {
+    for (int it = 0; it < 1000; it++) {
+        float a[4], b[4], v[3], r[4], s[4];
+        fill(a, 4); fill(b, 4); fill(v, 3);
+
+        detail::quat_mul(a, b, r);
+        detail::quat_mul_scalar(a, b, s);
+        // Every element is a sum of 4 products, one with each element of a.
+        double amax = 0, bmax = 0;
+        for (int k = 0; k < 4; k++) {
+            amax += fabs(a[k]);
+            bmax = fabs(b[k]) > bmax ? fabs(b[k]) : bmax;
+        }
+        for (int i = 0; i < 4; i++)
+            CHECK(close(r[i], s[i], sum_bound(4, amax * bmax)), "quat_mul [%d]: %.9g vs %.9g", i, r[i], s[i]);
+
+        // A unit quaternion, the way quat_rotate is meant to be used.
+        float l = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2] + a[3] * a[3]);
+        for (int k = 0; k < 4; k++) a[k] /= l;
+        detail::quat_rotate(a, v, r);
+        detail::quat_rotate_scalar(a, v, s);
+        // |t| <= 4 * |v| and every output adds v, w * t and two more products of q and t.
+        double vmax = fabs(v[0]) + fabs(v[1]) + fabs(v[2]);
+        for (int i = 0; i < 3; i++)
+            CHECK(close(r[i], s[i], sum_bound(6, 13.0 * vmax)), "quat_rotate [%d]: %.9g vs %.9g", i, r[i], s[i]);
+    }
+}
+
+/*
+    Transposes
+*/
+static void test_transposes() {
+    for (int it = 0; it < 100; it++) {
+        float m[16], r[16], s[16];
+        fill(m, 16);
+        detail::mat4_transpose(m, r);
+        detail::mat4_transpose_scalar(m, s);
+        CHECK(memcmp(r, s, sizeof(float) * 16) == 0, "mat4_transpose differs");
+        detail::mat3_transpose(m, r);
+        detail::mat3_transpose_scalar(m, s);
+        CHECK(memcmp(r, s, sizeof(float) * 9) == 0, "mat3_transpose differs");
+
+        // In place.
+        memcpy(r, m, sizeof(m));
+        detail::mat4_transpose(r, r);
+        detail::mat4_transpose_scalar(m, s);
+        CHECK(memcmp(r, s, sizeof(float) * 16) == 0, "mat4_transpose in place differs");
+    }
+}
+
+/*
+    Inverses
+*/
+// Within `ulps` ULP of the largest element of the scalar result.
+static void check_inverse(const char* name, const float* r, const float* s, int n, double ulps) {
+    double big = 0;
+    for (int i = 0; i < n; i++) big = fabs(s[i]) > big ? fabs(s[i]) : big;
+    for (int i = 0; i < n; i++)
+        CHECK(close(r[i], s[i], ulps * ulp * big), "%s [%d]: %.9g vs %.9g", name, i, r[i], s[i]);
+}
+
+static void test_inverses() {
+    for (int it = 0; it < 1000; it++) {
+        // Diagonally dominant, so they're well conditioned.
+        float m[16], r[16], s[16];
+        fill(m, 16);
+        m[0] += 10.f; m[5] += 10.f; m[10] += 10.f; m[15] += 10.f;
+
+        detail::mat4_inverse(m, r);
+        detail::mat4_inverse_scalar(m, s);
+        check_inverse("mat4_inverse", r, s, 16, 16);
+
+        detail::mat4_inverse_transpose3x3(m, r);
+        detail::mat4_inverse_transpose3x3_scalar(m, s);
+        check_inverse("mat4_inverse_transpose3x3", r, s, 9, 16);
+
+        detail::affine3_inverse(m, r);
+        detail::affine3_inverse_scalar(m, s);
+        check_inverse("affine3_inverse", r, s, 12, 16);
+
+        float m3[9] = {m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10]};
+        detail::mat3_inverse(m3, r);
+        detail::mat3_inverse_scalar(m3, s);
+        check_inverse("mat3_inverse", r, s, 9, 16);
+
+        detail::mat3_inverse_transpose(m3, r);
+        detail::mat3_inverse_transpose_scalar(m3, s);
+        check_inverse("mat3_inverse_transpose", r, s, 9, 16);
+    }
+}
+
+/*
+    Batch transforms, against mat4_mul_vec4_scalar
+*/
+static void test_batch() {
+    // Odd sizes so the loops that do 2 or 8 at a time have a remainder.
+    const size_t n = 37;
+    float m[16];
+    fill(m, 16);
+    vec4 in4[n], out4[n];
+    float x[n], y[n], z[n], ox[n], oy[n], oz[n];
+    for (size_t i = 0; i < n; i++) {
+        in4[i] = vec4(rnd(), rnd(), rnd(), rnd());
+        x[i] = rnd(); y[i] = rnd(); z[i] = rnd();
+    }
+
+    detail::transform4_aos(m, in4, out4, n);
+    for (size_t i = 0; i < n; i++) {
+        float s[4];
+        detail::mat4_mul_vec4_scalar(m, &in4[i].x, s);
+        for (int j = 0; j < 4; j++) {
+            double mag = 0;
+            for (int k = 0; k < 4; k++) mag += fabs((double)m[j*4+k] * (&in4[i].x)[k]);
+            CHECK(close((&out4[i].x)[j], s[j], sum_bound(4, mag)), "transform4_aos %zu [%d]: %.9g vs %.9g", i, j, (&out4[i].x)[j], s[j]);
+        }
+    }
+
+    for (int point = 0; point < 2; point++) {
+        detail::transform3_soa(m, point != 0, x, y, z, ox, oy, oz, n);
+        for (size_t i = 0; i < n; i++) {
+            float v[4] = {x[i], y[i], z[i], (float)point}, s[4];
+            detail::mat4_mul_vec4_scalar(m, v, s);
+            const float o[3] = {ox[i], oy[i], oz[i]};
+            for (int j = 0; j < 3; j++) {
+                double mag = 0;
+                for (int k = 0; k < 4; k++) mag += fabs((double)m[j*4+k] * v[k]);
+                CHECK(close(o[j], s[j], sum_bound(4, mag)), "transform3_soa point=%d %zu [%d]: %.9g vs %.9g", point, i, j, o[j], s[j]);
+            }
+        }
+    }
+}
+
+/*
+    Skinning
+*/
+template <int K>
+static void test_skin() {
+    const int bones = 8, verts = 64;
+    SkinPalette palette(bones);
+    for (int b = 0; b < bones; b++) fill(palette.data(b), 16);
+    SkinWeights<K> weights(verts);
+    for (int v = 0; v < verts; v++) {
+        uint16_t bi[K];
+        float w[K];
+        for (int k = 0; k < K; k++) {
+            bi[k] = (uint16_t)((v + k * 3) % bones);
+            w[k] = rnd(0.f, 1.f);
+        }
+        weights.set(v, bi, w);
+    }
+    detail::skin_influences<K> inf(weights);
+    for (int v = 0; v < verts; v++) {
+        float p[3], n[3], rp[4], rn[4], sp[3], sn[3];
+        fill(p, 3); fill(n, 3);
+        detail::skin_vertex<K>(palette.data(0), inf, v, p, n, rp, rn);
+        detail::skin_vertex_scalar<K>(palette.data(0), inf, v, p, n, sp, sn);
+        // Blending is K terms, then 4 more for the matrix times the point.
+        double wsum = 0, pmag = fabs(p[0]) + fabs(p[1]) + fabs(p[2]) + 1, nmag = fabs(n[0]) + fabs(n[1]) + fabs(n[2]);
+        for (int k = 0; k < K; k++) wsum += inf.weight[k][v];
+        for (int r = 0; r < 3; r++) {
+            CHECK(close(rp[r], sp[r], sum_bound(K + 4, 4.0 * wsum * pmag)), "skin_vertex<%d> position %d [%d]: %.9g vs %.9g", K, v, r, rp[r], sp[r]);
+            CHECK(close(rn[r], sn[r], sum_bound(K + 4, 4.0 * wsum * nmag)), "skin_vertex<%d> normal %d [%d]: %.9g vs %.9g", K, v, r, rn[r], sn[r]);
+        }
+    }
+}
+
+/*
+    Packed vectors
+*/
+// `count` floats on both sides of every point in `points`, clamped to [lo, hi], 4 to a vec4.
+static std::vector<vec4> around(const std::vector<float>& points, int count, float lo, float hi) {
+    std::vector<float> f;
+    for (float p : points) {
+        float x = p;
+        for (int i = 0; i < count; i++) x = nextafterf(x, lo - 1.f);
+        for (int i = 0; i <= 2 * count; i++, x = nextafterf(x, hi + 1.f))
+            f.push_back(x < lo ? lo : x > hi ? hi : x);
+    }
+    while (f.size() % 4) f.push_back(lo);
+    std::vector<vec4> v(f.size() / 4);
+    memcpy(&v[0].x, f.data(), f.size() * sizeof(float));
+    return v;
+}
+
+// Round trips `in` through P both ways, checks the bulk and single conversions agree and returns
+// the largest error of any component.
+template <typename P>
+static double round_trip4(const char* name, const std::vector<vec4>& in) {
+    std::vector<P> packed(in.size());
+    std::vector<vec4> out(in.size());
+    pack(in, packed);
+    unpack(packed, out);
+    double worst = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+        P single = P::fromVec4(in[i]);
+        vec4 back = single.toVec4();
+        CHECK(memcmp(&single, &packed[i], sizeof(P)) == 0 && memcmp(&back, &out[i], sizeof(vec4)) == 0,
+              "%s: pack and fromVec4 differ for %.9g %.9g %.9g %.9g", name, in[i].x, in[i].y, in[i].z, in[i].w);
+        for (int j = 0; j < 4; j++) {
+            double e = fabs((double)(&out[i].x)[j] - (double)(&in[i].x)[j]);
+            worst = e > worst ? e : worst;
+        }
+    }
+    return worst;
+}
+
+static double angle(vec3 a, vec3 b) {
+    double cx = (double)a.y * b.z - (double)a.z * b.y;
+    double cy = (double)a.z * b.x - (double)a.x * b.z;
+    double cz = (double)a.x * b.y - (double)a.y * b.x;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z);
+}
+
+static void test_pack() {
+    // The worst cases are right next to the midpoints between two codes.
+    std::vector<float> mid;
+    for (int k = -32768; k <= 32767; k++) mid.push_back((k + 0.5f) / 32767.f);
+    double e = round_trip4<snorm16x4>("snorm16x4", around(mid, 8, -1.f, 1.f));
+    CHECK(e <= 1.54e-5, "snorm16x4 error %.6g > 1.54e-5", e);
+
+    mid.clear();
+    for (int k = -1; k <= 255; k++) mid.push_back((k + 0.5f) / 255.f);
+    e = round_trip4<unorm8x4>("unorm8x4", around(mid, 8, 0.f, 1.f));
+    CHECK(e <= 1.97e-3, "unorm8x4 error %.6g > 1.97e-3", e);
+
+    // Halves, from far below the subnormals to past the largest half.
+    std::vector<vec4> h(4000);
+    for (size_t i = 0; i < h.size(); i++)
+        for (int j = 0; j < 4; j++) (&h[i].x)[j] = ldexpf(rnd(), (int)(rnd(-30.f, 18.f)));
+    std::vector<half4> hp(h.size());
+    std::vector<vec4> ho(h.size());
+    pack(h, hp);
+    unpack(hp, ho);
+    for (size_t i = 0; i < h.size(); i++) {
+        half4 single = half4::fromVec4(h[i]);
+        CHECK(memcmp(&single, &hp[i], sizeof(half4)) == 0, "half4: pack and fromVec4 differ for %.9g", h[i].x);
+        for (int j = 0; j < 4; j++) {
+            float x = (&h[i].x)[j], r = (&ho[i].x)[j], a = fabsf(x);
+            if (a < 6.1035156e-5f)
+                CHECK(fabs((double)r - x) <= 1.0 / (1 << 25), "half4 %.9g came back as %.9g", x, r);
+            else if (a <= 65504.f)
+                CHECK(fabs((double)r - x) <= a / 2048.0, "half4 %.9g came back as %.9g", x, r);
+            else if (a >= 65520.f)
+                CHECK(isinf(r) && (r < 0) == (x < 0), "half4 %.9g came back as %.9g", x, r);
+        }
+    }
+
+    // Normals, random ones and the ones halfway between the codes, which is where the worst cases are.
+    std::vector<vec3> n;
+    while (n.size() < 100000) {
+        vec3 v(rnd(-1.f, 1.f), rnd(-1.f, 1.f), rnd(-1.f, 1.f));
+        float l = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+        if (l > 0.1f && l <= 1.f) n.push_back(vec3(v.x / l, v.y / l, v.z / l));
+    }
+    while (n.size() < 400000) {
+        double u = (floor(rnd(-32767.f, 32767.f)) + 0.5) / 32767.0, v = (floor(rnd(-32767.f, 32767.f)) + 0.5) / 32767.0;
+        double z = 1 - fabs(u) - fabs(v), t = z < 0 ? -z : 0;
+        double x = u - copysign(t, u), y = v - copysign(t, v), l = sqrt(x * x + y * y + z * z);
+        n.push_back(vec3((float)(x / l), (float)(y / l), (float)(z / l)));
+    }
+    std::vector<octnormal> op(n.size());
+    std::vector<vec3> on(n.size());
+    pack(n, op);
+    unpack(op, on);
+    double worst = 0;
+    for (size_t i = 0; i < n.size(); i++) {
+        octnormal single = octnormal::fromVec3(n[i]);
+        CHECK(single.u == op[i].u && single.v == op[i].v, "octnormal: pack and fromVec3 differ for %.9g %.9g %.9g", n[i].x, n[i].y, n[i].z);
+        double a = angle(n[i], on[i]);
+        worst = a > worst ? a : worst;
+        float l = sqrtf(on[i].x * on[i].x + on[i].y * on[i].y + on[i].z * on[i].z);
+        CHECK(fabsf(l - 1.f) <= 2e-7f, "octnormal: %.9g %.9g %.9g came back with length %.9g", n[i].x, n[i].y, n[i].z, l);
+    }
+    CHECK(worst <= 6.6e-5, "octnormal error %.6g > 6.6e-5 radians", worst);
+}
+
+/*
+    Batched solvers
+*/
+// Matrix i of the solver tests, and whether it should count as singular (see 'Singular Matrices'
+// in lina_solve.hpp). The rows get random lengths, which shouldn't change anything.
+template <int N>
+static bool solver_matrix(size_t i, float* m) {
+    bool singular = false;
+    switch (i % 7) {
+    case 0: case 1: case 2: {
+        // Well conditioned, at very different scales.
+        const float scale[3] = {1.f, 1e-5f, 1e5f};
+        fill(m, N * N);
+        for (int k = 0; k < N * N; k++) m[k] = (m[k] + (k % (N + 1) == 0 ? 10.f : 0.f)) * scale[i % 7];
+        break;
+    }
+    case 3:
+        // The last row is twice the first.
+        fill(m, N * N);
+        for (int c = 0; c < N; c++) m[(N - 1) * N + c] = 2.f * m[c];
+        singular = true;
+        break;
+    case 4: case 5: {
+        // Rows 0 and 1 at an angle of 1e-8 radians (singular) or 1e-4 (not).
+        float a = i % 7 == 4 ? 1e-8f : 1e-4f;
+        for (int k = 0; k < N * N; k++) m[k] = k % (N + 1) == 0 ? 1.f : 0.f;
+        m[N] = cosf(a);
+        m[N + 1] = sinf(a);
+        singular = i % 7 == 4;
+        break;
+    }
+    default:
+        fill(m, N * N);
+        m[i % (N * N)] = (i / 7) % 2 ? INFINITY : NAN;
+        singular = true;
+    }
+    for (int r = 0; r < N; r++) {
+        float l = rnd(0.5f, 4.f);
+        for (int c = 0; c < N; c++) m[r * N + c] *= l;
+    }
+    return singular;
+}
+
+template <int N>
+static void test_solver() {
+    typedef typename MatStream<N>::value_type M;
+    // Not a multiple of 32 or of the SIMD width, so the last mask word and the last batch are partial.
+    const size_t n = 77;
+    MatStream<N> a;
+    VecStream<N> b;
+    a.resize(n);
+    b.resize(n);
+    bool expected[n];
+    for (size_t i = 0; i < n; i++) {
+        M m;
+        expected[i] = solver_matrix<N>(i, m.data());
+        a.set(i, m);
+        for (int k = 0; k < N; k++) b.component(k)[i] = rnd();
+    }
+
+    MatStream<N> inv;
+    VecStream<N> x;
+    FloatStream det;
+    // Every bit set, so the ones after the last matrix have to be cleared.
+    std::vector<uint32_t> inv_mask(solveMaskSize(n), ~0u), solve_mask(solveMaskSize(n), ~0u);
+    inverse(a, inv, inv_mask);
+    solve(a, b, x, solve_mask);
+    determinant(a, det);
+    CHECK(inv_mask.back() >> (n % 32) == 0 && solve_mask.back() >> (n % 32) == 0, "mat%d: mask bits after the last matrix are set", N);
+
+    for (size_t i = 0; i < n; i++) {
+        bool inv_bit = (inv_mask[i / 32] >> (i % 32)) & 1, solve_bit = (solve_mask[i / 32] >> (i % 32)) & 1;
+        CHECK(inv_bit == expected[i] && solve_bit == expected[i], "mat%d %zu (kind %zu): inverse flagged %d, solve flagged %d, expected %d",
+              N, i, i % 7, (int)inv_bit, (int)solve_bit, (int)expected[i]);
+        M m = a.get(i), r = inv.get(i);
+        const float* pm = m.data();
+        const float* pr = r.data();
+        if (expected[i]) {
+            bool zero = true;
+            for (int k = 0; k < N * N; k++) zero = zero && pr[k] == 0.f;
+            for (int k = 0; k < N; k++) zero = zero && x.component(k)[i] == 0.f;
+            CHECK(zero, "mat%d %zu: the singular results aren't zeros", N, i);
+            continue;
+        }
+
+        // Backward errors, m * inverse - identity and m * x - b, relative to the size of m.
+        double nm = 0, nr = 0, nx = 0, nb = 0, einv = 0, ex = 0;
+        for (int k = 0; k < N * N; k++) {
+            nm += (double)pm[k] * pm[k];
+            nr += (double)pr[k] * pr[k];
+        }
+        for (int k = 0; k < N; k++) {
+            nx += (double)x.component(k)[i] * x.component(k)[i];
+            nb += (double)b.component(k)[i] * b.component(k)[i];
+        }
+        for (int r0 = 0; r0 < N; r0++) {
+            double ax = -(double)b.component(r0)[i];
+            for (int c = 0; c < N; c++) {
+                double e = r0 == c ? -1.0 : 0.0;
+                for (int k = 0; k < N; k++) e += (double)pm[r0 * N + k] * pr[k * N + c];
+                einv = fabs(e) > einv ? fabs(e) : einv;
+                ax += (double)pm[r0 * N + c] * x.component(c)[i];
+            }
+            ex = fabs(ax) > ex ? fabs(ax) : ex;
+        }
+        CHECK(einv <= 1e-5 * sqrt(nm * nr), "mat%d %zu: |m * inverse - I| = %g", N, i, einv);
+        CHECK(ex <= 1e-5 * (sqrt(nm * nx) + sqrt(nb)), "mat%d %zu: |m * x - b| = %g", N, i, ex);
+
+        // The determinant in double, relative to the biggest it could be for these row lengths.
+        double rows = 1, exact = 0;
+        for (int r0 = 0; r0 < N; r0++) {
+            double l = 0;
+            for (int c = 0; c < N; c++) l += (double)pm[r0 * N + c] * pm[r0 * N + c];
+            rows *= sqrt(l);
+        }
+        if (N == 3) {
+            exact = pm[0] * ((double)pm[4] * pm[8] - (double)pm[5] * pm[7]) - pm[1] * ((double)pm[3] * pm[8] - (double)pm[5] * pm[6])
+                  + pm[2] * ((double)pm[3] * pm[7] - (double)pm[4] * pm[6]);
+        } else {
+            // Expansion along the first row, with the 3x3 minors.
+            for (int c = 0; c < 4; c++) {
+                double s3[9];
+                for (int r0 = 1, k = 0; r0 < 4; r0++)
+                    for (int c0 = 0; c0 < 4; c0++)
+                        if (c0 != c) s3[k++] = pm[r0 * 4 + c0];
+                double minor = s3[0] * (s3[4] * s3[8] - s3[5] * s3[7]) - s3[1] * (s3[3] * s3[8] - s3[5] * s3[6]) + s3[2] * (s3[3] * s3[7] - s3[4] * s3[6]);
+                exact += (c % 2 ? -1.0 : 1.0) * pm[c] * minor;
+            }
+        }
+        CHECK(fabs(det.x()[i] - exact) <= 1e-6 * rows, "mat%d %zu: determinant %.9g, should be %.9g", N, i, det.x()[i], exact);
+    }
+
+    // Without a mask the results are the same.
+    MatStream<N> inv2;
+    inverse(a, inv2);
+    for (size_t i = 0; i < n; i++) {
+        M r = inv.get(i), r2 = inv2.get(i);
+        CHECK(memcmp(r.data(), r2.data(), sizeof(float) * N * N) == 0, "mat%d %zu: inverse without a mask differs", N, i);
+    }
+}
+
+// A random rotation, from a random unit quaternion.
+static mat3 random_rotation() {
+    float q[4];
+    fill(q, 4);
+    float l = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    float x = q[0] / l, y = q[1] / l, z = q[2] / l, w = q[3] / l;
+    return mat3(1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+                2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+                2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y));
+}
+
+// The largest element of |a * b^T - c| (or a^T * b - c), and the Frobenius norm of a.
+static double residual3(const float* a, const float* b, const float* c, bool transpose_a) {
+    double worst = 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+            double e = -(double)c[i * 3 + j];
+            for (int k = 0; k < 3; k++) e += transpose_a ? (double)a[k * 3 + i] * b[k * 3 + j] : (double)a[i * 3 + k] * b[j * 3 + k];
+            worst = fabs(e) > worst ? fabs(e) : worst;
+        }
+    return worst;
+}
+static double norm3(const float* a) {
+    double n = 0;
+    for (int k = 0; k < 9; k++) n += (double)a[k] * a[k];
+    return sqrt(n);
+}
+
+static const float identity3[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+static void test_eigen() {
+    // rotation * diagonal(values) * rotation^T, with spread out, nearly equal, equal and negative values.
+    const size_t n = 203;
+    Mat3Stream a;
+    a.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        float d[3] = {rnd(), rnd(), rnd()};
+        if (i % 4 == 1) d[1] = d[0] * (1.f + 1e-6f);
+        if (i % 4 == 2) d[2] = d[1] = d[0];
+        if (i % 4 == 3) d[0] *= 1e4f;
+        mat3 r = random_rotation(), m;
+        const float* pr = r.data();
+        float* pm = m.data();
+        for (int j = 0; j < 3; j++)
+            for (int k = 0; k < 3; k++)
+                pm[j * 3 + k] = pr[j * 3] * d[0] * pr[k * 3] + pr[j * 3 + 1] * d[1] * pr[k * 3 + 1] + pr[j * 3 + 2] * d[2] * pr[k * 3 + 2];
+        // Only the upper triangle should be read.
+        pm[3] = pm[6] = pm[7] = NAN;
+        a.set(i, m);
+    }
+
+    Vec3Stream values;
+    Mat3Stream vectors;
+    eigenSymmetric(a, values, vectors);
+    for (size_t i = 0; i < n; i++) {
+        mat3 m = a.get(i), v = vectors.get(i);
+        float* pm = m.data();
+        pm[3] = pm[1]; pm[6] = pm[2]; pm[7] = pm[5];
+        const float* pv = v.data();
+        // v * diagonal(values) * v^T
+        float vd[9];
+        for (int j = 0; j < 9; j++) vd[j] = pv[j] * values.component(j % 3)[i];
+        double orth = residual3(pv, pv, identity3, true);
+        double rec = residual3(vd, pv, pm, false);
+        CHECK(orth <= 1e-6, "eigenSymmetric %zu: |v^T v - I| = %g", i, orth);
+        CHECK(rec <= 2e-6 * norm3(pm), "eigenSymmetric %zu: |a - v d v^T| = %g, |a| = %g", i, rec, norm3(pm));
+    }
+}
+
+static void test_polar() {
+    // Random matrices, rotations times a stretch of up to 10000 to 1, reflections, and flattened ones.
+    const size_t n = 203;
+    Mat3Stream a;
+    a.resize(n);
+    bool flat[n];
+    for (size_t i = 0; i < n; i++) {
+        mat3 m;
+        float* pm = m.data();
+        flat[i] = false;
+        if (i % 5 == 0) {
+            fill(pm, 9);
+        } else {
+            float s[3] = {rnd(0.5f, 2.f), rnd(0.5f, 2.f), rnd(0.5f, 2.f)};
+            // Two long axes, one long one would make the rows nearly parallel, which counts as singular.
+            if (i % 5 == 2) s[0] *= 1e4f, s[1] *= 1e4f;
+            if (i % 5 == 3) s[2] = -s[2];
+            if (i % 5 == 4) s[1] = 0.f;
+            flat[i] = s[1] == 0.f;
+            mat3 r = random_rotation(), q = random_rotation();
+            const float* pr = r.data();
+            const float* pq = q.data();
+            for (int j = 0; j < 3; j++)
+                for (int k = 0; k < 3; k++)
+                    pm[j * 3 + k] = pr[j * 3] * s[0] * pq[k] + pr[j * 3 + 1] * s[1] * pq[3 + k] + pr[j * 3 + 2] * s[2] * pq[6 + k];
+        }
+        a.set(i, m);
+    }
+
+    Mat3Stream rotation, stretch;
+    std::vector<uint32_t> singular(solveMaskSize(n));
+    polarDecompose(a, rotation, stretch, singular);
+    for (size_t i = 0; i < n; i++) {
+        bool flagged = (singular[i / 32] >> (i % 32)) & 1;
+        CHECK(flagged == flat[i], "polarDecompose %zu: flagged %d, expected %d", i, (int)flagged, (int)flat[i]);
+        if (flat[i]) continue;
+        mat3 m = a.get(i), r = rotation.get(i), st = stretch.get(i);
+        const float* pm = m.data();
+        const float* pr = r.data();
+        const float* ps = st.data();
+        double orth = residual3(pr, pr, identity3, true);
+        double det = pr[0] * ((double)pr[4] * pr[8] - (double)pr[5] * pr[7]) - pr[1] * ((double)pr[3] * pr[8] - (double)pr[5] * pr[6])
+                   + pr[2] * ((double)pr[3] * pr[7] - (double)pr[4] * pr[6]);
+        // a = r * s, so r^T a = s.
+        double rec = residual3(pr, pm, ps, true);
+        CHECK(orth <= 1e-6 && fabs(det - 1) <= 1e-6, "polarDecompose %zu: |r^T r - I| = %g, det(r) = %.9g", i, orth, det);
+        CHECK(ps[1] == ps[3] && ps[2] == ps[6] && ps[5] == ps[7], "polarDecompose %zu: the stretch isn't symmetric", i);
+        CHECK(rec <= 2e-6 * norm3(pm), "polarDecompose %zu: |r^T a - s| = %g, |a| = %g", i, rec, norm3(pm));
+    }
+}
+
+static bool cpu_supported() {
+#if LINA_SIMD_X86 && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (LINA_SIMD >= LINA_SIMD_AVX && !__builtin_cpu_supports("avx")) return false;
+    if (LINA_SIMD >= LINA_SIMD_AVX2 && !(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))) return false;
+    if (LINA_F16C && !__builtin_cpu_supports("f16c")) return false;
+#endif
+    return true;
+}
+
+int main() {
+    if (!cpu_supported()) {
+        printf("skipped, the CPU can't run LINA_SIMD %d\n", LINA_SIMD);
+        return 77;
+    }
+
+    test_products();
+    test_quaternions();
+    test_transposes();
+    test_inverses();
+    test_batch();
+    test_skin<4>();
+    test_skin<8>();
+    test_pack();
+    test_solver<3>();
+    test_solver<4>();
+    test_eigen();
+    test_polar();
+
+    printf("LINA_SIMD %d: %d failed\n", LINA_SIMD, failures);
+    return failures ? 1 : 0;
+}